@@ -0,0 +1,488 @@
+//
+// editor_bench.cpp - Headless benchmarks for the editor core
+//
+// Runs GapBuffer edit patterns, search, word counting, word wrapping and file
+// load/save over generated corpora and reports throughput and heap allocations
+// per case.
+//
+//   editor_bench [--max-size=64M] [--filter=name] [--csv]
+//
+// Corpora grow 4x from 1 KB up to --max-size (default 64 MB; pass 1G for the
+// full range).
+//
+
+#include "AllocationCounter.h"
+#include "AsyncFileLoader.h"
+#include "AsyncFileSaver.h"
+#include "GapBuffer.h"
+#include "LargeFileView.h"
+#include "MultiCursor.h"
+#include "SyntaxHighlighter.h"
+#include "TextMetrics.h"
+#include "TextSearch.h"
+#include "WrapLayout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// --- Corpus ------------------------------------------------------------------
+
+// Prose-like text: words of 1-12 letters, ~1 in 12 lines blank, a sprinkling of
+// multi-byte characters so UTF-8 paths are exercised
+std::string generateCorpus(std::size_t bytes, std::uint32_t seed) {
+    static const char* extras[] = {"\xC3\xA9", "\xC3\xBC", "\xE4\xB8\xAD", "\xF0\x9F\x99\x82"};
+    std::mt19937 rng(seed);
+    std::string text;
+    text.reserve(bytes + 16);
+
+    std::size_t lineLength = 0;
+    while (text.size() < bytes) {
+        std::size_t wordLength = 1 + rng() % 12;
+        for (std::size_t i = 0; i < wordLength; i++) {
+            text += static_cast<char>('a' + rng() % 26);
+        }
+        if (rng() % 40 == 0) {
+            text += extras[rng() % 4];
+        }
+        lineLength += wordLength + 1;
+        if (lineLength > 60 + rng() % 40) {
+            text += '\n';
+            if (rng() % 12 == 0) text += '\n';
+            lineLength = 0;
+        } else {
+            text += ' ';
+        }
+    }
+    text.resize(bytes);
+    // Don't end on a split code point
+    while (!text.empty() && (static_cast<unsigned char>(text.back()) & 0xC0) == 0x80) {
+        text.back() = 'x';
+    }
+    if (!text.empty() && static_cast<unsigned char>(text.back()) >= 0xC0) {
+        text.back() = 'x';
+    }
+    return text;
+}
+
+std::string formatSize(std::size_t bytes) {
+    const char* units[] = {"B", "KB", "MB", "GB"};
+    int unit = 0;
+    double value = static_cast<double>(bytes);
+    while (value >= 1024.0 && unit < 3) {
+        value /= 1024.0;
+        unit++;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.0f %s", value, units[unit]);
+    return buffer;
+}
+
+std::size_t parseSize(const std::string& text) {
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    switch (end && *end ? *end : 'B') {
+        case 'k': case 'K': value *= 1024.0; break;
+        case 'm': case 'M': value *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': value *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return static_cast<std::size_t>(value);
+}
+
+// --- Harness -----------------------------------------------------------------
+
+struct Options {
+    std::size_t maxSize = 64ull * 1024 * 1024;
+    std::string filter;
+    bool csv = false;
+};
+
+struct Measurement {
+    double seconds;
+    std::uint64_t allocations;
+    std::uint64_t bytesAllocated;
+};
+
+// Results are folded in here so the optimizer cannot drop the measured work
+volatile std::size_t sink = 0;
+
+Measurement measure(const std::function<void()>& work) {
+    std::uint64_t allocsBefore = allocationCount();
+    std::uint64_t bytesBefore = allocatedBytes();
+    auto start = std::chrono::steady_clock::now();
+    work();
+    auto stop = std::chrono::steady_clock::now();
+    return {std::chrono::duration<double>(stop - start).count(),
+            allocationCount() - allocsBefore,
+            allocatedBytes() - bytesBefore};
+}
+
+void report(const Options& options, const std::string& name, std::size_t corpusBytes,
+            std::size_t processedBytes, std::uint64_t operations, const Measurement& m) {
+    double mbPerSecond = m.seconds > 0 ? static_cast<double>(processedBytes) / m.seconds / (1024.0 * 1024.0) : 0.0;
+    double opsPerSecond = m.seconds > 0 ? static_cast<double>(operations) / m.seconds : 0.0;
+
+    if (options.csv) {
+        std::printf("%s,%zu,%.6f,%.2f,%.0f,%llu,%llu\n", name.c_str(), corpusBytes, m.seconds,
+                    mbPerSecond, opsPerSecond,
+                    static_cast<unsigned long long>(m.allocations),
+                    static_cast<unsigned long long>(m.bytesAllocated));
+        return;
+    }
+
+    char throughput[48];
+    if (operations > 0) {
+        std::snprintf(throughput, sizeof(throughput), "%12.0f ops/s", opsPerSecond);
+    } else if (mbPerSecond >= 1024.0) {
+        std::snprintf(throughput, sizeof(throughput), "%10.2f GB/s", mbPerSecond / 1024.0);
+    } else {
+        std::snprintf(throughput, sizeof(throughput), "%10.1f MB/s", mbPerSecond);
+    }
+    std::printf("%-22s %8s %10.3f ms %s %10llu allocs %10s\n", name.c_str(),
+                formatSize(corpusBytes).c_str(), m.seconds * 1000.0, throughput,
+                static_cast<unsigned long long>(m.allocations),
+                formatSize(m.bytesAllocated).c_str());
+}
+
+bool selected(const Options& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+GapBuffer bufferWith(const std::string& corpus) {
+    GapBuffer buffer;
+    buffer.reserve(corpus.size());
+    buffer.insertString(corpus);
+    return buffer;
+}
+
+// --- Benchmarks --------------------------------------------------------------
+
+void runCorpus(const Options& options, const std::string& corpus, const std::string& tempDir) {
+    const std::size_t size = corpus.size();
+    std::mt19937 rng(42);
+
+    if (selected(options, "buffer.append")) {
+        // Load path: 4 KB chunks appended at the end
+        Measurement m = measure([&] {
+            GapBuffer buffer;
+            const std::size_t chunk = 4096;
+            for (std::size_t pos = 0; pos < size; pos += chunk) {
+                buffer.insertString(corpus.substr(pos, chunk));
+            }
+        });
+        report(options, "buffer.append", size, size, 0, m);
+    }
+
+    if (selected(options, "buffer.typing")) {
+        // Keystrokes at one cursor in the middle of the document
+        GapBuffer buffer = bufferWith(corpus);
+        buffer.moveTo(size / 2);
+        const std::uint64_t keys = 100000;
+        Measurement m = measure([&] {
+            for (std::uint64_t i = 0; i < keys; i++) {
+                buffer.insert(static_cast<char>('a' + i % 26));
+                if (i % 8 == 7) buffer.backspace();
+            }
+        });
+        report(options, "buffer.typing", size, 0, keys, m);
+    }
+
+    if (selected(options, "buffer.random_edits")) {
+        // Jump somewhere, insert a word, delete a few bytes
+        GapBuffer buffer = bufferWith(corpus);
+        const std::uint64_t edits = size >= (256u << 20) ? 200 : 2000;
+        const std::string word = "edit ";
+        Measurement m = measure([&] {
+            for (std::uint64_t i = 0; i < edits; i++) {
+                std::size_t pos = rng() % (buffer.size() + 1);
+                buffer.moveTo(pos);
+                buffer.insertString(word);
+                buffer.deleteRange(pos, std::min(buffer.size(), pos + 3));
+            }
+        });
+        report(options, "buffer.random_edits", size, 0, edits, m);
+    }
+
+    if (selected(options, "buffer.multi_cursor") || selected(options, "buffer.multi_seq")) {
+        // Typing at 64 cursors spread over the document: one batched pass per
+        // keystroke, against moving the gap to each cursor in turn
+        const std::size_t cursorCount = 64;
+        const std::uint64_t keys = size >= (64u << 20) ? 20 : 200;
+        const std::string key = "x";
+
+        if (selected(options, "buffer.multi_cursor")) {
+            GapBuffer buffer = bufferWith(corpus);
+            int anchor = -1;
+            std::vector<Caret> carets;
+            for (std::size_t i = 0; i < cursorCount; i++) {
+                addCaret(buffer, anchor, carets, size / cursorCount * i);
+            }
+            Measurement m = measure([&] {
+                for (std::uint64_t i = 0; i < keys; i++) {
+                    insertAtCarets(buffer, anchor, carets, key);
+                }
+            });
+            report(options, "buffer.multi_cursor", size, 0, keys * cursorCount, m);
+        }
+
+        if (selected(options, "buffer.multi_seq")) {
+            GapBuffer buffer = bufferWith(corpus);
+            std::vector<std::size_t> positions;
+            for (std::size_t i = 0; i < cursorCount; i++) {
+                positions.push_back(size / cursorCount * i);
+            }
+            Measurement m = measure([&] {
+                for (std::uint64_t i = 0; i < keys; i++) {
+                    // Back to front, so earlier positions stay valid; each
+                    // keystroke still sweeps the gap across the document
+                    for (std::size_t c = positions.size(); c-- > 0;) {
+                        buffer.moveTo(positions[c] + c * i);
+                        buffer.insertString(key);
+                    }
+                }
+            });
+            report(options, "buffer.multi_seq", size, 0, keys * cursorCount, m);
+        }
+    }
+
+    if (selected(options, "highlight.full")) {
+        // Every line tokenized from scratch, as when a file is first shown at its end
+        GapBuffer buffer = bufferWith(corpus);
+        SyntaxHighlighter highlighter;
+        highlighter.setLanguage(Language::Log);
+        Measurement m = measure([&] {
+            highlighter.update(buffer, static_cast<std::size_t>(-1));
+        });
+        report(options, "highlight.full", size, size, 0, m);
+    }
+
+    if (selected(options, "highlight.edit")) {
+        // Typing in the middle of a tokenized document; each keystroke
+        // re-tokenizes only until the line states converge
+        GapBuffer buffer = bufferWith(corpus);
+        SyntaxHighlighter highlighter;
+        highlighter.setLanguage(Language::Log);
+        buffer.setEditObserver([&](const GapBuffer::Edit& edit) { highlighter.noteEdit(buffer, edit); });
+        highlighter.update(buffer, static_cast<std::size_t>(-1));
+        buffer.moveTo(size / 2);
+        const std::uint64_t keys = 1000;
+        buffer.reserve(keys);
+        Measurement m = measure([&] {
+            for (std::uint64_t i = 0; i < keys; i++) {
+                buffer.insertString("x");
+                highlighter.update(buffer, static_cast<std::size_t>(-1));
+            }
+        });
+        report(options, "highlight.edit", size, 0, keys, m);
+    }
+
+    if (selected(options, "buffer.move_sweep")) {
+        // Gap walks through the whole document in 64 steps and back
+        GapBuffer buffer = bufferWith(corpus);
+        const std::uint64_t steps = 128;
+        Measurement m = measure([&] {
+            for (std::uint64_t i = 0; i < steps; i++) {
+                std::size_t step = i < 64 ? i : 127 - i;
+                buffer.moveTo(size * step / 63);
+            }
+        });
+        report(options, "buffer.move_sweep", size, size * 2, 0, m);
+    }
+
+    if (selected(options, "buffer.cp_index")) {
+        // Byte <-> code point conversions as the renderer does per frame
+        GapBuffer buffer = bufferWith(corpus);
+        buffer.moveTo(size / 3);
+        const std::uint64_t queries = 100000;
+        Measurement m = measure([&] {
+            std::size_t total = 0;
+            for (std::uint64_t i = 0; i < queries; i++) {
+                total += buffer.codePointIndex(rng() % (size + 1));
+            }
+            sink = total;
+        });
+        report(options, "buffer.cp_index", size, 0, queries, m);
+    }
+
+    if (selected(options, "buffer.range_stats")) {
+        // Selection statistics over random ranges, as the status bar shows them
+        GapBuffer buffer = bufferWith(corpus);
+        buffer.moveTo(size / 3);
+        const std::uint64_t queries = 100000;
+        Measurement m = measure([&] {
+            std::size_t total = 0;
+            for (std::uint64_t i = 0; i < queries; i++) {
+                std::size_t a = rng() % (size + 1);
+                std::size_t b = rng() % (size + 1);
+                ChunkSummary stats = buffer.statistics(std::min(a, b), std::max(a, b));
+                total += stats.wordStarts + stats.newlines;
+            }
+            sink = total;
+        });
+        report(options, "buffer.range_stats", size, 0, queries, m);
+    }
+
+    if (selected(options, "search.find_all")) {
+        Measurement m = measure([&] { sink = findAllMatches(corpus, "The").size(); });
+        report(options, "search.find_all", size, size, 0, m);
+    }
+
+    if (selected(options, "metrics.words_lines")) {
+        Measurement m = measure([&] { sink = countWords(corpus) + countLines(corpus); });
+        report(options, "metrics.words_lines", size, size, 0, m);
+    }
+
+    if (selected(options, "metrics.count_text")) {
+        // Fused single pass, as the status bar recounts after an edit
+        Measurement m = measure([&] {
+            TextCounts counts = countText(corpus);
+            sink = counts.wordStarts + counts.newlines;
+        });
+        report(options, "metrics.count_text", size, size, 0, m);
+    }
+
+    if (selected(options, "metrics.count_scalar")) {
+        Measurement m = measure([&] {
+            TextCounts counts = countTextScalar(corpus);
+            sink = counts.wordStarts + counts.newlines;
+        });
+        report(options, "metrics.count_scalar", size, size, 0, m);
+    }
+
+    if (selected(options, "wrap.layout")) {
+        // Full re-wrap at an 80-column window, as after a resize. The layout and
+        // arena are warm from a previous frame, as they are in the editor.
+        GapBuffer buffer = bufferWith(corpus);
+        buffer.moveTo(size / 2);
+        MonospaceWidthProvider widths;
+        FrameArena arena;
+        DisplayState state;
+        wrapLayout(buffer.spans(), buffer.getGapStart(), widths, 80.f, state, arena);
+        Measurement m = measure([&] {
+            arena.reset();
+            wrapLayout(buffer.spans(), buffer.getGapStart(), widths, 80.f, state, arena);
+            sink = state.lineStarts.size();
+        });
+        report(options, "wrap.layout", size, size, 0, m);
+    }
+
+    std::string path = tempDir + "/bench_" + std::to_string(size) + ".txt";
+
+    if (selected(options, "file.save") || selected(options, "file.load") || selected(options, "file.load_moving") ||
+        selected(options, "file.index")) {
+        GapBuffer buffer = bufferWith(corpus);
+        buffer.moveTo(size / 2); // snapshot with both halves populated
+        Measurement m = measure([&] { AsyncFileSaver::writeSnapshot(path, buffer.snapshot()); });
+        if (selected(options, "file.save")) report(options, "file.save", size, size, 0, m);
+    }
+
+    if (selected(options, "file.load")) {
+        Measurement m = measure([&] {
+            AsyncFileLoader loader;
+            GapBuffer buffer;
+            if (!loader.start(path)) return;
+            buffer.reserve(loader.getTotalBytes());
+            std::vector<std::string> chunks;
+            bool finished = false;
+            while (!finished) {
+                chunks.clear();
+                finished = loader.poll(chunks);
+                for (const std::string& chunk : chunks) {
+                    buffer.append(chunk);
+                }
+                if (!finished && chunks.empty()) std::this_thread::yield();
+            }
+        });
+        report(options, "file.load", size, size, 0, m);
+    }
+
+    if (selected(options, "file.load_moving")) {
+        // The cursor jumps around between chunks, as clicks and searches do
+        // while a file loads; the text must still arrive in file order
+        GapBuffer buffer;
+        Measurement m = measure([&] {
+            AsyncFileLoader loader;
+            if (!loader.start(path)) return;
+            buffer.reserve(loader.getTotalBytes());
+            std::vector<std::string> chunks;
+            bool finished = false;
+            while (!finished) {
+                chunks.clear();
+                finished = loader.poll(chunks);
+                for (const std::string& chunk : chunks) {
+                    buffer.moveTo(rng() % (buffer.size() + 1));
+                    buffer.append(chunk);
+                }
+                if (!finished && chunks.empty()) std::this_thread::yield();
+            }
+        });
+        if (buffer.getString() != corpus) {
+            std::fprintf(stderr, "file.load_moving: loaded text differs from the file\n");
+            std::exit(1);
+        }
+        report(options, "file.load_moving", size, size, 0, m);
+    }
+
+    if (selected(options, "file.index")) {
+        // Large-file indexing (lines, words, UTF-8 check) on one thread and on
+        // every core; the file is in the page cache from the cases above
+        std::vector<unsigned int> threadCounts = {1};
+        unsigned int cores = std::thread::hardware_concurrency();
+        if (cores > 1) threadCounts.push_back(cores);
+        for (unsigned int threads : threadCounts) {
+            LargeFileView view;
+            Measurement m = measure([&] {
+                if (!view.open(path, threads)) return;
+                while (view.isIndexing()) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+                sink = view.getWordCount();
+            });
+            report(options, "file.index/" + std::to_string(threads) + "t", size, size, 0, m);
+        }
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--max-size=", 0) == 0) {
+            options.maxSize = parseSize(arg.substr(11));
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            options.filter = arg.substr(9);
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [--max-size=64M] [--filter=name] [--csv]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::string tempDir = std::filesystem::temp_directory_path().string();
+    if (options.csv) {
+        std::printf("benchmark,corpus_bytes,seconds,mb_per_s,ops_per_s,allocations,bytes_allocated\n");
+    }
+
+    for (std::size_t size = 1024; size <= options.maxSize; size *= 4) {
+        std::string corpus = generateCorpus(size, static_cast<std::uint32_t>(size));
+        runCorpus(options, corpus, tempDir);
+    }
+    return 0;
+}
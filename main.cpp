@@ -1,29 +1,109 @@
-#include <nfd.h>
 #include <SFML/Graphics.hpp>
 #include "src/GapBuffer.h"
 #include "src/UI.h"
 #include "src/Scrollbar.h"
+#include "src/BatchedText.h"
 #include "src/TextRenderer.h"
 #include "src/FileOperations.h"
+#include "src/FileDialogs.h"
 #include "src/InputHandler.h"
 #include "src/SearchDialog.h"
 #include "src/StatusBar.h"
+#include "src/Utf8.h"
+#include "src/LargeFileView.h"
+#include "src/AsyncFileLoader.h"
+#include "src/AsyncFileSaver.h"
+#include "src/EditJournal.h"
+#include "src/FrameProfiler.h"
+#include "src/AllocationCounter.h"
+#include "src/ProfilerOverlay.h"
+#include "src/EditCommands.h"
+#include "src/MultiCursor.h"
+#include "src/ColumnSelection.h"
+#include "src/SyntaxHighlighter.h"
+#include "src/InputTrace.h"
+#include "src/EventTrace.h"
+#include "src/LatencyTracker.h"
+#include "src/FrameArena.h"
+#include "src/FontCache.h"
+#include "src/DocumentSet.h"
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <cmath>
+#include <cstdio>
 
-int main() {
+int main(int argc, char** argv) {
     const float TOP_MARGIN = 50.0f;
     const float SCROLL_PADDING = 10.f;
     const float DRAG_THRESHOLD = 5.0f;
     const sf::Time CURSOR_BLINK_INTERVAL = sf::milliseconds(500);
 
+    // --record <trace> writes every input event to a file; --replay <trace>
+    // feeds one back in at its recorded pace and prints per-event latency.
+    // --latency-log <csv> logs keystroke-to-frame latency and --latency-budget
+    // <ms> sets the budget it is checked against (a replay over it exits 1).
+    // --memory-budget <MB> caps what the open documents may hold in memory.
+    InputTraceWriter traceWriter;
+    std::vector<TraceEvent> replayEvents;
+    LatencyTracker latency;
+    // Every open tab but the active one is parked here
+    DocumentSet documents;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--latency-log") {
+            if (!latency.openLog(argv[i + 1])) {
+                std::cerr << "Could not write latency log " << argv[i + 1] << "\n";
+                return 1;
+            }
+        } else if (option == "--latency-budget") {
+            latency.setBudgetMs(std::atof(argv[i + 1]));
+        } else if (option == "--record") {
+            if (!traceWriter.open(argv[i + 1])) {
+                std::cerr << "Could not write trace " << argv[i + 1] << "\n";
+                return 1;
+            }
+        } else if (option == "--replay") {
+            if (!readInputTrace(argv[i + 1], replayEvents)) {
+                std::cerr << "Could not read trace " << argv[i + 1] << "\n";
+                return 1;
+            }
+        } else if (option == "--memory-budget") {
+            documents.setBudget(static_cast<std::size_t>(std::strtoull(argv[i + 1], nullptr, 10)) * 1024 * 1024);
+        }
+    }
+    bool replaying = !replayEvents.empty();
+
     sf::RenderWindow window(sf::VideoMode({800, 1000}), "Text Editor");
     std::string currentFileName = "Untitled";
     bool unsavedChanges = false;
     bool showCloseConfirm = false;
 
+    // Files over LargeFileView::THRESHOLD are viewed read-only through a mapping
+    LargeFileView largeFile;
+    // Smaller files stream in on a worker thread; the document is read-only until done
+    AsyncFileLoader fileLoader;
+
+    auto isReadOnly = [&]() {
+        return largeFile.isOpen() || fileLoader.isActive();
+    };
+
+    // Set whenever the active document's name or modified state may have
+    // changed; the tab labels are rebuilt from it before the next draw
+    bool tabsStale = true;
+    // Colours come from token runs kept per line and updated as the text is edited
+    SyntaxHighlighter highlighter;
+    std::vector<BatchedText::ColorSpan> colorSpans;
+
     auto updateWindowTitle = [&]() {
-        if (unsavedChanges) {
+        tabsStale = true;
+        // The name decides the language, whether it was opened, saved as or restored
+        highlighter.setLanguage(languageForPath(currentFileName));
+        if (fileLoader.isActive()) {
+            window.setTitle("Text Editor - " + currentFileName + " (loading...)");
+        } else if (largeFile.isOpen()) {
+            window.setTitle("Text Editor - " + currentFileName + " (read-only)");
+        } else if (unsavedChanges) {
             window.setTitle("Text Editor - " + currentFileName + " *");
         } else {
             window.setTitle("Text Editor - " + currentFileName);
@@ -34,13 +114,18 @@ int main() {
     sf::View textView = window.getDefaultView();
     window.setFramerateLimit(60);
 
-    sf::Font font;
-    if (!font.openFromFile("fonts/Roboto.ttf")) return 1;
+    // One font shared by every widget; its glyphs are rasterized up front for
+    // the sizes the editor, status bar, menus and overlay use
+    FontCache fontCache;
+    const sf::Font* loadedFont = fontCache.get("fonts/Roboto.ttf");
+    if (!loadedFont) return 1;
+    const sf::Font& font = *loadedFont;
+    fontCache.prewarm(font, {12, 13, 14, 15, 16, 18, 24});
 
     // ── Theme ────────────────────────────────────────────────────────────────
     Theme theme;  // starts dark
 
-    sf::Text text(font);
+    BatchedText text(font);
     text.setCharacterSize(24);
     text.setFillColor(sf::Color::White);
     text.setPosition({0, TOP_MARGIN});
@@ -49,6 +134,49 @@ int main() {
     cursor.setFillColor(sf::Color::White);
 
     GapBuffer gapBuffer;
+
+    // Every edit is appended to a sidecar journal so a crash loses at most the
+    // last second of typing. Untitled documents are told apart by an id that
+    // names their journal, so each tab's survives on its own.
+    EditJournal journal;
+    unsigned untitledId = 0;
+    unsigned nextUntitledId = 0;
+    auto beginJournal = [&](bool matchesDisk) {
+        if (currentFileName == "Untitled") {
+            // Ids whose journals another running instance holds are skipped
+            while (!journal.beginUntitled(untitledId, gapBuffer)) {
+                untitledId = nextUntitledId++;
+            }
+        } else {
+            // Left unjournaled when another instance is editing the same file
+            journal.begin(currentFileName, gapBuffer, matchesDisk);
+        }
+    };
+
+    // Ctrl+\ splits the text area into two panes over the same document and
+    // the same layout; each has its own scroll offset, view and cursor. The
+    // focused pane's state is the live one (the gap is its cursor), the other
+    // pane's is parked here and carried along by every edit.
+    struct SplitPane {
+        size_t cursor = 0;
+        int selectionAnchor = -1;
+        float scrollOffset = 0.f;
+    };
+    bool splitView = false;
+    bool bottomFocused = false;
+    SplitPane otherPane;
+
+    gapBuffer.setEditObserver([&](const GapBuffer::Edit& edit) {
+        journal.record(edit);
+        highlighter.noteEdit(gapBuffer, edit);
+        if (splitView) {
+            otherPane.cursor = rebaseOffset(otherPane.cursor, edit);
+            if (otherPane.selectionAnchor != -1) {
+                otherPane.selectionAnchor = static_cast<int>(
+                    rebaseOffset(static_cast<size_t>(otherPane.selectionAnchor), edit));
+            }
+        }
+    });
     Scrollbar scrollbar(SCROLL_PADDING);
     SearchDialog searchDialog(font);
     StatusBar statusBar(font, static_cast<float>(window.getSize().x));
@@ -61,6 +189,9 @@ int main() {
         {"Exit",    ""},
     });
 
+    // Tabs fill the header between the buttons on the left and the font size
+    TabBar tabBar(font);
+
     // Search button (next to the File dropdown)
     Button searchBtn(font);
     searchBtn.shape.setSize(sf::Vector2f(80.f, 30.f));
@@ -99,6 +230,7 @@ int main() {
         cursor.setFillColor(theme.cursorColor());
         fileMenu.applyTheme(theme);
         scrollbar.applyTheme(theme.isDark);
+        tabBar.applyTheme(theme);
     };
 
     auto updateThemeToggleAppearance = [&]() {
@@ -133,22 +265,27 @@ int main() {
         float xPos = static_cast<float>(window.getSize().x) - 152.f; // 140 width + 12 scrollbar
         textSize.shape.setPosition(sf::Vector2f(xPos, 10));
         textSize.text.setPosition(sf::Vector2f(xPos + 10, 12));
+        tabBar.setArea(sf::Vector2f(260.f, 10.f), std::max(0.f, xPos - 10.f - 260.f));
     };
     updateTextSizeButtonPosition();
 
+    // Saves write a snapshot on a background thread. unsavedChanges is only
+    // cleared once the write for the current buffer version has been fsync'd.
+    AsyncFileSaver fileSaver;
+
+    auto startSave = [&](const std::string& path) {
+        fileSaver.save(path, gapBuffer.snapshot());
+        currentFileName = path;
+        statusBar.setMessage("Saving...");
+        updateWindowTitle();
+    };
+
     auto performSave = [&]() {
-        std::string savedFile;
-        //Save as
-        if (currentFileName == "Untitled") {
-            savedFile = saveToFile(gapBuffer, "");
-        }
-        else {
-            savedFile = saveToFile(gapBuffer, currentFileName);
-        }
-        if (!savedFile.empty()) {
-            currentFileName = savedFile;
-            unsavedChanges = false;
-            updateWindowTitle();
+        if (isReadOnly()) return;
+        //Save as when the document has no file yet
+        std::string path = resolveSavePath(currentFileName == "Untitled" ? "" : currentFileName);
+        if (!path.empty()) {
+            startSave(path);
         }
     };
 
@@ -158,485 +295,1012 @@ int main() {
     MouseState mouseState = MouseState::Idle;
     sf::Vector2i mousePressPos;
     int selectionAnchor = -1;
+    // Alt+click adds cursors; edits and Left/Right then apply at all of them
+    std::vector<Caret> carets;
     std::string clipboard = ""; // Internal clipboard storage
+    bool clipboardIsBlock = false; // Clipboard holds the selections of several cursors
 
     // --- File operation helpers ---
     auto performNew = [&]() {
+        fileLoader.cancel();
+        largeFile.close();
+        journal.discard();
+        statusBar.setMessage("");
         gapBuffer.clear();
         currentFileName = "Untitled";
+        untitledId = nextUntitledId++;
+        beginJournal(false);
         unsavedChanges = false;
         selectionAnchor = -1;
+        carets.clear();
         scrollbar.setScrollOffset(0.f);
         updateWindowTitle();
     };
 
     auto performSaveAs = [&]() {
-        std::string savedFile = saveToFile(gapBuffer, "");
-        if (!savedFile.empty()) {
-            currentFileName = savedFile;
+        if (isReadOnly()) return;
+        std::string path = resolveSavePath("");
+        if (!path.empty()) {
+            startSave(path);
+        }
+    };
+
+    auto openPath = [&](const std::string& path) {
+        fileLoader.cancel();
+        carets.clear();
+        journal.discard();
+
+        // Huge files are mapped and paged in on demand instead of read into the buffer
+        if (fileSizeOf(path) >= LargeFileView::THRESHOLD) {
+            if (largeFile.open(path)) {
+                gapBuffer.clear();
+                currentFileName = path;
+                unsavedChanges = false;
+                selectionAnchor = -1;
+                scrollbar.setScrollOffset(0.f);
+                updateWindowTitle();
+            }
+            return;
+        }
+
+        // Everything else streams in; the main loop appends chunks as they arrive
+        if (fileLoader.start(path)) {
+            largeFile.close();
+            gapBuffer.clear();
+            gapBuffer.reserve(fileLoader.getTotalBytes());
+            currentFileName = path;
             unsavedChanges = false;
+            selectionAnchor = -1;
+            scrollbar.setScrollOffset(0.f);
             updateWindowTitle();
         }
     };
 
-    auto performOpen = [&]() {
-        std::string loadedFile = loadFromFile(gapBuffer);
-        if (!loadedFile.empty()) {
-            currentFileName = loadedFile;
-            unsavedChanges = false;
+    // --- Tabs ---
+    // The active document lives in the variables above; switching tabs parks
+    // it in `documents` and restores another. A parked document keeps its text
+    // (sharing the buffer's storage, no copy) until the memory budget compacts
+    // or evicts it. A modified document's journal stays on disk while parked.
+    auto parkActive = [&]() {
+        DocumentSet::Document current;
+        current.path = currentFileName;
+        current.untitledId = untitledId;
+        current.modified = unsavedChanges;
+        current.largeFile = largeFile.isOpen();
+        current.cursor = gapBuffer.getGapStart();
+        current.selectionAnchor = selectionAnchor;
+        current.scrollOffset = scrollbar.getScrollOffset();
+        // A half-loaded document is read again from the start
+        if (!largeFile.isOpen() && !fileLoader.isActive()) {
+            current.text = gapBuffer.snapshot();
+        }
+
+        if (unsavedChanges) {
+            journal.suspend();
+        } else {
+            journal.discard();
+        }
+        fileLoader.cancel();
+        largeFile.close();
+        return current;
+    };
+
+    auto restoreActive = [&](DocumentSet::Document document) {
+        statusBar.setMessage("");
+        otherPane = SplitPane{};
+        carets.clear();
+        if (document.text.storage) {
+            gapBuffer.restore(document.text);
+            highlighter.reset();
+            // Dropped first so the gap moves in place instead of copying
+            document.text = GapBuffer::Snapshot{};
+            gapBuffer.moveTo(document.cursor);
+            currentFileName = document.path;
+            untitledId = document.untitledId;
+            unsavedChanges = document.modified;
+            selectionAnchor = document.selectionAnchor;
+            scrollbar.setScrollOffset(document.scrollOffset);
+            beginJournal(!unsavedChanges);
             updateWindowTitle();
+        } else if (document.path == "Untitled") {
+            performNew();
+        } else {
+            // Evicted: the file is read (or mapped) again
+            openPath(document.path);
+            if (document.largeFile) {
+                scrollbar.setScrollOffset(document.scrollOffset);
+            }
+        }
+        documents.enforceBudget(gapBuffer.capacity());
+    };
+
+    auto showTabStatus = [&]() {
+        statusBar.setMessage("Tab " + std::to_string(documents.getActive() + 1) + " of " +
+                             std::to_string(documents.count()) + ", " +
+                             std::to_string(documents.getParkedBytes() / (1024 * 1024)) +
+                             " MB in background tabs");
+    };
+
+    auto switchTab = [&](size_t index) {
+        if (index == documents.getActive() || index >= documents.count()) return;
+        restoreActive(documents.activate(index, parkActive()));
+        showTabStatus();
+    };
+
+    // A fresh tab is only needed when this one holds anything
+    auto isBlankDocument = [&]() {
+        return currentFileName == "Untitled" && !unsavedChanges && gapBuffer.size() == 0 &&
+               !largeFile.isOpen() && !fileLoader.isActive();
+    };
+
+    auto newTab = [&]() {
+        if (isBlankDocument()) return;
+        documents.addAfterActive(parkActive());
+        performNew();
+        documents.enforceBudget(gapBuffer.capacity());
+    };
+
+    // Closing never drops unsaved work; the last tab is replaced by an empty one
+    auto closeTab = [&]() {
+        if (unsavedChanges) {
+            statusBar.setMessage("Save this document before closing its tab");
+            return;
+        }
+        fileLoader.cancel();
+        largeFile.close();
+        journal.discard();
+        restoreActive(documents.closeActive());
+    };
+
+    // Opened files get a tab of their own; one that is already open is switched to
+    auto performOpen = [&]() {
+        std::string path = openFileDialog();
+        if (path.empty()) return;
+        if (path == currentFileName) return;
+        for (size_t i = 0; i < documents.count(); i++) {
+            if (i != documents.getActive() && documents.at(i).path == path) {
+                switchTab(i);
+                return;
+            }
         }
+        if (!isBlankDocument()) {
+            documents.addAfterActive(parkActive());
+        }
+        openPath(path);
+        documents.enforceBudget(gapBuffer.capacity());
+    };
+
+    // Bounds of the whole document for the scrollbar. In large-file mode only the
+    // visible lines are laid out, so the height comes from the estimated line count.
+    auto documentBounds = [&]() {
+        if (largeFile.isOpen()) {
+            float lineSpacing = font.getLineSpacing(text.getCharacterSize());
+            float height = static_cast<float>(largeFile.getEstimatedLineCount()) * lineSpacing;
+            return sf::FloatRect(sf::Vector2f(0.f, TOP_MARGIN),
+                                 sf::Vector2f(static_cast<float>(window.getSize().x), height));
+        }
+        return text.getGlobalBounds();
+    };
+
+    // --- Split panes ---
+    // Screen rows [0, divider) belong to the top pane (its first TOP_MARGIN
+    // under the header) and [divider, height) to the bottom one
+    auto splitDivider = [&]() {
+        float height = static_cast<float>(window.getSize().y);
+        return std::round(TOP_MARGIN + (height - TOP_MARGIN) / 2.f);
+    };
+    auto inBottomPane = [&](int y) {
+        return splitView && static_cast<float>(y) >= splitDivider();
+    };
+    // Rows of document text a pane shows
+    auto paneTextHeight = [&](bool bottom) {
+        float height = static_cast<float>(window.getSize().y);
+        if (!splitView) return height - TOP_MARGIN;
+        return bottom ? height - splitDivider() : splitDivider() - TOP_MARGIN;
+    };
+    // The window size the scrollbar works with, so the focused pane can
+    // scroll to the end of the document
+    auto paneScrollSize = [&]() {
+        return sf::Vector2u(window.getSize().x,
+                            static_cast<unsigned>(TOP_MARGIN + paneTextHeight(bottomFocused)));
+    };
+    // Maps a pane's screen rows onto the document at its scroll offset; both
+    // panes show the document's first row just below the header or divider
+    auto paneView = [&](bool bottom, float scrollOffset) {
+        sf::Vector2f size(window.getSize());
+        float top = splitView && bottom ? splitDivider() : 0.f;
+        float height = splitView && !bottom ? splitDivider() : size.y - top;
+        float worldTop = scrollOffset + (top > 0.f ? TOP_MARGIN : 0.f);
+        sf::View view(sf::FloatRect({0.f, worldTop}, {size.x, height}));
+        view.setViewport(sf::FloatRect({0.f, top / size.y}, {1.f, height / size.y}));
+        return view;
+    };
+    sf::View otherView = paneView(true, 0.f);
+    auto updatePaneViews = [&]() {
+        textView = paneView(bottomFocused, scrollbar.getScrollOffset());
+        otherView = paneView(!bottomFocused, otherPane.scrollOffset);
     };
 
+    // Swaps the live cursor, selection and scroll offset with the other pane's
+    auto focusPane = [&](bool bottom) {
+        if (bottom == bottomFocused) return;
+        carets.clear();
+        SplitPane focused{gapBuffer.getGapStart(), selectionAnchor, scrollbar.getScrollOffset()};
+        gapBuffer.moveTo(otherPane.cursor);
+        selectionAnchor = otherPane.selectionAnchor;
+        scrollbar.setScrollOffset(otherPane.scrollOffset);
+        otherPane = focused;
+        bottomFocused = bottom;
+        updatePaneViews();
+    };
+
+    // The second pane opens on the same place as the first
+    auto toggleSplit = [&]() {
+        splitView = !splitView;
+        bottomFocused = false;
+        otherPane = SplitPane{gapBuffer.getGapStart(), -1, scrollbar.getScrollOffset()};
+        updatePaneViews();
+    };
+
+    // Pick up the journals left behind by a crash in untitled documents, each
+    // in a tab of its own. Fresh ids are numbered after them.
+    std::vector<unsigned> leftBehind = EditJournal::findUntitledJournals();
+    for (unsigned id : leftBehind) {
+        nextUntitledId = std::max(nextUntitledId, id + 1);
+    }
+    performNew();
+    for (unsigned id : leftBehind) {
+        newTab();
+        untitledId = id;
+        if (EditJournal::recoverUntitled(id, gapBuffer)) {
+            unsavedChanges = true;
+            statusBar.setMessage("Recovered unsaved changes");
+            updateWindowTitle();
+        }
+        // Rewritten from the recovered text, or removed when it held nothing
+        beginJournal(false);
+    }
+    sf::Clock journalClock;
+
+    // Shapes drawn every frame live across frames, so an idle redraw (e.g. the
+    // cursor blink) doesn't allocate
+    sf::RectangleShape headerBg;
+    sf::VertexArray selectionQuads(sf::PrimitiveType::Triangles);
+    sf::VertexArray otherSelectionQuads(sf::PrimitiveType::Triangles);
+    sf::VertexArray caretSelectionQuads(sf::PrimitiveType::Triangles);
+    sf::RectangleShape caretShape;
+    sf::RectangleShape otherCursor;
+    sf::RectangleShape splitDividerLine;
+    // Large-file mode pages in only the focused pane's lines, so the other
+    // pane gets its own (visible lines only) text; otherwise both draw `text`
+    BatchedText otherText(font);
+    std::vector<std::string> tabLabels;
+
+    // Per-frame temporaries of the layout pipeline; released all at once when
+    // the next frame starts
+    FrameArena frameArena;
+
     // Search highlight
     sf::RectangleShape searchHighlight;
     searchHighlight.setFillColor(sf::Color(255, 255, 0, 100)); // Yellow highlight
 
-    while (window.isOpen()) {
-        bool cursorMovedThisFrame = false;
-
-        while (const std::optional<sf::Event> event = window.pollEvent()) {
-            // Block input when the modal is open
-            if (showCloseConfirm) {
-                if (const auto* mouseEvent = event->getIf<sf::Event::MouseButtonPressed>()) {
-                    sf::Vector2f mousePos(
-                        static_cast<float>(mouseEvent->position.x),
-                        static_cast<float>(mouseEvent->position.y)
-                    );
-
-                    sf::FloatRect yesBounds(
-                    sf::Vector2f(window.getSize().x / 2.f - 110.f,
-                    window.getSize().y / 2.f + 30.f),
-                        sf::Vector2f(80.f, 35.f)
-                    );
-
-                    sf::FloatRect noBounds(
-                    sf::Vector2f(window.getSize().x / 2.f + 30.f,
-                    window.getSize().y / 2.f + 30.f),
-                        sf::Vector2f(80.f, 35.f)
-                    );
-
-                    if (yesBounds.contains(mousePos)) {
-                        window.close();
-                    }
-                    if (noBounds.contains(mousePos)) {
-                        showCloseConfirm = false;
-                    }
-                }
-                continue;
-            }
+    // What has to be recomputed before the next frame. Frames are only drawn
+    // when something is dirty; otherwise the loop sleeps in waitEvent until
+    // input arrives or the cursor is due to blink.
+    enum Dirty : unsigned {
+        DirtyText   = 1 << 0,   // re-wrap and re-upload the document text
+        DirtyCursor = 1 << 1,   // cursor moved, blinked or the selection changed
+        DirtyStatus = 1 << 2,   // status bar contents
+        DirtyChrome = 1 << 3,   // header, menus, scrollbar and dialogs
+        DirtyAll    = DirtyText | DirtyCursor | DirtyStatus | DirtyChrome
+    };
+    unsigned dirty = DirtyAll;
+
+    // Inputs of the current text layout; it is rebuilt only when one changes
+    DisplayState state{"", 0};
+    size_t layoutVersion = 0;
+    float layoutWidth = -1.f;
+    unsigned int layoutCharSize = 0;
+    size_t largeFileTopLine = 0;
+    size_t otherTopLine = 0;
+    bool layoutLargeFile = false;
+    float drawnScrollOffset = 0.f;
+
+    bool backgroundWasBusy = false;
+
+    // Ctrl+Shift+P shows per-stage frame timings, Ctrl+Shift+E writes them to CSV
+    FrameProfiler profiler;
+    profiler.setAllocationCounter(allocationCount);
+    ProfilerOverlay profilerOverlay(font);
+
+    sf::Clock verticalMoveClock;
+    bool verticalKeyHeld = false;
+    bool upHeld = false;
+    bool downHeld = false;
+    bool altHeld = false;
+    bool shiftHeld = false;
+    // Alt+Shift+drag selects a block from the press position
+    bool blockDragging = false;
+    size_t blockAnchor = 0;
+    bool cursorMovedThisFrame = false;
+
+    // Typing and Left/Right, for one event or a coalesced run of them
+    auto typeText = [&](const std::string& utf8) {
+        if (isReadOnly()) return;
+        // Typing replaces the selection; with several cursors all of them are
+        // edited in one pass over the buffer
+        if (carets.empty()) {
+            insertAtCursor(gapBuffer, selectionAnchor, utf8);
+        } else {
+            insertAtCarets(gapBuffer, selectionAnchor, carets, utf8);
+        }
+        unsavedChanges = true;
+        updateWindowTitle();
+        cursorMovedThisFrame = true;
+    };
+    auto moveCursorHorizontal = [&](bool right, bool extend, size_t count) {
+        if (carets.empty()) {
+            moveHorizontal(gapBuffer, selectionAnchor, right, extend, count);
+        } else {
+            moveCaretsHorizontal(gapBuffer, selectionAnchor, carets, right, extend, count);
+        }
+        cursorMovedThisFrame = true;
+    };
 
-            if (event->is<sf::Event::Closed>()) {
-                if (unsavedChanges) {
-                    showCloseConfirm = true;
-                } else {
+    // Everything one input event does, whether it came from the window or a
+    // replayed trace
+    auto handleEvent = [&](const sf::Event& event) {
+        // Keys, clicks and resizes may affect the cursor, status bar and chrome.
+        // Mouse moves mark only what they change; the text is re-laid out only
+        // when its inputs change (checked after the event loop).
+        if (!event.is<sf::Event::MouseMoved>()) {
+            dirty |= DirtyCursor | DirtyStatus | DirtyChrome;
+        }
+
+        // Arrow-key repeat follows press/release events rather than polled key
+        // state, so a replayed trace moves the cursor the way the recording did
+        if (const auto* keyEvent = event.getIf<sf::Event::KeyPressed>()) {
+            if (keyEvent->code == sf::Keyboard::Key::Up) upHeld = true;
+            if (keyEvent->code == sf::Keyboard::Key::Down) downHeld = true;
+            if (keyEvent->code == sf::Keyboard::Key::LAlt || keyEvent->code == sf::Keyboard::Key::RAlt) altHeld = true;
+            if (keyEvent->code == sf::Keyboard::Key::LShift || keyEvent->code == sf::Keyboard::Key::RShift) shiftHeld = true;
+            // Vertical moves are single-cursor
+            if (upHeld || downHeld) carets.clear();
+        }
+        if (const auto* keyEvent = event.getIf<sf::Event::KeyReleased>()) {
+            if (keyEvent->code == sf::Keyboard::Key::Up) upHeld = false;
+            if (keyEvent->code == sf::Keyboard::Key::Down) downHeld = false;
+            if (keyEvent->code == sf::Keyboard::Key::LAlt || keyEvent->code == sf::Keyboard::Key::RAlt) altHeld = false;
+            if (keyEvent->code == sf::Keyboard::Key::LShift || keyEvent->code == sf::Keyboard::Key::RShift) shiftHeld = false;
+        }
+        if (event.is<sf::Event::FocusLost>()) {
+            upHeld = downHeld = altHeld = shiftHeld = false;
+        }
+
+        // Block input when the modal is open
+        if (showCloseConfirm) {
+            if (const auto* mouseEvent = event.getIf<sf::Event::MouseButtonPressed>()) {
+                sf::Vector2f mousePos(
+                    static_cast<float>(mouseEvent->position.x),
+                    static_cast<float>(mouseEvent->position.y)
+                );
+
+                sf::FloatRect yesBounds(
+                sf::Vector2f(window.getSize().x / 2.f - 110.f,
+                window.getSize().y / 2.f + 30.f),
+                    sf::Vector2f(80.f, 35.f)
+                );
+
+                sf::FloatRect noBounds(
+                sf::Vector2f(window.getSize().x / 2.f + 30.f,
+                window.getSize().y / 2.f + 30.f),
+                    sf::Vector2f(80.f, 35.f)
+                );
+
+                if (yesBounds.contains(mousePos)) {
                     window.close();
                 }
+                if (noBounds.contains(mousePos)) {
+                    showCloseConfirm = false;
+                }
+            }
+            return;
+        }
+
+        if (event.is<sf::Event::Closed>()) {
+            if (unsavedChanges || documents.anyModified()) {
+                showCloseConfirm = true;
+            } else {
+                window.close();
             }
+        }
 
-            if (const auto* resizeEvent = event->getIf<sf::Event::Resized>()) {
-                // Resize both views
-                sf::Vector2f newSize(static_cast<float>(resizeEvent->size.x),
-                                   static_cast<float>(resizeEvent->size.y));
-                uiView.setSize(newSize);
-                uiView.setCenter(newSize / 2.f);
+        if (const auto* resizeEvent = event.getIf<sf::Event::Resized>()) {
+            // Resize both views
+            sf::Vector2f newSize(static_cast<float>(resizeEvent->size.x),
+                               static_cast<float>(resizeEvent->size.y));
+            uiView.setSize(newSize);
+            uiView.setCenter(newSize / 2.f);
 
-                textView.setSize(newSize);
-                textView.setCenter(newSize / 2.f);
+            updatePaneViews();
 
-                // Update text size button position to stay anchored to right
-                updateTextSizeButtonPosition();
+            // Update text size button position to stay anchored to right
+            updateTextSizeButtonPosition();
 
-                // Update status bar width
-                statusBar.setWidth(newSize.x);
+            // Update status bar width
+            statusBar.setWidth(newSize.x);
 
-                // Update search dialog position
-                searchDialog.setPosition(newSize);
-            }
+            // Update search dialog position
+            searchDialog.setPosition(newSize);
+        }
 
-            // Handle search dialog input when it's visible
-            if (searchDialog.getIsVisible()) {
-                if (const auto* textEvent = event->getIf<sf::Event::TextEntered>()) {
-                    if (textEvent->unicode < 128 && textEvent->unicode != '\b' &&
-                        textEvent->unicode != 127 && textEvent->unicode != 27) {
-                        searchDialog.handleTextInput(static_cast<char>(textEvent->unicode));
-                        searchDialog.updateSearch(gapBuffer.getString());
-                        cursorMovedThisFrame = true;
-                    }
+        // Handle search dialog input when it's visible
+        if (searchDialog.getIsVisible()) {
+            if (const auto* textEvent = event.getIf<sf::Event::TextEntered>()) {
+                if (textEvent->unicode < 128 && textEvent->unicode != '\b' &&
+                    textEvent->unicode != 127 && textEvent->unicode != 27) {
+                    searchDialog.handleTextInput(static_cast<char>(textEvent->unicode));
+                    searchDialog.updateSearch(gapBuffer.getString());
+                    cursorMovedThisFrame = true;
                 }
+            }
 
-                if (const auto* keyEvent = event->getIf<sf::Event::KeyPressed>()) {
-                    if (keyEvent->code == sf::Keyboard::Key::Backspace) {
-                        searchDialog.handleBackspace();
-                        searchDialog.updateSearch(gapBuffer.getString());
-                    }
-                    else if (keyEvent->code == sf::Keyboard::Key::Enter) {
-                        // Treat Enter the same as F3 (next match)
-                        searchDialog.handleKeyPress(sf::Keyboard::Key::F3);
-                    }
-                    else {
-                        searchDialog.handleKeyPress(keyEvent->code);
-                    }
+            if (const auto* keyEvent = event.getIf<sf::Event::KeyPressed>()) {
+                if (keyEvent->code == sf::Keyboard::Key::Backspace) {
+                    searchDialog.handleBackspace();
+                    searchDialog.updateSearch(gapBuffer.getString());
+                }
+                else if (keyEvent->code == sf::Keyboard::Key::Enter) {
+                    // Treat Enter the same as F3 (next match)
+                    searchDialog.handleKeyPress(sf::Keyboard::Key::F3);
+                }
+                else {
+                    searchDialog.handleKeyPress(keyEvent->code);
+                }
 
-                    // Move cursor to current match
-                    if (searchDialog.hasMatches()) {
-                        gapBuffer.moveTo(searchDialog.getCurrentMatchPosition());
-                        cursorMovedThisFrame = true;
-                    }
+                // Move cursor to current match
+                if (searchDialog.hasMatches()) {
+                    carets.clear();
+                    gapBuffer.moveTo(searchDialog.getCurrentMatchPosition());
+                    cursorMovedThisFrame = true;
                 }
+            }
 
-                // Skip normal text input handling when search is open
-                continue;
+            // Skip normal text input handling when search is open
+            return;
+        }
+
+        if (const auto* textEvent = event.getIf<sf::Event::TextEntered>()) {
+            if (textEvent->unicode != '\b' && textEvent->unicode != 127) {
+                typeText(utf8::encode(textEvent->unicode));
             }
+        }
 
-            if (const auto* textEvent = event->getIf<sf::Event::TextEntered>()) {
-                if (textEvent->unicode < 128 && textEvent->unicode != '\b' &&
-                    textEvent->unicode != 127) {
-                    // If there's a selection, delete it first before inserting
-                    if (selectionAnchor != -1) {
-                        int cursorPos = static_cast<int>(gapBuffer.getGapStart());
-                        int start = std::min(selectionAnchor, cursorPos);
-                        int end = std::max(selectionAnchor, cursorPos);
-                        gapBuffer.deleteRange(start, end);
-                        unsavedChanges = true;
-                        updateWindowTitle();
-                        selectionAnchor = -1;
-                    }
-                    gapBuffer.insert(static_cast<char>(textEvent->unicode));
+        if (const auto* keyEvent = event.getIf<sf::Event::KeyPressed>()) {
+            // Modifiers come from the event itself so recorded traces replay exactly
+            bool ctrlOrCmd = keyEvent->control || keyEvent->system;
+            bool shiftPressed = keyEvent->shift;
+
+            bool readOnly = isReadOnly();
+
+            if (keyEvent->code == sf::Keyboard::Key::Escape && fileLoader.isActive()) {
+                // Drop the partial document so a truncated copy can never be saved
+                performNew();
+            } else if (keyEvent->code == sf::Keyboard::Key::Escape && !carets.empty()) {
+                carets.clear();
+                cursorMovedThisFrame = true;
+            }
+
+            // Shift+Left/Right extends the selection, a plain arrow clears it
+            if (keyEvent->code == sf::Keyboard::Key::Left) {
+                moveCursorHorizontal(false, shiftPressed, 1);
+            }
+            if (keyEvent->code == sf::Keyboard::Key::Right) {
+                moveCursorHorizontal(true, shiftPressed, 1);
+            }
+            if (keyEvent->code == sf::Keyboard::Key::Backspace && !readOnly) {
+                if (carets.empty() ? deleteBackward(gapBuffer, selectionAnchor)
+                                   : deleteBackwardAtCarets(gapBuffer, selectionAnchor, carets)) {
                     unsavedChanges = true;
                     updateWindowTitle();
-                    cursorMovedThisFrame = true;
                 }
+                cursorMovedThisFrame = true;
+            }
+            if (keyEvent->code == sf::Keyboard::Key::Delete && !readOnly) {
+                if (carets.empty() ? deleteForward(gapBuffer, selectionAnchor)
+                                   : deleteForwardAtCarets(gapBuffer, selectionAnchor, carets)) {
+                    unsavedChanges = true;
+                    updateWindowTitle();
+                }
+                cursorMovedThisFrame = true;
             }
 
-            if (const auto* keyEvent = event->getIf<sf::Event::KeyPressed>()) {
-                bool ctrlOrCmd = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LControl) ||
-                                 sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RControl) ||
-                                 sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LSystem);
 
-                bool shiftPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift) ||
-                                   sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RShift);
+            if (keyEvent->code == sf::Keyboard::Key::S && ctrlOrCmd) {
+                if (shiftPressed) {
+                    // Force Save As regardless of current file
+                    performSaveAs();
+                } else {
+                    performSave();
+                }
+            }
 
-                if (keyEvent->code == sf::Keyboard::Key::Left) {
-                    if (shiftPressed) {
-                        // Start selection if not already active
-                        if (selectionAnchor == -1) {
-                            selectionAnchor = gapBuffer.getGapStart();
-                        }
-                    } else {
-                        // Clear selection if not holding shift
-                        selectionAnchor = -1;
-                    }
-                    gapBuffer.moveLeft();
-                    cursorMovedThisFrame = true;
+            if (keyEvent->code == sf::Keyboard::Key::Backslash && ctrlOrCmd) {
+                toggleSplit();
+                dirty |= DirtyText;
+            }
+
+            if (keyEvent->code == sf::Keyboard::Key::P && ctrlOrCmd && shiftPressed) {
+                profiler.setEnabled(!profiler.isEnabled());
+            }
+            if (keyEvent->code == sf::Keyboard::Key::E && ctrlOrCmd && shiftPressed) {
+                const std::string csvPath = "frame_profile.csv";
+                statusBar.setMessage(profiler.exportCsv(csvPath)
+                    ? "Frame profile written to " + csvPath
+                    : "Could not write " + csvPath);
+            }
+
+            if (keyEvent->code == sf::Keyboard::Key::N && ctrlOrCmd) {
+                newTab();
+            }
+            if (keyEvent->code == sf::Keyboard::Key::T && ctrlOrCmd) {
+                newTab();
+            }
+            if (keyEvent->code == sf::Keyboard::Key::W && ctrlOrCmd) {
+                closeTab();
+            }
+            // Ctrl+PageDown/PageUp cycle through the tabs
+            if (keyEvent->code == sf::Keyboard::Key::PageDown && ctrlOrCmd && documents.count() > 1) {
+                switchTab((documents.getActive() + 1) % documents.count());
+            }
+            if (keyEvent->code == sf::Keyboard::Key::PageUp && ctrlOrCmd && documents.count() > 1) {
+                switchTab((documents.getActive() + documents.count() - 1) % documents.count());
+            }
+
+            if (keyEvent->code == sf::Keyboard::Key::O && ctrlOrCmd) {
+                performOpen();
+            }
+            if (keyEvent->code == sf::Keyboard::Key::Equal && ctrlOrCmd) {
+                text.setCharacterSize(text.getCharacterSize() + 1);
+                fontCache.prewarm(font, text.getCharacterSize());
+                updateCursorSize(cursor, font, text.getCharacterSize());
+            }
+            if (keyEvent->code == sf::Keyboard::Key::Hyphen && ctrlOrCmd) {
+                if (text.getCharacterSize() >= 6) {
+                    text.setCharacterSize(text.getCharacterSize() - 1);
+                    fontCache.prewarm(font, text.getCharacterSize());
+                    updateCursorSize(cursor, font, text.getCharacterSize());
                 }
-                if (keyEvent->code == sf::Keyboard::Key::Right) {
-                    if (shiftPressed) {
-                        // Start selection if not already active
-                        if (selectionAnchor == -1) {
-                            selectionAnchor = gapBuffer.getGapStart();
-                        }
-                    } else {
-                        // Clear selection if not holding shift
-                        selectionAnchor = -1;
-                    }
-                    gapBuffer.moveRight();
-                    cursorMovedThisFrame = true;
+            }
+
+            // Search
+            if (keyEvent->code == sf::Keyboard::Key::F && ctrlOrCmd) {
+                searchDialog.show();
+                searchDialog.setPosition(sf::Vector2f(window.getSize().x, window.getSize().y));
+                // Update search with current text to restore previous matches
+                searchDialog.updateSearch(gapBuffer.getString());
+            }
+
+            // Clipboard operations
+            if (keyEvent->code == sf::Keyboard::Key::A && ctrlOrCmd) {
+                carets.clear();
+                selectAll(gapBuffer, selectionAnchor);
+                cursorMovedThisFrame = true;
+            }
+            if (keyEvent->code == sf::Keyboard::Key::C && ctrlOrCmd) {
+                // Copy; with several cursors, their selections one per line
+                if (!carets.empty()) {
+                    clipboard = selectedTextAtCarets(gapBuffer, selectionAnchor, carets);
+                    clipboardIsBlock = true;
+                    sf::Clipboard::setString(sf::String::fromUtf8(clipboard.begin(), clipboard.end())); // Also set system clipboard
+                } else if (selectionAnchor != -1) {
+                    clipboard = selectedText(gapBuffer, selectionAnchor);
+                    clipboardIsBlock = false;
+                    sf::Clipboard::setString(sf::String::fromUtf8(clipboard.begin(), clipboard.end())); // Also set system clipboard
                 }
-                if (keyEvent->code == sf::Keyboard::Key::Backspace) {
-                    if (selectionAnchor != -1) {
-                        // Delete the selection
-                        int cursorPos = static_cast<int>(gapBuffer.getGapStart());
-                        int start = std::min(selectionAnchor, cursorPos);
-                        int end = std::max(selectionAnchor, cursorPos);
-                        gapBuffer.deleteRange(start, end);
-                        unsavedChanges = true;
-                        updateWindowTitle();
-                        selectionAnchor = -1;
-                    } else {
-                        // Normal backspace
-                        gapBuffer.backspace();
-                        unsavedChanges = true;
-                        updateWindowTitle();
-                    }
+            }
+            if (keyEvent->code == sf::Keyboard::Key::X && ctrlOrCmd && !readOnly) {
+                // Cut
+                if (!carets.empty()) {
+                    clipboard = selectedTextAtCarets(gapBuffer, selectionAnchor, carets);
+                    clipboardIsBlock = true;
+                    sf::Clipboard::setString(sf::String::fromUtf8(clipboard.begin(), clipboard.end())); // Also set system clipboard
+                    insertAtCarets(gapBuffer, selectionAnchor, carets, "");
+                    unsavedChanges = true;
+                    updateWindowTitle();
                     cursorMovedThisFrame = true;
-                }
-                if (keyEvent->code == sf::Keyboard::Key::Delete) {
-                    if (selectionAnchor != -1) {
-                        // Delete the selection
-                        int cursorPos = static_cast<int>(gapBuffer.getGapStart());
-                        int start = std::min(selectionAnchor, cursorPos);
-                        int end = std::max(selectionAnchor, cursorPos);
-                        gapBuffer.deleteRange(start, end);
-                        unsavedChanges = true;
-                        updateWindowTitle();
-                        selectionAnchor = -1;
-                    } else {
-                        // Delete character at cursor position
-                        int cursorPos = gapBuffer.getGapStart();
-                        std::string currentText = gapBuffer.getString();
-                        if (cursorPos < static_cast<int>(currentText.length())) {
-                            gapBuffer.deleteRange(cursorPos, cursorPos + 1);
-                            unsavedChanges = true;
-                            updateWindowTitle();
-                        }
-                    }
+                } else if (selectionAnchor != -1) {
+                    clipboard = selectedText(gapBuffer, selectionAnchor);
+                    clipboardIsBlock = false;
+                    sf::Clipboard::setString(sf::String::fromUtf8(clipboard.begin(), clipboard.end())); // Also set system clipboard
+                    deleteSelection(gapBuffer, selectionAnchor);
+                    unsavedChanges = true;
+                    updateWindowTitle();
                     cursorMovedThisFrame = true;
                 }
+            }
+            if (keyEvent->code == sf::Keyboard::Key::V && ctrlOrCmd && !readOnly) {
+                // Paste
+                // Try system clipboard first, fall back to internal clipboard
+                sf::U8String systemClipboard = sf::Clipboard::getString().toUtf8();
+                std::string textToPaste(systemClipboard.begin(), systemClipboard.end());
+                if (textToPaste.empty()) {
+                    textToPaste = clipboard;
+                }
 
-
-                if (keyEvent->code == sf::Keyboard::Key::S && ctrlOrCmd) {
-                    bool shiftPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift) ||
-                                        sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RShift);
-
-                    if (shiftPressed) {
-                        // Force Save As regardless of current file
-                        performSaveAs();
+                if (!textToPaste.empty()) {
+                    // Pasting replaces the selection, at every cursor; a copied
+                    // block goes back in as a column
+                    bool block = clipboardIsBlock && textToPaste == clipboard;
+                    if (!carets.empty()) {
+                        pasteAtCarets(gapBuffer, selectionAnchor, carets, textToPaste);
+                    } else if (block) {
+                        deleteSelection(gapBuffer, selectionAnchor);
+                        pasteColumn(gapBuffer, selectionAnchor, carets, textToPaste);
                     } else {
-                        performSave();
+                        insertAtCursor(gapBuffer, selectionAnchor, textToPaste);
                     }
+                    unsavedChanges = true;
+                    updateWindowTitle();
+                    cursorMovedThisFrame = true;
                 }
+            }
+        }
 
-                if (keyEvent->code == sf::Keyboard::Key::N && ctrlOrCmd) {
-                    performNew();
-                }
-
-                if (keyEvent->code == sf::Keyboard::Key::O && ctrlOrCmd) {
-                    performOpen();
-                }
-                if (keyEvent->code == sf::Keyboard::Key::Equal && ctrlOrCmd) {
-                    text.setCharacterSize(text.getCharacterSize() + 1);
-                    updateCursorSize(cursor, font, text.getCharacterSize());
+        if (const auto* mouseEvent = event.getIf<sf::Event::MouseButtonPressed>()) {
+            if (mouseEvent->button == sf::Mouse::Button::Left) {
+                float windowWidth = static_cast<float>(window.getSize().x);
+                sf::Vector2f uiPos(static_cast<float>(mouseEvent->position.x),
+                                  static_cast<float>(mouseEvent->position.y));
+
+                // Check if clicking on the scrollbar area
+                if (mouseEvent->position.x >= windowWidth - 12) {
+                    sf::FloatRect textBounds = documentBounds();
+                    scrollbar.handleMousePress(mouseEvent->position, window.getSize(),
+                                              textBounds, TOP_MARGIN);
+                    mouseState = MouseState::ScrollbarDragging;
                 }
-                if (keyEvent->code == sf::Keyboard::Key::Hyphen && ctrlOrCmd) {
-                    if (text.getCharacterSize() >= 6) {
-                        text.setCharacterSize(text.getCharacterSize() - 1);
-                        updateCursorSize(cursor, font, text.getCharacterSize());
-                    }
+                // Check if theme toggle was clicked
+                else if (themeToggle.shape.getGlobalBounds().contains(uiPos)) {
+                    theme.isDark = !theme.isDark;
+                    applyTheme();
+                    updateThemeToggleAppearance();
+                    // Update search/text buttons too
+                    searchBtn.shape.setFillColor(theme.btnNormal());
+                    searchBtn.text.setFillColor(theme.textColor());
+                    textSize.shape.setFillColor(theme.btnNormal());
+                    textSize.text.setFillColor(theme.textColor());
                 }
-
-                // Search
-                if (keyEvent->code == sf::Keyboard::Key::F && ctrlOrCmd) {
+                // Check if the search button was clicked
+                else if (searchBtn.shape.getGlobalBounds().contains(uiPos)) {
                     searchDialog.show();
                     searchDialog.setPosition(sf::Vector2f(window.getSize().x, window.getSize().y));
-                    // Update search with current text to restore previous matches
                     searchDialog.updateSearch(gapBuffer.getString());
                 }
-
-                // Clipboard operations
-                if (keyEvent->code == sf::Keyboard::Key::A && ctrlOrCmd) {
-                    // Select All
-                    selectionAnchor = 0;
-                    gapBuffer.moveTo(gapBuffer.getString().length());
-                    cursorMovedThisFrame = true;
-                }
-                if (keyEvent->code == sf::Keyboard::Key::C && ctrlOrCmd) {
-                    // Copy
-                    if (selectionAnchor != -1) {
-                        int cursorPos = static_cast<int>(gapBuffer.getGapStart());
-                        int start = std::min(selectionAnchor, cursorPos);
-                        int end = std::max(selectionAnchor, cursorPos);
-                        clipboard = gapBuffer.getRange(start, end);
-                        sf::Clipboard::setString(clipboard); // Also set system clipboard
+                // Check if the file menu (button or open panel) was clicked
+                else if (fileMenu.containsPoint(uiPos)) {
+                    // 0=New  1=Open  2=Save  3=Save As  4=Exit
+                    int item = fileMenu.handleClick(uiPos);
+                    if      (item == 0) { newTab(); }
+                    else if (item == 1) { performOpen(); }
+                    else if (item == 2) { performSave(); }
+                    else if (item == 3) { performSaveAs(); }
+                    else if (item == 4) {
+                        if (unsavedChanges || documents.anyModified()) { showCloseConfirm = true; }
+                        else                { window.close(); }
                     }
                 }
-                if (keyEvent->code == sf::Keyboard::Key::X && ctrlOrCmd) {
-                    // Cut
-                    if (selectionAnchor != -1) {
-                        int cursorPos = static_cast<int>(gapBuffer.getGapStart());
-                        int start = std::min(selectionAnchor, cursorPos);
-                        int end = std::max(selectionAnchor, cursorPos);
-                        clipboard = gapBuffer.getRange(start, end);
-                        sf::Clipboard::setString(clipboard); // Also set system clipboard
-                        gapBuffer.deleteRange(start, end);
-                        unsavedChanges = true;
-                        updateWindowTitle();
-                        selectionAnchor = -1;
-                        cursorMovedThisFrame = true;
-                    }
+                else if (tabBar.containsPoint(uiPos)) {
+                    switchTab(static_cast<size_t>(tabBar.handleClick(uiPos)));
                 }
-                if (keyEvent->code == sf::Keyboard::Key::V && ctrlOrCmd) {
-                    // Paste
-                    // Try system clipboard first, fall back to internal clipboard
-                    std::string textToPaste = sf::Clipboard::getString().toAnsiString();
-                    if (textToPaste.empty()) {
-                        textToPaste = clipboard;
+                // Close an open dropdown when clicking anywhere else
+                else {
+                    if (fileMenu.isOpen()) {
+                        fileMenu.close();
                     }
 
-                    if (!textToPaste.empty()) {
-                        // If there's a selection, delete it first
-                        if (selectionAnchor != -1) {
-                            int cursorPos = static_cast<int>(gapBuffer.getGapStart());
-                            int start = std::min(selectionAnchor, cursorPos);
-                            int end = std::max(selectionAnchor, cursorPos);
-                            gapBuffer.deleteRange(start, end);
-                            unsavedChanges = true;
-                            updateWindowTitle();
-                            selectionAnchor = -1;
-                        }
-                        gapBuffer.insertString(textToPaste);
-                        unsavedChanges = true;
-                        updateWindowTitle();
-                        cursorMovedThisFrame = true;
-                    }
-                }
-            }
+                    mouseState = MouseState::Pressed;
+                    mousePressPos = mouseEvent->position;
 
-            if (const auto* mouseEvent = event->getIf<sf::Event::MouseButtonPressed>()) {
-                if (mouseEvent->button == sf::Mouse::Button::Left) {
-                    float windowWidth = static_cast<float>(window.getSize().x);
-                    sf::Vector2f uiPos(static_cast<float>(mouseEvent->position.x),
-                                      static_cast<float>(mouseEvent->position.y));
+                    // Clicking in text area; a click in the other pane focuses it first
+                    focusPane(inBottomPane(mouseEvent->position.y));
 
-                    // Check if clicking on the scrollbar area
-                    if (mouseEvent->position.x >= windowWidth - 12) {
-                        sf::FloatRect textBounds = text.getGlobalBounds();
-                        scrollbar.handleMousePress(mouseEvent->position, window.getSize(),
-                                                  textBounds, TOP_MARGIN);
-                        mouseState = MouseState::ScrollbarDragging;
-                    }
-                    // Check if theme toggle was clicked
-                    else if (themeToggle.shape.getGlobalBounds().contains(uiPos)) {
-                        theme.isDark = !theme.isDark;
-                        applyTheme();
-                        updateThemeToggleAppearance();
-                        // Update search/text buttons too
-                        searchBtn.shape.setFillColor(theme.btnNormal());
-                        searchBtn.text.setFillColor(theme.textColor());
-                        textSize.shape.setFillColor(theme.btnNormal());
-                        textSize.text.setFillColor(theme.textColor());
-                    }
-                    // Check if the search button was clicked
-                    else if (searchBtn.shape.getGlobalBounds().contains(uiPos)) {
-                        searchDialog.show();
-                        searchDialog.setPosition(sf::Vector2f(window.getSize().x, window.getSize().y));
-                        searchDialog.updateSearch(gapBuffer.getString());
-                    }
-                    // Check if the file menu (button or open panel) was clicked
-                    else if (fileMenu.containsPoint(uiPos)) {
-                        // 0=New  1=Open  2=Save  3=Save As  4=Exit
-                        int item = fileMenu.handleClick(uiPos);
-                        if      (item == 0) { performNew(); }
-                        else if (item == 1) { performOpen(); }
-                        else if (item == 2) { performSave(); }
-                        else if (item == 3) { performSaveAs(); }
-                        else if (item == 4) {
-                            if (unsavedChanges) { showCloseConfirm = true; }
-                            else                { window.close(); }
+                    // Alt+Shift+press starts a block selection
+                    if (altHeld && shiftHeld && !isReadOnly()) {
+                        sf::Vector2f worldPos = window.mapPixelToCoords(mouseEvent->position, textView);
+                        int index = text.findCharacterAt(worldPos);
+                        if (index != -1) {
+                            carets.clear();
+                            blockAnchor = rawOffsetOfDisplayGlyph(state, gapBuffer, static_cast<size_t>(index));
+                            gapBuffer.moveTo(blockAnchor);
+                            selectionAnchor = -1;
+                            blockDragging = true;
+                            mouseState = MouseState::Dragging;
+                            cursorMovedThisFrame = true;
+                        } else {
+                            mouseState = MouseState::Idle;
                         }
+                        return;
                     }
-                    // Close an open dropdown when clicking anywhere else
-                    else {
-                        if (fileMenu.isOpen()) {
-                            fileMenu.close();
+                    // Alt+click adds a cursor and leaves the others in place
+                    if (altHeld && !isReadOnly()) {
+                        sf::Vector2f worldPos = window.mapPixelToCoords(mouseEvent->position, textView);
+                        int index = text.findCharacterAt(worldPos);
+                        if (index != -1) {
+                            addCaret(gapBuffer, selectionAnchor, carets,
+                                     rawOffsetOfDisplayGlyph(state, gapBuffer, static_cast<size_t>(index)));
+                            cursorMovedThisFrame = true;
                         }
-
-                        mouseState = MouseState::Pressed;
-                        mousePressPos = mouseEvent->position;
-
-                        // Clicking in text area
-                        handleMouseClick(sf::Vector2i(mouseEvent->position.x,mouseEvent->position.y), gapBuffer, text,
-                                         window, textView);
-                        selectionAnchor = gapBuffer.getGapStart();
+                        mouseState = MouseState::Idle;
+                        return;
                     }
+                    carets.clear();
+                    blockDragging = false;
+                    handleMouseClick(sf::Vector2i(mouseEvent->position.x,mouseEvent->position.y), gapBuffer, state,
+                                     text, window, textView);
+                    selectionAnchor = gapBuffer.getGapStart();
                 }
             }
+        }
 
-            if (const auto* moveEvent = event->getIf<sf::Event::MouseMoved>()) {
-                // Always update dropdown hover state
-                fileMenu.handleHover(sf::Vector2f(
+        if (const auto* moveEvent = event.getIf<sf::Event::MouseMoved>()) {
+            // Always update dropdown hover state
+            if (fileMenu.handleHover(sf::Vector2f(
                     static_cast<float>(moveEvent->position.x),
-                    static_cast<float>(moveEvent->position.y)));
-
-                // Hover tint for search button
-                sf::Vector2f mp(static_cast<float>(moveEvent->position.x),
-                                static_cast<float>(moveEvent->position.y));
-                searchBtn.shape.setFillColor(
-                    searchBtn.shape.getGlobalBounds().contains(mp)
-                        ? theme.btnHover()
-                        : theme.btnNormal());
-                searchBtn.text.setFillColor(theme.textColor());
-                themeToggle.shape.setFillColor(
-                    themeToggle.shape.getGlobalBounds().contains(mp)
-                        ? theme.btnHover()
-                        : theme.btnNormal());
+                    static_cast<float>(moveEvent->position.y)))) {
+                dirty |= DirtyChrome;
+            }
 
-                if (mouseState == MouseState::ScrollbarDragging) {
-                    sf::FloatRect textBounds = text.getGlobalBounds();
-                    scrollbar.handleMouseMove(moveEvent->position, window.getSize(), textBounds);
-                }
-                else if (mouseState == MouseState::Pressed) {
-                    sf::Vector2f delta(
-                        moveEvent->position.x - mousePressPos.x,
-                        moveEvent->position.y - mousePressPos.y
-                    );
+            // Hover tint for search button
+            sf::Vector2f mp(static_cast<float>(moveEvent->position.x),
+                            static_cast<float>(moveEvent->position.y));
+            sf::Color searchTint = searchBtn.shape.getGlobalBounds().contains(mp)
+                ? theme.btnHover()
+                : theme.btnNormal();
+            sf::Color toggleTint = themeToggle.shape.getGlobalBounds().contains(mp)
+                ? theme.btnHover()
+                : theme.btnNormal();
+            if (searchBtn.shape.getFillColor() != searchTint ||
+                themeToggle.shape.getFillColor() != toggleTint) {
+                searchBtn.shape.setFillColor(searchTint);
+                themeToggle.shape.setFillColor(toggleTint);
+                dirty |= DirtyChrome;
+            }
 
-                    if (std::hypot(delta.x, delta.y) > DRAG_THRESHOLD) {
-                        mouseState = MouseState::Dragging;
-                    }
+            if (mouseState == MouseState::ScrollbarDragging) {
+                sf::FloatRect textBounds = documentBounds();
+                scrollbar.handleMouseMove(moveEvent->position, window.getSize(), textBounds);
+            }
+            else if (mouseState == MouseState::Pressed) {
+                sf::Vector2f delta(
+                    moveEvent->position.x - mousePressPos.x,
+                    moveEvent->position.y - mousePressPos.y
+                );
+
+                if (std::hypot(delta.x, delta.y) > DRAG_THRESHOLD) {
+                    mouseState = MouseState::Dragging;
                 }
-                else if (mouseState == MouseState::Dragging) {
-                    // Convert mouse → text coords
-                    sf::Vector2f worldPos = window.mapPixelToCoords(moveEvent->position, textView);
-
-                    int bestIndex = -1;
-                    float bestDistance = std::numeric_limits<float>::max();
+            }
+            else if (mouseState == MouseState::Dragging) {
+                // Convert mouse → text coords
+                sf::Vector2f worldPos = window.mapPixelToCoords(moveEvent->position, textView);
 
-                    for (size_t i = 0; i <= text.getString().getSize(); i++) {
-                        sf::Vector2f charPos = text.findCharacterPos(i);
-                        float charHeight = text.getCharacterSize();
+                int bestIndex = text.findCharacterAt(worldPos);
 
-                        if (worldPos.y >= charPos.y && worldPos.y < charPos.y + charHeight) {
-                            float dist = std::abs(worldPos.x - charPos.x);
+                if (bestIndex != -1 && blockDragging) {
+                    selectBlock(gapBuffer, selectionAnchor, carets, blockAnchor,
+                                rawOffsetOfDisplayGlyph(state, gapBuffer, static_cast<size_t>(bestIndex)));
+                } else if (bestIndex != -1) {
+                    gapBuffer.moveTo(rawOffsetOfDisplayGlyph(state, gapBuffer, static_cast<size_t>(bestIndex)));
+                }
 
-                            if (dist < bestDistance) {
-                                bestDistance = dist;
-                                bestIndex = static_cast<int>(i);
-                            }
-                        }
-                    }
+                cursorMovedThisFrame = true;
+            }
+        }
 
-                    if (bestIndex != -1) {
-                        gapBuffer.moveTo(bestIndex);
-                    }
+        if (const auto* mouseEvent = event.getIf<sf::Event::MouseButtonReleased>()) {
+            if (mouseEvent->button == sf::Mouse::Button::Left) {
+                if (mouseState == MouseState::Pressed) {
+                    selectionAnchor = -1;
+                }
+                if (mouseState == MouseState::ScrollbarDragging) {
+                    scrollbar.handleMouseRelease();
+                }
+                mouseState = MouseState::Idle;
+                blockDragging = false;
+            }
+        }
 
-                    cursorMovedThisFrame = true;
+        if (const auto* scrollEvent = event.getIf<sf::Event::MouseWheelScrolled>()) {
+            if (scrollEvent->wheel == sf::Mouse::Wheel::Vertical) {
+                float delta = scrollEvent->delta * 30.f;
+                // The wheel scrolls whichever pane is under the mouse
+                if (inBottomPane(scrollEvent->position.y) != bottomFocused) {
+                    sf::FloatRect bounds = documentBounds();
+                    float maxScroll = bounds.position.y + bounds.size.y -
+                                      (TOP_MARGIN + paneTextHeight(!bottomFocused)) + SCROLL_PADDING;
+                    otherPane.scrollOffset = std::clamp(otherPane.scrollOffset - delta, 0.f,
+                                                        std::max(0.f, maxScroll));
+                    dirty |= DirtyChrome;
+                } else {
+                    scrollbar.setScrollOffset(scrollbar.getScrollOffset() - delta);
                 }
             }
+        }
+    };
 
-            if (const auto* mouseEvent = event->getIf<sf::Event::MouseButtonReleased>()) {
-                if (mouseEvent->button == sf::Mouse::Button::Left) {
-                    if (mouseState == MouseState::Pressed) {
-                        selectionAnchor = -1;
-                    }
-                    if (mouseState == MouseState::ScrollbarDragging) {
-                        scrollbar.handleMouseRelease();
+    // Events are gathered for the whole frame and handled together, so bursts
+    // collapse: a run of typed characters is inserted with one insertString,
+    // repeated Left/Right presses move the gap once, and of consecutive mouse
+    // moves only the last is hit-tested. Runs are only merged outside the
+    // close prompt and search dialog, which take input one event at a time.
+    std::vector<sf::Event> frameEvents;
+    std::string typedRun;
+    auto isTyped = [](const sf::Event& event) {
+        const auto* textEvent = event.getIf<sf::Event::TextEntered>();
+        return textEvent && textEvent->unicode != '\b' && textEvent->unicode != 127;
+    };
+    // Key events that edit nothing: SFML sends a KeyPressed before every
+    // TextEntered (key repeat included) and KeyReleased in between, so these
+    // must not end a typed run. They are still handled, after the run.
+    auto isPassiveKey = [](const sf::Event& event) {
+        if (event.is<sf::Event::KeyReleased>()) return true;
+        const auto* keyEvent = event.getIf<sf::Event::KeyPressed>();
+        if (!keyEvent || keyEvent->control || keyEvent->system) return false;
+        switch (keyEvent->code) {
+            case sf::Keyboard::Key::Left:
+            case sf::Keyboard::Key::Right:
+            case sf::Keyboard::Key::Up:
+            case sf::Keyboard::Key::Down:
+            case sf::Keyboard::Key::Backspace:
+            case sf::Keyboard::Key::Delete:
+            case sf::Keyboard::Key::Escape:
+                return false;
+            default:
+                return true;
+        }
+    };
+    std::vector<size_t> passiveKeys;
+    auto horizontalKey = [](const sf::Event& event) -> const sf::Event::KeyPressed* {
+        const auto* keyEvent = event.getIf<sf::Event::KeyPressed>();
+        bool horizontal = keyEvent && (keyEvent->code == sf::Keyboard::Key::Left ||
+                                       keyEvent->code == sf::Keyboard::Key::Right);
+        return horizontal ? keyEvent : nullptr;
+    };
+    auto handleFrameEvents = [&]() {
+        for (size_t i = 0; i < frameEvents.size();) {
+            const sf::Event& event = frameEvents[i];
+            size_t end = i + 1;
+            bool mergeable = !showCloseConfirm && !searchDialog.getIsVisible();
+
+            if (event.is<sf::Event::MouseMoved>()) {
+                while (end < frameEvents.size() && frameEvents[end].is<sf::Event::MouseMoved>()) end++;
+                handleEvent(frameEvents[end - 1]);
+            } else if (mergeable && isTyped(event)) {
+                typedRun = utf8::encode(event.getIf<sf::Event::TextEntered>()->unicode);
+                passiveKeys.clear();
+                while (end < frameEvents.size()) {
+                    if (isTyped(frameEvents[end])) {
+                        typedRun += utf8::encode(frameEvents[end].getIf<sf::Event::TextEntered>()->unicode);
+                    } else if (isPassiveKey(frameEvents[end])) {
+                        passiveKeys.push_back(end);
+                    } else {
+                        break;
                     }
-                    mouseState = MouseState::Idle;
+                    end++;
                 }
+                dirty |= DirtyCursor | DirtyStatus | DirtyChrome;
+                typeText(typedRun);
+                for (size_t passive : passiveKeys) {
+                    handleEvent(frameEvents[passive]);
+                }
+            } else if (const auto* keyEvent = mergeable ? horizontalKey(event) : nullptr) {
+                while (end < frameEvents.size()) {
+                    const auto* next = horizontalKey(frameEvents[end]);
+                    if (!next || next->code != keyEvent->code || next->shift != keyEvent->shift) break;
+                    end++;
+                }
+                dirty |= DirtyCursor | DirtyStatus | DirtyChrome;
+                moveCursorHorizontal(keyEvent->code == sf::Keyboard::Key::Right, keyEvent->shift, end - i);
+            } else {
+                handleEvent(event);
+            }
+            i = end;
+        }
+        frameEvents.clear();
+    };
+
+    // Replayed events wait here from the moment they are handled until the
+    // frame that shows them has been presented
+    sf::Clock traceClock;
+    size_t replayNext = 0;
+    std::vector<std::chrono::steady_clock::time_point> replayInFlight;
+    std::vector<double> replayLatenciesUs;
+    int exitCode = 0;
+
+    // Typing and key presses are timed from the moment they are polled
+    auto noteArrival = [&](const sf::Event& event) {
+        if (event.is<sf::Event::TextEntered>()) {
+            latency.eventArrived(LatencyTracker::Text);
+        } else if (event.is<sf::Event::KeyPressed>()) {
+            latency.eventArrived(LatencyTracker::Key);
+        }
+    };
+
+    // Everything handled so far is on screen, or needed no redraw
+    auto eventsPresented = [&]() {
+        auto now = std::chrono::steady_clock::now();
+        latency.framePresented(now);
+        for (const auto& handled : replayInFlight) {
+            replayLatenciesUs.push_back(std::chrono::duration<double, std::micro>(now - handled).count());
+        }
+        replayInFlight.clear();
+
+        if (replaying && replayNext == replayEvents.size()) {
+            LatencySummary summary = summarizeLatencies(replayLatenciesUs);
+            std::cout << "Replayed " << summary.count << " events: p50 " << summary.p50Us
+                      << " us, p99 " << summary.p99Us << " us, max " << summary.maxUs << " us\n";
+            if (summary.p99Us > latency.getBudgetMs() * 1000.0) {
+                std::cout << "p99 is over the " << latency.getBudgetMs() << " ms latency budget\n";
+                exitCode = 1;
             }
+            replaying = false;
+            window.close();
+        }
+    };
 
-            if (const auto* scrollEvent = event->getIf<sf::Event::MouseWheelScrolled>()) {
-                if (scrollEvent->wheel == sf::Mouse::Wheel::Vertical) {
-                    float delta = scrollEvent->delta * 30.f;
-                    scrollbar.setScrollOffset(scrollbar.getScrollOffset() - delta);
+    while (window.isOpen()) {
+        cursorMovedThisFrame = false;
+
+        // Background work and key repeat need regular ticks; an idle editor
+        // only wakes for input and the cursor blink
+        std::optional<sf::Event> firstEvent;
+        if (dirty == 0) {
+            bool ticking = fileLoader.isActive() || fileSaver.isBusy() ||
+                           largeFile.isIndexing() || verticalKeyHeld;
+            sf::Time untilBlink = CURSOR_BLINK_INTERVAL - cursorBlinkClock.getElapsedTime();
+            sf::Time timeout = ticking ? sf::milliseconds(33) : std::max(untilBlink, sf::milliseconds(1));
+            if (replayNext < replayEvents.size()) {
+                sf::Time untilReplay = sf::microseconds(static_cast<std::int64_t>(replayEvents[replayNext].timeUs)) -
+                                       traceClock.getElapsedTime();
+                timeout = std::min(timeout, std::max(untilReplay, sf::milliseconds(1)));
+            }
+            firstEvent = window.waitEvent(timeout);
+        }
+        // Idle time spent waiting is not part of the frame
+        profiler.beginFrame();
+        frameArena.reset();
+
+        for (std::optional<sf::Event> event = firstEvent ? std::move(firstEvent) : window.pollEvent();
+             event; event = window.pollEvent()) {
+            if (traceWriter.isOpen()) {
+                if (auto record = toTraceEvent(*event, traceClock.getElapsedTime().asMicroseconds())) {
+                    traceWriter.write(*record);
                 }
             }
+            noteArrival(*event);
+            frameEvents.push_back(std::move(*event));
         }
 
-        // Vertical arrow key handling with repeat
-        static sf::Clock verticalMoveClock;
-        static bool verticalKeyHeld = false;
+        // Replayed events are handled once their recorded time has come
+        while (replayNext < replayEvents.size() &&
+               replayEvents[replayNext].timeUs <= static_cast<std::uint64_t>(traceClock.getElapsedTime().asMicroseconds())) {
+            if (auto event = toSfmlEvent(replayEvents[replayNext])) {
+                replayInFlight.push_back(std::chrono::steady_clock::now());
+                noteArrival(*event);
+                frameEvents.push_back(std::move(*event));
+            }
+            replayNext++;
+        }
+        handleFrameEvents();
 
+        // Vertical arrow key handling with repeat
         const sf::Time initialDelay = sf::milliseconds(250);
         const sf::Time repeatDelay = sf::milliseconds(60);
 
-        bool upHeld = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Up);
-        bool downHeld = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Down);
-
         if (upHeld || downHeld) {
             if (!verticalKeyHeld) {
-                moveCursorVertical(gapBuffer, text, font, downHeld);
+                moveCursorVertical(gapBuffer, state, text, font, downHeld);
                 cursorMovedThisFrame = true;
                 verticalMoveClock.restart();
                 verticalKeyHeld = true;
@@ -645,7 +1309,7 @@ int main() {
                 sf::Time needed = (elapsed < initialDelay) ? initialDelay : repeatDelay;
 
                 if (elapsed >= needed) {
-                    moveCursorVertical(gapBuffer, text, font, downHeld);
+                    moveCursorVertical(gapBuffer, state, text, font, downHeld);
                     cursorMovedThisFrame = true;
                     verticalMoveClock.restart();
                 }
@@ -654,89 +1318,244 @@ int main() {
             verticalKeyHeld = false;
         }
 
+        profiler.mark(FrameProfiler::Input);
+
+        // Append whatever the loader has read since the last frame
+        if (fileLoader.isActive()) {
+            std::vector<std::string> chunks;
+            bool finished = fileLoader.poll(chunks);
+            // Appended, not inserted: the cursor may have moved since the load began
+            for (const std::string& chunk : chunks) {
+                gapBuffer.append(chunk);
+            }
+
+            if (!finished) {
+                statusBar.setProgress("Loading", fileLoader.getProgress(),
+                                      fileLoader.getBytesPerSecond(), "Esc to cancel");
+            } else if (fileLoader.getStatus() == AsyncFileLoader::Status::Done) {
+                statusBar.setMessage("");
+                // Replay edits that never made it to disk before a crash
+                if (EditJournal::recover(currentFileName, gapBuffer)) {
+                    unsavedChanges = true;
+                    statusBar.setMessage("Recovered unsaved changes");
+                    journal.begin(currentFileName, gapBuffer, false);
+                } else {
+                    journal.begin(currentFileName, gapBuffer, true);
+                }
+                updateWindowTitle();
+                documents.enforceBudget(gapBuffer.capacity());
+            } else {
+                std::string failedPath = fileLoader.getPath();
+                performNew();
+                statusBar.setMessage("Could not read " + failedPath);
+            }
+        }
+
+        // Pick up finished background saves
+        AsyncFileSaver::Result saved;
+        while (fileSaver.poll(saved)) {
+            if (!saved.ok) {
+                statusBar.setMessage("Could not save " + saved.path);
+                continue;
+            }
+            if (!fileSaver.isBusy()) {
+                statusBar.setMessage("");
+            }
+            // Edits made after the snapshot keep the document modified
+            if (saved.path == currentFileName && saved.version == gapBuffer.getVersion()) {
+                unsavedChanges = false;
+                journal.begin(currentFileName, gapBuffer, true);
+                updateWindowTitle();
+            } else {
+                // Saved just before its tab was switched away
+                documents.noteSaved(saved.path, saved.version);
+                tabsStale = true;
+            }
+        }
+
+        // Make journaled edits durable and keep the journal from growing unbounded
+        if (journalClock.getElapsedTime() >= sf::seconds(1.f)) {
+            journal.flush();
+            journal.maybeCheckpoint(gapBuffer);
+            traceWriter.flush();
+            latency.flushLog();
+            journalClock.restart();
+        }
+
         // Update search dialog
-        searchDialog.update();
+        if (searchDialog.update()) {
+            dirty |= DirtyChrome;
+        }
 
         // Cursor blinking logic
         if (cursorMovedThisFrame) {
             cursorVisible = true;
             cursorBlinkClock.restart();
+            dirty |= DirtyCursor | DirtyStatus;
         }
 
         if (cursorBlinkClock.getElapsedTime() >= CURSOR_BLINK_INTERVAL) {
             cursorVisible = !cursorVisible;
             cursorBlinkClock.restart();
+            dirty |= DirtyCursor;
         }
 
-        // Update text display with word wrapping
-        float textAreaWidth = static_cast<float>(window.getSize().x) - 25.f;
-        DisplayState state = wrapText(gapBuffer, text, textAreaWidth);
-        text.setString(state.content);
+        // Progress and indexing messages change while background work runs, and
+        // the frame after it finishes shows the final state
+        bool backgroundBusy = fileLoader.isActive() || fileSaver.isBusy() || largeFile.isIndexing();
+        if (backgroundBusy) {
+            dirty |= DirtyStatus | DirtyChrome;
+        } else if (backgroundWasBusy) {
+            dirty = DirtyAll;
+        }
+        backgroundWasBusy = backgroundBusy;
 
-        // Update cursor position
-        cursor.setPosition(text.findCharacterPos(state.cursorIndex));
-        sf::Vector2f cursorPos = cursor.getPosition();
-        float cursorHeight = cursor.getSize().y;
+        // Re-layout only when the text, wrap width, font size or (in large-file
+        // mode) the visible line range changed
+        float textAreaWidth = static_cast<float>(window.getSize().x) - 25.f;
+        float lineSpacing = font.getLineSpacing(text.getCharacterSize());
+        size_t topLine = largeFile.isOpen()
+            ? static_cast<size_t>(std::max(0.f, scrollbar.getScrollOffset()) / lineSpacing) : 0;
+        size_t paneTopLine = largeFile.isOpen() && splitView
+            ? static_cast<size_t>(otherPane.scrollOffset / lineSpacing) : 0;
+        if (gapBuffer.getVersion() != layoutVersion || textAreaWidth != layoutWidth ||
+            text.getCharacterSize() != layoutCharSize || largeFile.isOpen() != layoutLargeFile ||
+            topLine != largeFileTopLine || paneTopLine != otherTopLine || largeFile.isIndexing()) {
+            dirty |= DirtyText | DirtyCursor | DirtyStatus;
+        }
+        if (scrollbar.getScrollOffset() != drawnScrollOffset) {
+            dirty |= DirtyChrome;
+        }
 
-        // Draw search highlight (must be after wrapText + textView)
-        if (searchDialog.getIsVisible() && searchDialog.hasMatches()) {
-            int matchPos = static_cast<int>(searchDialog.getCurrentMatchPosition());
-            int matchLen = static_cast<int>(searchDialog.getMatchLength());
+        if (dirty == 0) {
+            eventsPresented();
+            continue;
+        }
+        profiler.mark(FrameProfiler::Background);
 
-            sf::Vector2f startPos = text.findCharacterPos(matchPos);
-            sf::Vector2f endPos   = text.findCharacterPos(matchPos + matchLen);
+        // Update text display with word wrapping
+        if (dirty & DirtyText) {
+            largeFileTopLine = topLine;
+            if (largeFile.isOpen()) {
+                // Only the lines under the viewport are paged in and laid out; the
+                // text is placed where those lines sit in the full document
+                size_t visibleLines = static_cast<size_t>(window.getSize().y / lineSpacing) + 2;
+                state = DisplayState{largeFile.getLines(largeFileTopLine, visibleLines), 0, {}};
+                text.setPosition({0, TOP_MARGIN + static_cast<float>(largeFileTopLine) * lineSpacing});
+                if (splitView) {
+                    otherTopLine = paneTopLine;
+                    otherText.setCharacterSize(text.getCharacterSize());
+                    otherText.setFillColor(text.getFillColor());
+                    otherText.setString(largeFile.getLines(otherTopLine, visibleLines));
+                    otherText.setPosition({0, TOP_MARGIN + static_cast<float>(otherTopLine) * lineSpacing});
+                }
+            } else {
+                wrapText(gapBuffer, text, textAreaWidth, state, frameArena);
+                text.setPosition({0, TOP_MARGIN});
+            }
+            // Only lines whose content changed get new vertices
+            text.setString(state.content);
 
-            searchHighlight.setPosition(startPos);
-            searchHighlight.setSize(sf::Vector2f(
-                std::max(2.f, endPos.x - startPos.x),
-                static_cast<float>(text.getCharacterSize())
-            ));
+            layoutVersion = gapBuffer.getVersion();
+            layoutWidth = textAreaWidth;
+            layoutCharSize = text.getCharacterSize();
+            layoutLargeFile = largeFile.isOpen();
+        }
 
-            window.draw(searchHighlight);
+        // Update cursor position
+        if ((dirty & DirtyCursor) && !largeFile.isOpen()) {
+            state.cursorIndex = displayGlyphIndex(state, gapBuffer, gapBuffer.getGapStart());
         }
+        cursor.setPosition(text.findCharacterPos(state.cursorIndex));
+        sf::Vector2f cursorPos = cursor.getPosition();
+        float cursorHeight = cursor.getSize().y;
 
         // Auto-scroll to cursor
         if (cursorMovedThisFrame) {
-            float windowHeight = static_cast<float>(window.getSize().y);
+            float paneHeight = TOP_MARGIN + paneTextHeight(bottomFocused);
             float topVisible = scrollbar.getScrollOffset() + TOP_MARGIN;
-            float bottomVisible = scrollbar.getScrollOffset() + windowHeight - SCROLL_PADDING;
+            float bottomVisible = scrollbar.getScrollOffset() + paneHeight - SCROLL_PADDING;
 
             if (cursorPos.y < topVisible) {
                 scrollbar.setScrollOffset(cursorPos.y - TOP_MARGIN);
             } else if (cursorPos.y + cursorHeight > bottomVisible) {
-                scrollbar.setScrollOffset((cursorPos.y + cursorHeight) - windowHeight + SCROLL_PADDING);
+                scrollbar.setScrollOffset((cursorPos.y + cursorHeight) - paneHeight + SCROLL_PADDING);
             }
         }
 
         // Clamp scroll to valid range
-        sf::FloatRect textBounds = text.getGlobalBounds();
-        scrollbar.clampScroll(window.getSize(), textBounds);
+        sf::FloatRect textBounds = documentBounds();
+        scrollbar.clampScroll(paneScrollSize(), textBounds);
+        profiler.mark(FrameProfiler::Layout);
 
         // Update UI
-        statusBar.update(gapBuffer, unsavedChanges, selectionAnchor, text.getCharacterSize());
+        if (dirty & DirtyStatus) {
+            if (largeFile.isOpen()) {
+                statusBar.updateLargeFile(largeFileTopLine + 1, largeFile.getEstimatedLineCount(),
+                                          largeFile.getFileSize(), text.getCharacterSize());
+                std::optional<size_t> invalidUtf8 = largeFile.getInvalidUtf8Offset();
+                if (largeFile.isIndexing()) {
+                    statusBar.setMessage("Indexing " +
+                        std::to_string(static_cast<int>(largeFile.getIndexProgress() * 100)) + "%");
+                } else if (invalidUtf8) {
+                    statusBar.setMessage("Not valid UTF-8 at byte " + std::to_string(*invalidUtf8));
+                } else {
+                    statusBar.setMessage(std::to_string(largeFile.getWordCount()) + " words");
+                }
+            } else {
+                statusBar.update(gapBuffer, unsavedChanges, selectionAnchor, text.getCharacterSize());
+            }
+        }
+
+        profiler.mark(FrameProfiler::Status);
+
+        // Everything is drawn each frame that is drawn at all; the flags above
+        // decide which of the expensive updates run before it
         window.clear(theme.windowBg());
+        drawnScrollOffset = scrollbar.getScrollOffset();
 
-        // Set text view with scroll offset
-        textView.setCenter(
-            sf::Vector2f(
-                static_cast<float>(window.getSize().x) / 2.f,
-                (static_cast<float>(window.getSize().y) / 2.f) + scrollbar.getScrollOffset()
-            )
-        );
+        // Set the pane views from their scroll offsets
+        updatePaneViews();
         window.setView(textView);
 
+        // Colour the display lines each pane shows; lines already in their
+        // colours are skipped
+        if (!largeFile.isOpen()) {
+            for (int pane = 0; pane < (splitView ? 2 : 1); pane++) {
+                const sf::View& view = pane == 0 ? textView : otherView;
+                float top = view.getCenter().y - view.getSize().y / 2.f - text.getPosition().y;
+                auto first = static_cast<size_t>(std::max(0.f, top) / lineSpacing);
+                auto last = static_cast<size_t>(std::max(0.f, top + view.getSize().y) / lineSpacing) + 2;
+                applyHighlighting(text, state, gapBuffer, highlighter, theme, first, last, colorSpans);
+            }
+        }
+
         // Draw selection highlighting
 
-        drawSelection(window, text, font, selectionAnchor, gapBuffer.getGapStart());
+        // Selection endpoints are byte offsets; glyph lookups need display indices
+        int anchorGlyph = selectionAnchor == -1
+            ? -1 : static_cast<int>(displayGlyphIndex(state, gapBuffer, selectionAnchor));
+        drawSelection(window, text, font, anchorGlyph, static_cast<int>(state.cursorIndex), selectionQuads);
+        // Every cursor's selection goes into one vertex array, a rectangle per row
+        caretSelectionQuads.clear();
+        for (const Caret& caret : carets) {
+            if (caret.anchor == -1) continue;
+            appendSelection(caretSelectionQuads, text, font, displayGlyphIndex(state, gapBuffer, caret.anchor),
+                            displayGlyphIndex(state, gapBuffer, caret.position));
+        }
+        if (caretSelectionQuads.getVertexCount() > 0) {
+            window.draw(caretSelectionQuads);
+        }
 
         // Draw search result highlighting
+        profiler.mark(FrameProfiler::Draw);
         if (searchDialog.hasMatches() && searchDialog.getIsVisible()) {
             size_t rawMatchPos = searchDialog.getCurrentMatchPosition();
             size_t rawMatchLen = searchDialog.getMatchLength();
 
             // Convert raw buffer positions to display positions (accounting for word wrap)
-            size_t displayMatchPos = mapRawToDisplay(gapBuffer.getString(), rawMatchPos, text, textAreaWidth);
-            size_t displayMatchEnd = mapRawToDisplay(gapBuffer.getString(), rawMatchPos + rawMatchLen, text, textAreaWidth);
+            size_t displayMatchPos = displayGlyphIndex(state, gapBuffer, rawMatchPos);
+            size_t displayMatchEnd = displayGlyphIndex(state, gapBuffer, rawMatchPos + rawMatchLen);
 
             // Draw highlight for each character in the match
             for (size_t i = displayMatchPos; i < displayMatchEnd; i++) {
@@ -756,10 +1575,38 @@ int main() {
             }
         }
 
+        profiler.mark(FrameProfiler::Search);
+
         // Draw text and cursor
         window.draw(text);
         if (cursorVisible && !searchDialog.getIsVisible()) {
             window.draw(cursor);
+            caretShape.setSize(cursor.getSize());
+            caretShape.setFillColor(cursor.getFillColor());
+            for (const Caret& caret : carets) {
+                caretShape.setPosition(text.findCharacterPos(displayGlyphIndex(state, gapBuffer, caret.position)));
+                window.draw(caretShape);
+            }
+        }
+
+        // The other pane draws the same layout through its own view, which
+        // submits only the lines inside it; its cursor doesn't blink
+        if (splitView) {
+            window.setView(otherView);
+            if (largeFile.isOpen()) {
+                window.draw(otherText);
+            } else {
+                size_t otherCursorGlyph = displayGlyphIndex(state, gapBuffer, otherPane.cursor);
+                int otherAnchorGlyph = otherPane.selectionAnchor == -1
+                    ? -1 : static_cast<int>(displayGlyphIndex(state, gapBuffer, otherPane.selectionAnchor));
+                drawSelection(window, text, font, otherAnchorGlyph, static_cast<int>(otherCursorGlyph),
+                              otherSelectionQuads);
+                window.draw(text);
+                otherCursor.setSize(cursor.getSize());
+                otherCursor.setFillColor(theme.dimText());
+                otherCursor.setPosition(text.findCharacterPos(otherCursorGlyph));
+                window.draw(otherCursor);
+            }
         }
 
         // Switch to UI view for drawing UI elements
@@ -768,11 +1615,31 @@ int main() {
         // Draw scrollbar
         scrollbar.draw(window, textBounds, TOP_MARGIN);
 
+        if (splitView) {
+            splitDividerLine.setSize(sf::Vector2f(static_cast<float>(window.getSize().x), 2.f));
+            splitDividerLine.setPosition(sf::Vector2f(0.f, splitDivider() - 1.f));
+            splitDividerLine.setFillColor(theme.panelOut());
+            window.draw(splitDividerLine);
+        }
+
         // Draw header background
-        sf::RectangleShape headerBg(sf::Vector2f(static_cast<float>(window.getSize().x), TOP_MARGIN));
+        headerBg.setSize(sf::Vector2f(static_cast<float>(window.getSize().x), TOP_MARGIN));
         headerBg.setFillColor(theme.headerBg());
         window.draw(headerBg);
 
+        if (tabsStale) {
+            tabLabels.resize(documents.count());
+            for (size_t i = 0; i < documents.count(); i++) {
+                bool isActive = i == documents.getActive();
+                const std::string& path = isActive ? currentFileName : documents.at(i).path;
+                bool modified = isActive ? unsavedChanges : documents.at(i).modified;
+                tabLabels[i] = path.substr(path.find_last_of("/\\") + 1) + (modified ? " *" : "");
+            }
+            tabBar.setTabs(tabLabels, documents.getActive());
+            tabsStale = false;
+        }
+        tabBar.draw(window);
+
         // Draw file dropdown menu (drawn last so it appears on top of the header)
         fileMenu.draw(window);
 
@@ -860,9 +1727,26 @@ int main() {
         // Draw status bar at the bottom
         statusBar.draw(window, theme);
 
+        if (profiler.isEnabled()) {
+            profilerOverlay.draw(window, profiler, latency, fontCache, TOP_MARGIN + 10.f);
+        }
+        profiler.mark(FrameProfiler::Draw);
+
         window.display();
-        cursorMovedThisFrame = false;
+        profiler.mark(FrameProfiler::Present);
+        profiler.endFrame();
+        eventsPresented();
+        dirty = 0;
     }
 
-    return 0;
+    // The window only closes once changes are saved or the user chose to drop them
+    journal.discard();
+    for (size_t i = 0; i < documents.count(); i++) {
+        if (i != documents.getActive() && documents.at(i).modified) {
+            const DocumentSet::Document& document = documents.at(i);
+            std::remove((document.path == "Untitled" ? EditJournal::untitledJournalPath(document.untitledId)
+                                                     : EditJournal::journalPathFor(document.path)).c_str());
+        }
+    }
+    return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+//
+// AllocationCounter.cpp - Counting replacements for the global operator new/delete
+//
+
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<std::uint64_t> allocations{0};
+std::atomic<std::uint64_t> bytes{0};
+
+void countAllocation(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+// posix_memalign memory is released with free(), like malloc's
+void* alignedAlloc(std::size_t size, std::align_val_t alignment) {
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+    void* p = nullptr;
+    return posix_memalign(&p, align, size) == 0 ? p : nullptr;
+}
+
+// As the standard operator new does: while allocation fails the installed
+// new-handler gets to free memory and retry, and without one it throws
+template <typename Allocate>
+void* allocateOrThrow(Allocate allocate) {
+    for (;;) {
+        if (void* p = allocate()) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+}
+
+// The standard library's array forms forward to the scalar ones below, so
+// every form of new is counted; the nothrow forms are replaced as well rather
+// than relying on them forwarding too
+void* operator new(std::size_t size) {
+    countAllocation(size);
+    return allocateOrThrow([size] { return std::malloc(size ? size : 1); });
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    countAllocation(size);
+    return allocateOrThrow([size, alignment] { return alignedAlloc(size ? size : 1, alignment); });
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size, alignment);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+std::uint64_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t allocatedBytes() {
+    return bytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,21 @@
+//
+// AllocationCounter.h - Process-wide heap allocation counts
+//
+// AllocationCounter.cpp replaces the global operator new/delete, including the
+// aligned and nothrow forms; malloc called directly is not counted. It is built
+// as the editor_alloc_counter object library and linked only into the programs
+// that report allocations (the editor and editor_bench), so editor_core and its
+// other users keep the standard allocator.
+//
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// Calls to operator new since the program started
+std::uint64_t allocationCount();
+// Bytes requested from operator new since the program started
+std::uint64_t allocatedBytes();
+
+#endif //ALLOCATIONCOUNTER_H
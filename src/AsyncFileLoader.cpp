@@ -0,0 +1,139 @@
+//
+// AsyncFileLoader.cpp - Implementation of the background file loader
+//
+
+#include "AsyncFileLoader.h"
+#include <filesystem>
+#include <fstream>
+
+AsyncFileLoader::~AsyncFileLoader() {
+    cancel();
+}
+
+bool AsyncFileLoader::start(const std::string& filePath) {
+    cancel();
+
+    std::ifstream probe(filePath, std::ios::binary);
+    if (!probe.is_open()) {
+        status = Status::Failed;
+        return false;
+    }
+    probe.close();
+
+    path = filePath;
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(filePath, ec);
+    totalBytes = ec ? 0 : static_cast<std::size_t>(size);
+    bytesRead = 0;
+    cancelRequested = false;
+    pending.clear();
+    status = Status::Loading;
+    active = true;
+    startTime = std::chrono::steady_clock::now();
+
+    worker = std::thread(&AsyncFileLoader::readLoop, this);
+    return true;
+}
+
+void AsyncFileLoader::cancel() {
+    if (status == Status::Loading) {
+        cancelRequested = true;
+    }
+    join();
+    if (active) {
+        status = Status::Cancelled;
+    }
+    active = false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+}
+
+void AsyncFileLoader::join() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void AsyncFileLoader::readLoop() {
+    std::ifstream inputFile(path, std::ios::binary);
+    if (!inputFile.is_open()) {
+        status = Status::Failed;
+        return;
+    }
+
+    while (!cancelRequested) {
+        std::string chunk(CHUNK_SIZE, '\0');
+        inputFile.read(&chunk[0], static_cast<std::streamsize>(chunk.size()));
+        std::size_t got = static_cast<std::size_t>(inputFile.gcount());
+        if (got == 0) break;
+        chunk.resize(got);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(chunk));
+        }
+        bytesRead += got;
+    }
+
+    if (cancelRequested) {
+        status = Status::Cancelled;
+    } else if (inputFile.bad()) {
+        status = Status::Failed;
+    } else {
+        status = Status::Done;
+    }
+}
+
+bool AsyncFileLoader::poll(std::vector<std::string>& out) {
+    if (!active) return false;
+
+    // Read the status before taking the chunks so a chunk pushed between the
+    // two steps is never mistaken for "all delivered"
+    Status current = status;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& chunk : pending) {
+            out.push_back(std::move(chunk));
+        }
+        pending.clear();
+    }
+
+    if (current == Status::Loading) {
+        return false;
+    }
+
+    join();
+    active = false;
+    return true;
+}
+
+bool AsyncFileLoader::isActive() const {
+    return active;
+}
+
+AsyncFileLoader::Status AsyncFileLoader::getStatus() const {
+    return status;
+}
+
+const std::string& AsyncFileLoader::getPath() const {
+    return path;
+}
+
+std::size_t AsyncFileLoader::getTotalBytes() const {
+    return totalBytes;
+}
+
+std::size_t AsyncFileLoader::getBytesRead() const {
+    return bytesRead;
+}
+
+double AsyncFileLoader::getProgress() const {
+    if (totalBytes == 0) return status == Status::Loading ? 0.0 : 1.0;
+    return static_cast<double>(bytesRead) / static_cast<double>(totalBytes);
+}
+
+double AsyncFileLoader::getBytesPerSecond() const {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return seconds > 0.0 ? static_cast<double>(bytesRead) / seconds : 0.0;
+}
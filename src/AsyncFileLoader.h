@@ -0,0 +1,65 @@
+//
+// AsyncFileLoader.h - Streams a file from disk on a worker thread
+//
+
+#ifndef ASYNCFILELOADER_H
+#define ASYNCFILELOADER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reads a file in large chunks on a worker thread. The UI thread polls for the
+// chunks read so far and appends them to its buffer, so the first screen can be
+// shown long before the whole file is in memory.
+class AsyncFileLoader {
+public:
+    enum class Status { Idle, Loading, Done, Failed, Cancelled };
+
+    static constexpr std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+    AsyncFileLoader() = default;
+    ~AsyncFileLoader();
+    AsyncFileLoader(const AsyncFileLoader&) = delete;
+    AsyncFileLoader& operator=(const AsyncFileLoader&) = delete;
+
+    // Starts loading path; cancels any load in progress. False if it cannot be opened.
+    bool start(const std::string& path);
+    void cancel();
+
+    // Moves the chunks read since the last call into `out`, in file order.
+    // Returns true once the final chunk has been handed over.
+    bool poll(std::vector<std::string>& out);
+
+    // True from start() until poll() has handed over the last chunk
+    bool isActive() const;
+    Status getStatus() const;
+    const std::string& getPath() const;
+
+    std::size_t getTotalBytes() const;
+    std::size_t getBytesRead() const;
+    double getProgress() const;          // 0..1
+    double getBytesPerSecond() const;
+
+private:
+    std::string path;
+    std::size_t totalBytes = 0;
+    std::atomic<std::size_t> bytesRead{0};
+    std::atomic<Status> status{Status::Idle};
+    std::atomic<bool> cancelRequested{false};
+    bool active = false;
+    std::chrono::steady_clock::time_point startTime;
+
+    std::mutex mutex;
+    std::vector<std::string> pending;
+    std::thread worker;
+
+    void readLoop();
+    void join();
+};
+
+#endif //ASYNCFILELOADER_H
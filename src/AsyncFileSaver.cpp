@@ -0,0 +1,124 @@
+//
+// AsyncFileSaver.cpp - Implementation of the background saver
+//
+
+#include "AsyncFileSaver.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+AsyncFileSaver::AsyncFileSaver() {
+    worker = std::thread(&AsyncFileSaver::run, this);
+}
+
+AsyncFileSaver::~AsyncFileSaver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void AsyncFileSaver::save(const std::string& path, GapBuffer::Snapshot snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Replaces any write that has not started yet
+        pending = Job{path, std::move(snapshot)};
+    }
+    wake.notify_one();
+}
+
+bool AsyncFileSaver::poll(Result& result) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (finished.empty()) return false;
+    result = std::move(finished.front());
+    finished.pop_front();
+    return true;
+}
+
+bool AsyncFileSaver::isBusy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writing || pending.has_value();
+}
+
+void AsyncFileSaver::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || pending.has_value(); });
+        if (!pending) {
+            return; // stopping with nothing left to write
+        }
+
+        Job job = std::move(*pending);
+        pending.reset();
+        writing = true;
+
+        lock.unlock();
+        bool ok = writeSnapshot(job.path, job.snapshot);
+        std::size_t version = job.snapshot.version;
+        job.snapshot.storage.reset(); // let the editor write in place again
+        lock.lock();
+
+        writing = false;
+        finished.push_back({job.path, version, ok});
+    }
+}
+
+static bool writeAll(int fd, const char* data, std::size_t len) {
+    while (len > 0) {
+        ssize_t written = ::write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        len -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool AsyncFileSaver::writeSnapshot(const std::string& linkPath, const GapBuffer::Snapshot& snapshot) {
+    // Replace the file a symlink points to, not the link itself
+    std::string path = linkPath;
+    char resolved[PATH_MAX];
+    if (::realpath(linkPath.c_str(), resolved)) {
+        path = resolved;
+    }
+
+    // A fresh name next to the file, so the rename stays on one filesystem and
+    // never truncates or follows something already there
+    std::string tempPath = path + ".XXXXXX";
+    int fd = ::mkstemp(&tempPath[0]);
+    if (fd < 0) return false;
+
+    // mkstemp creates the file 0600; the rename must not reset the permissions
+    // of an existing file, and a new one gets the usual 0644
+    struct stat existing;
+    mode_t mode = ::stat(path.c_str(), &existing) == 0 ? (existing.st_mode & 07777) : 0644;
+    bool ok = ::fchmod(fd, mode) == 0;
+
+    ok = ok && writeAll(fd, snapshot.before(), snapshot.gapStart) &&
+              writeAll(fd, snapshot.after(), snapshot.afterSize()) &&
+              ::fsync(fd) == 0;
+    ok = (::close(fd) == 0) && ok;
+
+    if (!ok || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    // Persist the rename itself
+    std::string::size_type slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    int dirFd = ::open(dir.c_str(), O_RDONLY);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+    return true;
+}
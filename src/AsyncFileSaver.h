@@ -0,0 +1,60 @@
+//
+// AsyncFileSaver.h - Writes buffer snapshots to disk on a background thread
+//
+
+#ifndef ASYNCFILESAVER_H
+#define ASYNCFILESAVER_H
+
+#include "GapBuffer.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+// Saves run on a worker thread from an O(1) GapBuffer snapshot. At most one
+// write is in flight; requests made meanwhile collapse into a single pending
+// write of the newest snapshot, so mashing Ctrl+S costs one extra write.
+class AsyncFileSaver {
+public:
+    struct Result {
+        std::string path;
+        std::size_t version = 0;   // buffer version that is now durable on disk
+        bool ok = false;
+    };
+
+    AsyncFileSaver();
+    // Finishes any queued write before returning so quitting never loses a save
+    ~AsyncFileSaver();
+    AsyncFileSaver(const AsyncFileSaver&) = delete;
+    AsyncFileSaver& operator=(const AsyncFileSaver&) = delete;
+
+    void save(const std::string& path, GapBuffer::Snapshot snapshot);
+
+    // Pops the next finished write, if any
+    bool poll(Result& result);
+    bool isBusy() const;
+
+    // Writes to a temporary file, fsyncs it and renames it over path (over
+    // the target when path is a symlink), keeping the file's permissions
+    static bool writeSnapshot(const std::string& path, const GapBuffer::Snapshot& snapshot);
+
+private:
+    struct Job {
+        std::string path;
+        GapBuffer::Snapshot snapshot;
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::optional<Job> pending;
+    bool writing = false;
+    bool stopping = false;
+    std::deque<Result> finished;
+    std::thread worker;
+
+    void run();
+};
+
+#endif //ASYNCFILESAVER_H
@@ -0,0 +1,382 @@
+//
+// BatchedText.cpp - Implementation of the line-batched text drawable
+//
+
+#include "BatchedText.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+
+// Same quad layout as sf::Text, so glyphs land on identical pixels
+void appendGlyphQuad(sf::VertexArray& vertices, float x, float y, sf::Color color, const sf::Glyph& glyph) {
+    const float padding = 1.f;
+    float left   = x + glyph.bounds.position.x - padding;
+    float top    = y + glyph.bounds.position.y - padding;
+    float right  = x + glyph.bounds.position.x + glyph.bounds.size.x + padding;
+    float bottom = y + glyph.bounds.position.y + glyph.bounds.size.y + padding;
+
+    float u1 = static_cast<float>(glyph.textureRect.position.x) - padding;
+    float v1 = static_cast<float>(glyph.textureRect.position.y) - padding;
+    float u2 = static_cast<float>(glyph.textureRect.position.x + glyph.textureRect.size.x) + padding;
+    float v2 = static_cast<float>(glyph.textureRect.position.y + glyph.textureRect.size.y) + padding;
+
+    vertices.append({{left,  top},    color, {u1, v1}});
+    vertices.append({{right, top},    color, {u2, v1}});
+    vertices.append({{left,  bottom}, color, {u1, v2}});
+    vertices.append({{left,  bottom}, color, {u1, v2}});
+    vertices.append({{right, top},    color, {u2, v1}});
+    vertices.append({{right, bottom}, color, {u2, v2}});
+}
+
+} // namespace
+
+BatchedText::BatchedText(const sf::Font& font, unsigned int characterSize)
+    : font(&font), characterSize(characterSize) {
+    lines.emplace_back();
+    lines.back().hash = std::hash<std::string_view>()(std::string_view());
+    buildLine(lines.back());
+}
+
+float BatchedText::lineSpacing() const {
+    return font->getLineSpacing(characterSize);
+}
+
+float BatchedText::measure(const sf::Font& font, unsigned int characterSize, std::string_view utf8) {
+    float whitespace = font.getGlyph(U' ', characterSize, false).advance;
+    float x = 0.f;
+    char32_t previous = 0;
+
+    for (std::size_t i = 0; i < utf8.size();) {
+        std::size_t consumed;
+        char32_t cp = utf8::decode(utf8.data() + i, utf8.size() - i, consumed);
+        i += consumed;
+
+        x += font.getKerning(previous, cp, characterSize);
+        previous = cp;
+        if (cp == U' ') {
+            x += whitespace;
+        } else if (cp == U'\t') {
+            x += whitespace * 4;
+        } else {
+            x += font.getGlyph(cp, characterSize, false).advance;
+        }
+    }
+    return x;
+}
+
+void BatchedText::buildLine(Line& line) const {
+    line.builtSize = characterSize;
+    line.builtColor = fillColor;
+    line.colorKey = 0;
+
+    float whitespace = font->getGlyph(U' ', characterSize, false).advance;
+    float baseline = static_cast<float>(characterSize);
+    float x = 0.f;
+    char32_t previous = 0;
+
+    line.vertices.clear();
+    line.positions.clear();
+    line.positions.push_back(0.f);
+
+    const std::string& text = line.text;
+    for (std::size_t i = 0; i < text.size();) {
+        std::size_t consumed;
+        char32_t cp = utf8::decode(text.data() + i, text.size() - i, consumed);
+        i += consumed;
+
+        x += font->getKerning(previous, cp, characterSize);
+        previous = cp;
+
+        if (cp == U' ') {
+            x += whitespace;
+        } else if (cp == U'\t') {
+            x += whitespace * 4;
+        } else {
+            const sf::Glyph& glyph = font->getGlyph(cp, characterSize, false);
+            appendGlyphQuad(line.vertices, x, baseline, fillColor, glyph);
+            x += glyph.advance;
+        }
+        line.positions.push_back(x);
+    }
+}
+
+void BatchedText::rebuildAll() {
+    for (Line& line : lines) {
+        buildLine(line);
+    }
+    linesRebuilt = lines.size();
+    updateMetrics();
+}
+
+void BatchedText::updateMetrics() {
+    characterCount = 0;
+    width = 0.f;
+    for (Line& line : lines) {
+        line.firstGlyph = characterCount;
+        characterCount += line.positions.size(); // glyphs plus the '\n' that ends the line
+        width = std::max(width, line.positions.back());
+    }
+    characterCount--; // the last line has no '\n'
+}
+
+std::size_t BatchedText::cacheKey(std::size_t hash, unsigned int size, sf::Color color) {
+    std::size_t key = hash;
+    key ^= (static_cast<std::size_t>(size) + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2));
+    key ^= (static_cast<std::size_t>(color.toInteger()) + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2));
+    return key;
+}
+
+void BatchedText::retire(Line&& line) {
+    std::size_t key = cacheKey(line.hash, line.builtSize, line.builtColor);
+    auto found = cacheIndex.find(key);
+    if (found != cacheIndex.end()) {
+        cache.erase(found->second);
+    }
+    cache.push_front(std::move(line));
+    cacheIndex[key] = cache.begin();
+
+    if (cache.size() > LINE_CACHE_CAPACITY) {
+        const Line& oldest = cache.back();
+        cacheIndex.erase(cacheKey(oldest.hash, oldest.builtSize, oldest.builtColor));
+        cache.pop_back();
+    }
+}
+
+bool BatchedText::takeFromCache(std::string_view text, std::size_t hash, Line& out) {
+    auto found = cacheIndex.find(cacheKey(hash, characterSize, fillColor));
+    if (found == cacheIndex.end()) return false;
+
+    // Guard against key collisions
+    Line& cached = *found->second;
+    if (cached.text != text || cached.builtSize != characterSize || cached.builtColor != fillColor) {
+        return false;
+    }
+    out = std::move(cached);
+    cache.erase(found->second);
+    cacheIndex.erase(found);
+    return true;
+}
+
+void BatchedText::setString(std::string_view utf8) {
+    incoming.clear();
+    std::size_t start = 0;
+    while (true) {
+        std::size_t nl = utf8.find('\n', start);
+        if (nl == std::string_view::npos) {
+            incoming.push_back(utf8.substr(start));
+            break;
+        }
+        incoming.push_back(utf8.substr(start, nl - start));
+        start = nl + 1;
+    }
+
+    // Lines shared at the start and end keep their vertices; an edit usually
+    // leaves a small changed window in between
+    std::size_t common = std::min(lines.size(), incoming.size());
+    std::size_t prefix = 0;
+    while (prefix < common && lines[prefix].text == incoming[prefix]) {
+        prefix++;
+    }
+    std::size_t suffix = 0;
+    while (suffix < common - prefix &&
+           lines[lines.size() - 1 - suffix].text == incoming[incoming.size() - 1 - suffix]) {
+        suffix++;
+    }
+
+    std::vector<Line> updated = std::move(spareLines);
+    updated.clear();
+    updated.reserve(incoming.size());
+    std::size_t oldMiddle = lines.size() - suffix;
+    linesRebuilt = 0;
+    linesReused = 0;
+
+    for (std::size_t i = 0; i < prefix; i++) {
+        updated.push_back(std::move(lines[i]));
+    }
+
+    // Lines leaving the changed window are cached first, so content that only
+    // moved (or scrolled) is found again below
+    for (std::size_t i = prefix; i < oldMiddle; i++) {
+        retire(std::move(lines[i]));
+    }
+    for (std::size_t i = prefix; i < incoming.size() - suffix; i++) {
+        std::size_t hash = std::hash<std::string_view>()(incoming[i]);
+        Line line;
+        if (takeFromCache(incoming[i], hash, line)) {
+            linesReused++;
+        } else {
+            line.text.assign(incoming[i].data(), incoming[i].size());
+            line.hash = hash;
+            buildLine(line);
+            linesRebuilt++;
+        }
+        updated.push_back(std::move(line));
+    }
+
+    for (std::size_t i = oldMiddle; i < lines.size(); i++) {
+        updated.push_back(std::move(lines[i]));
+    }
+
+    // The old vector's storage becomes the next call's scratch
+    lines.swap(updated);
+    spareLines = std::move(updated);
+    spareLines.clear();
+    incoming.clear();
+    updateMetrics();
+}
+
+void BatchedText::setCharacterSize(unsigned int size) {
+    if (size == characterSize) return;
+    characterSize = size;
+    rebuildAll();
+}
+
+unsigned int BatchedText::getCharacterSize() const {
+    return characterSize;
+}
+
+void BatchedText::setFillColor(sf::Color color) {
+    if (color == fillColor) return;
+    fillColor = color;
+    for (Line& line : lines) {
+        for (std::size_t i = 0; i < line.vertices.getVertexCount(); i++) {
+            line.vertices[i].color = color;
+        }
+        line.builtColor = color;
+        line.colorKey = 0;
+    }
+}
+
+sf::Color BatchedText::getFillColor() const {
+    return fillColor;
+}
+
+const sf::Font& BatchedText::getFont() const {
+    return *font;
+}
+
+std::size_t BatchedText::getCharacterCount() const {
+    return characterCount;
+}
+
+std::size_t BatchedText::getLineCount() const {
+    return lines.size();
+}
+
+std::size_t BatchedText::getLinesRebuilt() const {
+    return linesRebuilt;
+}
+
+std::size_t BatchedText::getLinesReused() const {
+    return linesReused;
+}
+
+sf::Vector2f BatchedText::findCharacterPos(std::size_t index) const {
+    index = std::min(index, characterCount);
+
+    // Last line whose first glyph is at or before the index
+    auto it = std::upper_bound(lines.begin(), lines.end(), index,
+                               [](std::size_t value, const Line& line) { return value < line.firstGlyph; });
+    std::size_t lineIndex = static_cast<std::size_t>(it - lines.begin()) - 1;
+    const Line& line = lines[lineIndex];
+
+    std::size_t column = std::min(index - line.firstGlyph, line.positions.size() - 1);
+    sf::Vector2f local(line.positions[column], static_cast<float>(lineIndex) * lineSpacing());
+    return getTransform().transformPoint(local);
+}
+
+std::size_t BatchedText::getLineEnd(std::size_t index) const {
+    index = std::min(index, characterCount);
+    auto it = std::upper_bound(lines.begin(), lines.end(), index,
+                               [](std::size_t value, const Line& line) { return value < line.firstGlyph; });
+    const Line& line = *(it - 1);
+    return line.firstGlyph + line.positions.size() - 1;
+}
+
+void BatchedText::setLineColors(std::size_t index, const std::vector<ColorSpan>& spans) {
+    if (index >= lines.size()) return;
+    Line& line = lines[index];
+
+    std::size_t key = 0;
+    for (const ColorSpan& span : spans) {
+        key = cacheKey(key ^ span.start, static_cast<unsigned int>(span.length), span.color);
+    }
+    key |= spans.empty() ? 0 : 1;
+    if (key == line.colorKey) return;
+
+    // Whitespace has no quad, as in buildLine; every other glyph has six vertices
+    const std::string& text = line.text;
+    std::size_t vertex = 0;
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < text.size();) {
+        while (next < spans.size() && spans[next].start + spans[next].length <= i) next++;
+        bool inSpan = next < spans.size() && spans[next].start <= i;
+        sf::Color color = inSpan ? spans[next].color : fillColor;
+
+        std::size_t consumed;
+        char32_t cp = utf8::decode(text.data() + i, text.size() - i, consumed);
+        i += consumed;
+        if (cp == U' ' || cp == U'\t') continue;
+        for (std::size_t v = 0; v < 6 && vertex < line.vertices.getVertexCount(); v++) {
+            line.vertices[vertex++].color = color;
+        }
+    }
+    line.colorKey = key;
+}
+
+int BatchedText::findCharacterAt(sf::Vector2f point) const {
+    sf::Vector2f local = getInverseTransform().transformPoint(point);
+    if (local.y < 0.f) return -1;
+
+    float spacing = lineSpacing();
+    auto lineIndex = static_cast<std::size_t>(local.y / spacing);
+    if (lineIndex >= lines.size()) return -1;
+    // Only the glyph band of a line counts, as with the per-glyph search it replaces
+    if (local.y - static_cast<float>(lineIndex) * spacing >= static_cast<float>(characterSize)) return -1;
+
+    const Line& line = lines[lineIndex];
+    auto it = std::lower_bound(line.positions.begin(), line.positions.end(), local.x);
+    std::size_t column = static_cast<std::size_t>(it - line.positions.begin());
+    if (column == line.positions.size()) {
+        column--;
+    } else if (column > 0 && local.x - line.positions[column - 1] <= line.positions[column] - local.x) {
+        column--;
+    }
+    return static_cast<int>(line.firstGlyph + column);
+}
+
+sf::FloatRect BatchedText::getLocalBounds() const {
+    if (characterCount == 0) return sf::FloatRect();
+    float height = static_cast<float>(lines.size() - 1) * lineSpacing() + static_cast<float>(characterSize);
+    return sf::FloatRect(sf::Vector2f(0.f, 0.f), sf::Vector2f(width, height));
+}
+
+sf::FloatRect BatchedText::getGlobalBounds() const {
+    return getTransform().transformRect(getLocalBounds());
+}
+
+void BatchedText::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    states.transform *= getTransform();
+    states.texture = &font->getTexture(characterSize);
+
+    // Only lines inside the current view are submitted
+    const sf::View& view = target.getView();
+    sf::FloatRect visible(view.getCenter() - view.getSize() / 2.f, view.getSize());
+    visible = getInverseTransform().transformRect(visible);
+
+    float spacing = lineSpacing();
+    float top = std::max(0.f, visible.position.y);
+    float bottom = std::max(0.f, visible.position.y + visible.size.y);
+    auto first = static_cast<std::size_t>(top / spacing);
+    auto last = std::min(lines.size(), static_cast<std::size_t>(std::ceil(bottom / spacing)) + 1);
+
+    for (std::size_t i = first; i < last; i++) {
+        if (lines[i].vertices.getVertexCount() == 0) continue;
+        sf::RenderStates lineStates = states;
+        lineStates.transform.translate({0.f, static_cast<float>(i) * spacing});
+        target.draw(lines[i].vertices, lineStates);
+    }
+}
@@ -0,0 +1,107 @@
+//
+// BatchedText.h - Line-batched text drawable built from the font's glyph atlas
+//
+
+#ifndef BATCHEDTEXT_H
+#define BATCHEDTEXT_H
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Replacement for the sf::Text that shows the document. Every visual line owns
+// a vertex array of quads sampled from the font's glyph atlas, so setString()
+// only rebuilds the lines whose content changed; lines that merely moved up or
+// down are reused as-is. Lines that leave the text go to an LRU cache keyed by
+// content, font size and colour, so scrolling back over them (or paging a large
+// file) reuses their vertices without any layout work. Positions are indexed by
+// code point, like sf::Text.
+class BatchedText : public sf::Drawable, public sf::Transformable {
+public:
+    explicit BatchedText(const sf::Font& font, unsigned int characterSize = 30);
+
+    // UTF-8 text with lines separated by '\n'
+    void setString(std::string_view utf8);
+    void setCharacterSize(unsigned int size);
+    unsigned int getCharacterSize() const;
+    void setFillColor(sf::Color color);
+    sf::Color getFillColor() const;
+    const sf::Font& getFont() const;
+
+    // Code points in the string, counting each '\n'
+    std::size_t getCharacterCount() const;
+    std::size_t getLineCount() const;
+
+    sf::Vector2f findCharacterPos(std::size_t index) const;
+    // Index of the glyph boundary nearest to `point` on the line under it,
+    // or -1 if the point is not on a line
+    int findCharacterAt(sf::Vector2f point) const;
+    // Index of the '\n' (or the end of text) closing the line that holds `index`
+    std::size_t getLineEnd(std::size_t index) const;
+
+    // Bytes [start, start + length) of a line drawn in `color`
+    struct ColorSpan {
+        std::size_t start;
+        std::size_t length;
+        sf::Color color;
+    };
+    // Recolours the glyph vertices of one line in place, the rest in the
+    // fill colour; a line already holding these colours is left alone
+    void setLineColors(std::size_t line, const std::vector<ColorSpan>& spans);
+
+    sf::FloatRect getLocalBounds() const;
+    sf::FloatRect getGlobalBounds() const;
+
+    // Lines whose vertices were rebuilt by the last setString()
+    std::size_t getLinesRebuilt() const;
+    // Lines taken from the line cache by the last setString()
+    std::size_t getLinesReused() const;
+
+    // Advance width of a UTF-8 string in pixels, kerning included
+    static float measure(const sf::Font& font, unsigned int characterSize, std::string_view utf8);
+
+private:
+    struct Line {
+        std::string text;             // UTF-8, without the '\n'
+        std::size_t hash = 0;         // hash of text
+        std::vector<float> positions; // x of each glyph boundary; glyphs + 1 entries
+        sf::VertexArray vertices{sf::PrimitiveType::Triangles};
+        std::size_t firstGlyph = 0;   // index of the line's first code point
+        unsigned int builtSize = 0;   // character size and colour the vertices hold
+        sf::Color builtColor;
+        std::size_t colorKey = 0;     // hash of the spans set by setLineColors; 0 if none
+    };
+
+    // Enough for several screens of scrollback without holding on to much memory
+    static constexpr std::size_t LINE_CACHE_CAPACITY = 2048;
+
+    const sf::Font* font;
+    unsigned int characterSize;
+    sf::Color fillColor = sf::Color::White;
+    std::vector<Line> lines;
+    std::size_t characterCount = 0;
+    float width = 0.f;
+    std::size_t linesRebuilt = 0;
+    std::size_t linesReused = 0;
+    // Scratch kept between setString calls so their storage is reused
+    std::vector<std::string_view> incoming;
+    std::vector<Line> spareLines;
+
+    std::list<Line> cache;            // most recently retired first
+    std::unordered_map<std::size_t, std::list<Line>::iterator> cacheIndex;
+
+    float lineSpacing() const;
+    void buildLine(Line& line) const;
+    void rebuildAll();
+    void updateMetrics();
+    static std::size_t cacheKey(std::size_t hash, unsigned int size, sf::Color color);
+    void retire(Line&& line);
+    bool takeFromCache(std::string_view text, std::size_t hash, Line& out);
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
+
+#endif //BATCHEDTEXT_H
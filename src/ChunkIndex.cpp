@@ -0,0 +1,213 @@
+//
+// ChunkIndex.cpp - Implementation of the chunk summary tree
+//
+
+#include "ChunkIndex.h"
+#include "Utf8.h"
+#include <algorithm>
+
+ChunkSummary ChunkSummary::of(const char* data, std::size_t len) {
+    ChunkSummary s;
+    static_cast<TextCounts&>(s) = countText(std::string_view(data, len));
+    s.codePoints = utf8::countCodePoints(data, len);
+    return s;
+}
+
+ChunkSummary ChunkSummary::combine(const ChunkSummary& left, const ChunkSummary& right) {
+    if (left.bytes == 0) return right;
+    if (right.bytes == 0) return left;
+
+    ChunkSummary s;
+    static_cast<TextCounts&>(s) = TextCounts::combine(left, right);
+    s.codePoints = left.codePoints + right.codePoints;
+    return s;
+}
+
+void ChunkIndex::reset(std::size_t capacity) {
+    leafCount = std::max<std::size_t>(1, (capacity + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    leafBase = 1;
+    while (leafBase < leafCount) {
+        leafBase <<= 1;
+    }
+    tree.assign(2 * leafBase, ChunkSummary{});
+    dirtyBegin = 0;
+    dirtyEnd = leafCount;
+}
+
+void ChunkIndex::grow(std::size_t capacity) {
+    std::size_t count = std::max<std::size_t>(1, (capacity + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (count > leafBase) {
+        reset(capacity);
+        return;
+    }
+    // The old last chunk may have been partial
+    std::size_t oldCount = leafCount;
+    leafCount = count;
+    markDirty((oldCount - 1) * CHUNK_SIZE, capacity);
+}
+
+void ChunkIndex::markDirty(std::size_t begin, std::size_t end) {
+    if (begin >= end || leafCount == 0) return;
+
+    std::size_t first = begin / CHUNK_SIZE;
+    std::size_t last = std::min(leafCount, (end - 1) / CHUNK_SIZE + 1);
+    if (first >= last) return;
+
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = first;
+        dirtyEnd = last;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, first);
+        dirtyEnd = std::max(dirtyEnd, last);
+    }
+}
+
+ChunkSummary ChunkIndex::summarize(const StorageView& view, std::size_t begin, std::size_t end) const {
+    ChunkSummary s;
+    if (begin < view.gapStart) {
+        std::size_t stop = std::min(end, view.gapStart);
+        s = ChunkSummary::of(view.data + begin, stop - begin);
+    }
+    if (end > view.gapEnd) {
+        std::size_t start = std::max(begin, view.gapEnd);
+        s = ChunkSummary::combine(s, ChunkSummary::of(view.data + start, end - start));
+    }
+    return s;
+}
+
+void ChunkIndex::flush(const StorageView& view) {
+    if (dirtyBegin == dirtyEnd) return;
+
+    for (std::size_t leaf = dirtyBegin; leaf < dirtyEnd; leaf++) {
+        std::size_t begin = leaf * CHUNK_SIZE;
+        std::size_t end = std::min(begin + CHUNK_SIZE, view.capacity);
+        tree[leafBase + leaf] = begin < end ? summarize(view, begin, end) : ChunkSummary{};
+    }
+
+    // Rebuild only the ancestors of the recounted leaves
+    std::size_t lo = (leafBase + dirtyBegin) >> 1;
+    std::size_t hi = (leafBase + dirtyEnd - 1) >> 1;
+    while (lo > 0) {
+        for (std::size_t node = lo; node <= hi; node++) {
+            tree[node] = ChunkSummary::combine(tree[2 * node], tree[2 * node + 1]);
+        }
+        lo >>= 1;
+        hi >>= 1;
+    }
+
+    dirtyBegin = dirtyEnd = 0;
+}
+
+ChunkSummary ChunkIndex::total(const StorageView& view) {
+    flush(view);
+    return tree[1];
+}
+
+ChunkSummary ChunkIndex::prefix(const StorageView& view, std::size_t pos) {
+    return range(view, 0, pos);
+}
+
+ChunkSummary ChunkIndex::range(const StorageView& view, std::size_t begin, std::size_t end) {
+    flush(view);
+    if (begin >= end) return ChunkSummary{};
+
+    // Whole chunks [first, last) inside the range
+    std::size_t first = (begin + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::size_t last = std::min(end / CHUNK_SIZE, leafCount);
+    if (first >= last) {
+        return summarize(view, begin, end);
+    }
+
+    // Ordered fold over the whole chunks
+    ChunkSummary left, right;
+    for (std::size_t l = leafBase + first, r = leafBase + last; l < r; l >>= 1, r >>= 1) {
+        if (l & 1) left = ChunkSummary::combine(left, tree[l++]);
+        if (r & 1) right = ChunkSummary::combine(tree[--r], right);
+    }
+    ChunkSummary result = ChunkSummary::combine(left, right);
+
+    // Partial chunks at either end
+    if (begin < first * CHUNK_SIZE) {
+        result = ChunkSummary::combine(summarize(view, begin, first * CHUNK_SIZE), result);
+    }
+    if (last * CHUNK_SIZE < end) {
+        result = ChunkSummary::combine(result, summarize(view, last * CHUNK_SIZE, end));
+    }
+    return result;
+}
+
+std::size_t ChunkIndex::findCodePoint(const StorageView& view, std::size_t codePoint) {
+    flush(view);
+    if (codePoint >= tree[1].codePoints) {
+        return tree[1].bytes;
+    }
+
+    // Descend to the leaf holding the code point
+    std::size_t node = 1;
+    std::size_t offset = 0;
+    while (node < leafBase) {
+        std::size_t left = 2 * node;
+        if (tree[left].codePoints > codePoint) {
+            node = left;
+        } else {
+            codePoint -= tree[left].codePoints;
+            offset += tree[left].bytes;
+            node = left + 1;
+        }
+    }
+
+    // Scan the leaf, skipping the gap
+    std::size_t begin = (node - leafBase) * CHUNK_SIZE;
+    std::size_t end = std::min(begin + CHUNK_SIZE, view.capacity);
+    for (std::size_t p = begin; p < end; p++) {
+        if (p >= view.gapStart && p < view.gapEnd) {
+            p = view.gapEnd - 1;
+            continue;
+        }
+        if (!utf8::isContinuation(static_cast<unsigned char>(view.data[p]))) {
+            if (codePoint == 0) return offset;
+            codePoint--;
+        }
+        offset++;
+    }
+    return offset;
+}
+
+std::size_t ChunkIndex::findLineStart(const StorageView& view, std::size_t line) {
+    flush(view);
+    if (line == 0) return 0;
+    if (line > tree[1].newlines) {
+        return tree[1].bytes;
+    }
+
+    // Descend to the leaf holding the newline that ends the previous line
+    std::size_t newline = line - 1;
+    std::size_t node = 1;
+    std::size_t offset = 0;
+    while (node < leafBase) {
+        std::size_t left = 2 * node;
+        if (tree[left].newlines > newline) {
+            node = left;
+        } else {
+            newline -= tree[left].newlines;
+            offset += tree[left].bytes;
+            node = left + 1;
+        }
+    }
+
+    // Scan the leaf, skipping the gap
+    std::size_t begin = (node - leafBase) * CHUNK_SIZE;
+    std::size_t end = std::min(begin + CHUNK_SIZE, view.capacity);
+    for (std::size_t p = begin; p < end; p++) {
+        if (p >= view.gapStart && p < view.gapEnd) {
+            p = view.gapEnd - 1;
+            continue;
+        }
+        offset++;
+        if (view.data[p] == '\n') {
+            if (newline == 0) return offset;
+            newline--;
+        }
+    }
+    return offset;
+}
@@ -0,0 +1,74 @@
+//
+// ChunkIndex.h - Summary tree over fixed-size chunks of gap buffer storage
+//
+
+#ifndef CHUNKINDEX_H
+#define CHUNKINDEX_H
+
+#include "TextMetrics.h"
+#include <cstddef>
+#include <vector>
+
+// Read-only view of the raw gap buffer storage the index summarises
+struct StorageView {
+    const char* data;
+    std::size_t capacity;
+    std::size_t gapStart;
+    std::size_t gapEnd;
+};
+
+// Per-chunk statistics. Chunks are laid over *physical* storage, so the bytes
+// inside the gap are simply skipped and a gap move only touches the chunks the
+// moved bytes came from and went to. The byte, newline and word counts and
+// the boundary flags that let words straddle chunks come from TextCounts.
+struct ChunkSummary : TextCounts {
+    std::size_t codePoints = 0;
+
+    static ChunkSummary of(const char* data, std::size_t len);
+    static ChunkSummary combine(const ChunkSummary& left, const ChunkSummary& right);
+};
+
+class ChunkIndex {
+public:
+    static constexpr std::size_t CHUNK_SIZE = 4096;
+
+    // Drop all summaries and size the tree for `capacity` bytes of storage
+    void reset(std::size_t capacity);
+
+    // Storage grew at its end to `capacity` bytes; the new chunks are counted
+    // on the next query, and the tree is only rebuilt if it has to get deeper
+    void grow(std::size_t capacity);
+
+    // Physical byte range [begin, end) changed; recounted lazily on next query
+    void markDirty(std::size_t begin, std::size_t end);
+
+    // Totals for the whole document
+    ChunkSummary total(const StorageView& view);
+
+    // Statistics of all logical bytes stored before physical position `pos`
+    ChunkSummary prefix(const StorageView& view, std::size_t pos);
+
+    // Statistics of the logical bytes stored in physical positions
+    // [begin, end): whole chunks come from the tree, only the partial chunks
+    // at either end are counted
+    ChunkSummary range(const StorageView& view, std::size_t begin, std::size_t end);
+
+    // Logical byte offset of the code point with index `codePoint`
+    std::size_t findCodePoint(const StorageView& view, std::size_t codePoint);
+
+    // Logical byte offset where line `line` (0-based) starts, or the end of
+    // the text if it has fewer lines
+    std::size_t findLineStart(const StorageView& view, std::size_t line);
+
+private:
+    std::vector<ChunkSummary> tree;   // 1-based segment tree, leaves at [leafBase, 2*leafBase)
+    std::size_t leafBase = 1;
+    std::size_t leafCount = 0;
+    std::size_t dirtyBegin = 0;       // dirty leaf range [dirtyBegin, dirtyEnd)
+    std::size_t dirtyEnd = 0;
+
+    void flush(const StorageView& view);
+    ChunkSummary summarize(const StorageView& view, std::size_t begin, std::size_t end) const;
+};
+
+#endif //CHUNKINDEX_H
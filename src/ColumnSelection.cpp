@@ -0,0 +1,155 @@
+//
+// ColumnSelection.cpp - Implementation of column selection and paste
+//
+
+#include "ColumnSelection.h"
+#include "Utf8.h"
+#include <algorithm>
+
+namespace {
+
+// Start of the given column on the line starting at lineStart, or the line's
+// end if it is shorter; `columns` is set to how far it got
+std::size_t findColumn(const GapBuffer::Spans& spans, std::size_t lineStart, std::size_t column,
+                       std::size_t& columns) {
+    std::size_t size = spans.before.size() + spans.after.size();
+    auto byteAt = [&](std::size_t i) {
+        return i < spans.before.size() ? spans.before[i] : spans.after[i - spans.before.size()];
+    };
+    std::size_t offset = lineStart;
+    columns = 0;
+    while (columns < column && offset < size && byteAt(offset) != '\n') {
+        offset++;
+        while (offset < size && utf8::isContinuation(static_cast<unsigned char>(byteAt(offset)))) offset++;
+        columns++;
+    }
+    return offset;
+}
+
+// End of the line containing offset (its '\n', or the end of the text)
+std::size_t lineEndFrom(const GapBuffer::Spans& spans, std::size_t offset) {
+    if (offset < spans.before.size()) {
+        std::size_t nl = spans.before.find('\n', offset);
+        if (nl != std::string_view::npos) return nl;
+        offset = spans.before.size();
+    }
+    std::size_t nl = spans.after.find('\n', offset - spans.before.size());
+    return nl == std::string_view::npos ? spans.before.size() + spans.after.size() : spans.before.size() + nl;
+}
+
+} // namespace
+
+TextPosition positionOf(const GapBuffer& buffer, std::size_t offset) {
+    TextPosition position;
+    position.line = buffer.lineIndex(offset);
+    position.column = buffer.codePointIndex(offset) - buffer.codePointIndex(buffer.lineStart(position.line));
+    return position;
+}
+
+void selectBlock(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                 std::size_t anchorOffset, std::size_t cursorOffset) {
+    TextPosition anchor = positionOf(buffer, anchorOffset);
+    TextPosition cursor = positionOf(buffer, cursorOffset);
+    std::size_t firstLine = std::min(anchor.line, cursor.line);
+    std::size_t lastLine = std::max(anchor.line, cursor.line);
+    std::size_t leftColumn = std::min(anchor.column, cursor.column);
+    std::size_t rightColumn = std::max(anchor.column, cursor.column);
+    bool anchorOnLeft = anchor.column <= cursor.column;
+
+    GapBuffer::Spans spans = buffer.spans();
+    std::size_t size = buffer.size();
+    std::vector<Caret> all;
+    all.reserve(lastLine - firstLine + 1);
+
+    std::size_t lineStart = buffer.lineStart(firstLine);
+    for (std::size_t line = firstLine; line <= lastLine; line++) {
+        std::size_t columns;
+        std::size_t left = findColumn(spans, lineStart, leftColumn, columns);
+        std::size_t right = columns < leftColumn ? left : findColumn(spans, left, rightColumn - leftColumn, columns);
+
+        Caret caret;
+        caret.position = anchorOnLeft ? right : left;
+        if (left != right) {
+            caret.anchor = static_cast<int>(anchorOnLeft ? left : right);
+        }
+        all.push_back(caret);
+
+        std::size_t lineEnd = lineEndFrom(spans, right);
+        if (lineEnd == size) break;
+        lineStart = lineEnd + 1;
+    }
+    setCarets(buffer, selectionAnchor, carets, std::move(all));
+}
+
+void pasteColumn(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets, const std::string& utf8) {
+    std::vector<std::string_view> pieces;
+    std::string_view rest = utf8;
+    while (true) {
+        std::size_t nl = rest.find('\n');
+        pieces.push_back(rest.substr(0, nl));
+        if (nl == std::string_view::npos) break;
+        rest.remove_prefix(nl + 1);
+    }
+
+    TextPosition at = positionOf(buffer, buffer.getGapStart());
+    GapBuffer::Spans spans = buffer.spans();
+    std::size_t size = buffer.size();
+
+    // Texts are built first so the edits can point into them; lines past the
+    // end of the document become one insert there
+    std::vector<std::string> texts;
+    std::vector<std::size_t> offsets;
+    texts.reserve(pieces.size());
+    std::string tail;
+    std::vector<std::size_t> tailEnds;
+
+    std::size_t lineStart = buffer.lineStart(at.line);
+    bool pastEnd = false;
+    for (std::string_view piece : pieces) {
+        if (pastEnd) {
+            tail += '\n';
+            tail.append(at.column, ' ');
+            tail += piece;
+            tailEnds.push_back(tail.size());
+            continue;
+        }
+        std::size_t columns;
+        std::size_t offset = findColumn(spans, lineStart, at.column, columns);
+        // Short lines are padded out to the column, unless nothing goes there
+        std::string text(piece.empty() ? 0 : at.column - columns, ' ');
+        text += piece;
+        texts.push_back(std::move(text));
+        offsets.push_back(offset);
+
+        std::size_t lineEnd = lineEndFrom(spans, offset);
+        if (lineEnd == size) {
+            pastEnd = true;
+        } else {
+            lineStart = lineEnd + 1;
+        }
+    }
+
+    std::vector<GapBuffer::Edit> edits;
+    edits.reserve(texts.size() + 1);
+    for (std::size_t i = 0; i < texts.size(); i++) {
+        edits.push_back({offsets[i], 0, texts[i]});
+    }
+    if (!tail.empty()) {
+        edits.push_back({size, 0, tail});
+    }
+    buffer.applyEdits(edits);
+
+    // A cursor after each pasted line
+    std::vector<Caret> all;
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < texts.size(); i++) {
+        added += texts[i].size();
+        all.push_back({offsets[i] + added, -1});
+    }
+    for (std::size_t end : tailEnds) {
+        all.push_back({size + added + end, -1});
+    }
+    selectionAnchor = -1;
+    carets.clear();
+    setCarets(buffer, selectionAnchor, carets, std::move(all));
+}
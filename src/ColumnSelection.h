@@ -0,0 +1,37 @@
+//
+// ColumnSelection.h - Rectangular (column) selection and column paste
+//
+// A block of text is selected as one cursor per line, each selecting the
+// same range of character columns, so typing, deleting and copying a block
+// are the multi-cursor edits. Columns count code points from the line start.
+//
+
+#ifndef COLUMNSELECTION_H
+#define COLUMNSELECTION_H
+
+#include "GapBuffer.h"
+#include "MultiCursor.h"
+#include <string>
+#include <vector>
+
+// Line and column of a byte offset
+struct TextPosition {
+    std::size_t line = 0;
+    std::size_t column = 0;
+};
+TextPosition positionOf(const GapBuffer& buffer, std::size_t offset);
+
+// Selects the block with corners at anchorOffset and cursorOffset: the
+// columns between theirs on every line between theirs. Lines too short for
+// the block get an empty selection at their end. The line index finds the
+// first line, then the block's lines are read in one pass.
+void selectBlock(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                 std::size_t anchorOffset, std::size_t cursorOffset);
+
+// Pastes the lines of utf8 as a column: line i goes in at the cursor's
+// column on the i-th line below it, padding short lines with spaces and
+// adding lines past the end. All of it is one batched edit; a cursor is left
+// after each pasted line.
+void pasteColumn(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets, const std::string& utf8);
+
+#endif //COLUMNSELECTION_H
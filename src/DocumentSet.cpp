@@ -0,0 +1,145 @@
+//
+// DocumentSet.cpp - Implementation of the open document set
+//
+
+#include "DocumentSet.h"
+#include <algorithm>
+#include <memory>
+
+DocumentSet::DocumentSet() {
+    documents.emplace_back();
+}
+
+std::size_t DocumentSet::count() const {
+    return documents.size();
+}
+
+std::size_t DocumentSet::getActive() const {
+    return active;
+}
+
+const DocumentSet::Document& DocumentSet::at(std::size_t index) const {
+    return documents[index];
+}
+
+bool DocumentSet::anyModified() const {
+    for (std::size_t i = 0; i < documents.size(); i++) {
+        if (i != active && documents[i].modified) return true;
+    }
+    return false;
+}
+
+void DocumentSet::park(Document current) {
+    current.lastActive = ++clock;
+    if (current.largeFile) {
+        current.residency = Residency::Evicted;
+        current.text = GapBuffer::Snapshot{};
+    } else if (current.residency == Residency::Active) {
+        current.residency = current.text.storage ? Residency::Resident : Residency::Evicted;
+    }
+    documents[active] = std::move(current);
+}
+
+DocumentSet::Document DocumentSet::activate(std::size_t index, Document current) {
+    park(std::move(current));
+    active = index;
+    Document next = std::move(documents[active]);
+    documents[active] = Document{};
+    documents[active].path = next.path;
+    return next;
+}
+
+void DocumentSet::addAfterActive(Document current) {
+    park(std::move(current));
+    active++;
+    documents.insert(documents.begin() + static_cast<std::ptrdiff_t>(active), Document{});
+}
+
+DocumentSet::Document DocumentSet::closeActive() {
+    if (documents.size() == 1) {
+        documents[0] = Document{};
+        return Document{};
+    }
+    documents.erase(documents.begin() + static_cast<std::ptrdiff_t>(active));
+    active = std::min(active, documents.size() - 1);
+    Document next = std::move(documents[active]);
+    documents[active] = Document{};
+    documents[active].path = next.path;
+    return next;
+}
+
+void DocumentSet::noteSaved(const std::string& path, std::size_t version) {
+    for (std::size_t i = 0; i < documents.size(); i++) {
+        Document& document = documents[i];
+        if (i != active && document.modified && document.path == path && document.text.storage &&
+            document.text.version == version) {
+            document.modified = false;
+        }
+    }
+}
+
+void DocumentSet::setBudget(std::size_t bytes) {
+    budget = bytes;
+}
+
+std::size_t DocumentSet::getBudget() const {
+    return budget;
+}
+
+std::size_t DocumentSet::bytesOf(const Document& document) {
+    return document.text.storage ? document.text.storage->capacity() : 0;
+}
+
+std::size_t DocumentSet::getParkedBytes() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < documents.size(); i++) {
+        if (i != active) total += bytesOf(documents[i]);
+    }
+    return total;
+}
+
+void DocumentSet::compact(Document& document) {
+    const GapBuffer::Snapshot& text = document.text;
+    auto storage = std::make_shared<std::vector<char>>();
+    storage->reserve(text.size());
+    storage->insert(storage->end(), text.before(), text.before() + text.gapStart);
+    storage->insert(storage->end(), text.after(), text.after() + text.afterSize());
+
+    GapBuffer::Snapshot compacted;
+    compacted.storage = std::move(storage);
+    compacted.gapStart = compacted.gapEnd = text.size();
+    compacted.version = text.version;
+    document.text = std::move(compacted);
+    document.residency = Residency::Compacted;
+}
+
+void DocumentSet::enforceBudget(std::size_t activeBytes) {
+    std::size_t total = activeBytes + getParkedBytes();
+    if (total <= budget) return;
+
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < documents.size(); i++) {
+        if (i != active && documents[i].text.storage) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return documents[a].lastActive < documents[b].lastActive;
+    });
+
+    for (std::size_t i : order) {
+        if (total <= budget) return;
+        Document& document = documents[i];
+        if (document.residency != Residency::Resident) continue;
+        std::size_t before = bytesOf(document);
+        compact(document);
+        total -= before - bytesOf(document);
+    }
+
+    for (std::size_t i : order) {
+        if (total <= budget) return;
+        Document& document = documents[i];
+        if (document.modified || document.path == "Untitled") continue;
+        total -= bytesOf(document);
+        document.text = GapBuffer::Snapshot{};
+        document.residency = Residency::Evicted;
+    }
+}
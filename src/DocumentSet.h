@@ -0,0 +1,85 @@
+//
+// DocumentSet.h - Open documents (tabs) and the memory budget of the ones in
+// the background
+//
+// The active document is edited in place by the window (its GapBuffer, file
+// name and view state live there); every other tab is parked here. A parked
+// document's text is, from most to least memory:
+//   - resident:  the editor's own storage, gap included, shared copy-free
+//   - compacted: an exact-size copy without the gap or chunk index
+//   - evicted:   nothing; it is read back from its file when activated
+// When the total goes over budget, the least recently used tabs are compacted
+// first, then evicted if they are unmodified and backed by a file. Modified
+// and untitled documents are never evicted, and large files are always
+// evicted since their mapping can be recreated.
+//
+
+#ifndef DOCUMENTSET_H
+#define DOCUMENTSET_H
+
+#include "GapBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class DocumentSet {
+public:
+    enum class Residency { Active, Resident, Compacted, Evicted };
+
+    struct Document {
+        std::string path = "Untitled";
+        bool modified = false;
+        bool largeFile = false;         // opened through LargeFileView
+        unsigned untitledId = 0;        // names an untitled document's journal
+        std::size_t cursor = 0;
+        int selectionAnchor = -1;
+        float scrollOffset = 0.f;
+        Residency residency = Residency::Active;
+        GapBuffer::Snapshot text;       // empty unless resident or compacted
+        std::uint64_t lastActive = 0;   // for least-recently-used order
+    };
+
+    static constexpr std::size_t DEFAULT_BUDGET = 512ull * 1024 * 1024;
+
+    // Starts with one active, untitled document
+    DocumentSet();
+
+    std::size_t count() const;
+    std::size_t getActive() const;
+    const Document& at(std::size_t index) const;
+    bool anyModified() const;   // among the parked documents
+
+    // Parks `current` (the active document's state) in its slot and takes
+    // document `index` out to become active
+    Document activate(std::size_t index, Document current);
+    // Parks `current` and adds an untitled document after it as the active one
+    void addAfterActive(Document current);
+    // Drops the active document; returns the neighbour that becomes active.
+    // There is always at least one document, so with one left this returns
+    // a fresh untitled document in its place.
+    Document closeActive();
+
+    // Marks a parked document saved if it still is the version written
+    void noteSaved(const std::string& path, std::size_t version);
+
+    void setBudget(std::size_t bytes);
+    std::size_t getBudget() const;
+    // Compacts, then evicts, least recently used parked documents until
+    // they and activeBytes (the active document's storage) fit the budget
+    void enforceBudget(std::size_t activeBytes);
+    // Memory held by parked documents
+    std::size_t getParkedBytes() const;
+
+private:
+    std::vector<Document> documents;
+    std::size_t active = 0;
+    std::size_t budget = DEFAULT_BUDGET;
+    std::uint64_t clock = 0;
+
+    void park(Document current);
+    static std::size_t bytesOf(const Document& document);
+    static void compact(Document& document);
+};
+
+#endif //DOCUMENTSET_H
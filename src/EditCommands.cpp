@@ -0,0 +1,77 @@
+//
+// EditCommands.cpp - Cursor and selection edits shared by the window and
+// headless tools
+//
+
+#include "EditCommands.h"
+#include <algorithm>
+
+std::string selectedText(const GapBuffer& buffer, int selectionAnchor) {
+    if (selectionAnchor == -1) return "";
+    int cursorPos = static_cast<int>(buffer.getGapStart());
+    return buffer.getRange(std::min(selectionAnchor, cursorPos), std::max(selectionAnchor, cursorPos));
+}
+
+bool deleteSelection(GapBuffer& buffer, int& selectionAnchor) {
+    if (selectionAnchor == -1) return false;
+    int cursorPos = static_cast<int>(buffer.getGapStart());
+    int start = std::min(selectionAnchor, cursorPos);
+    int end = std::max(selectionAnchor, cursorPos);
+    selectionAnchor = -1;
+    if (start == end) return false;
+    buffer.deleteRange(start, end);
+    return true;
+}
+
+void insertAtCursor(GapBuffer& buffer, int& selectionAnchor, const std::string& utf8) {
+    deleteSelection(buffer, selectionAnchor);
+    buffer.insertString(utf8);
+}
+
+bool deleteBackward(GapBuffer& buffer, int& selectionAnchor) {
+    if (selectionAnchor != -1) {
+        return deleteSelection(buffer, selectionAnchor);
+    }
+    std::size_t before = buffer.size();
+    buffer.backspace();
+    return buffer.size() != before;
+}
+
+bool deleteForward(GapBuffer& buffer, int& selectionAnchor) {
+    if (selectionAnchor != -1) {
+        return deleteSelection(buffer, selectionAnchor);
+    }
+    // Delete the character (grapheme) at cursor position
+    std::size_t cursorPos = buffer.getGapStart();
+    if (cursorPos >= buffer.size()) return false;
+    buffer.deleteRange(cursorPos, buffer.nextGraphemeBoundary(cursorPos));
+    return true;
+}
+
+void moveHorizontal(GapBuffer& buffer, int& selectionAnchor, bool right, bool extend,
+                    std::size_t count) {
+    if (!extend) {
+        selectionAnchor = -1;
+    } else if (selectionAnchor == -1) {
+        selectionAnchor = static_cast<int>(buffer.getGapStart());
+    }
+    // Boundaries are found without moving the gap, which then moves once
+    std::size_t target = buffer.getGapStart();
+    for (std::size_t i = 0; i < count; i++) {
+        std::size_t next = right ? buffer.nextGraphemeBoundary(target) : buffer.prevGraphemeBoundary(target);
+        if (next == target) break;
+        target = next;
+    }
+    buffer.moveTo(target);
+}
+
+void selectAll(GapBuffer& buffer, int& selectionAnchor) {
+    selectionAnchor = 0;
+    buffer.moveTo(buffer.size());
+}
+
+std::size_t rebaseOffset(std::size_t offset, const GapBuffer::Edit& edit) {
+    if (offset <= edit.offset) return offset;
+    if (offset < edit.offset + edit.removed) return edit.offset;
+    return offset - edit.removed + edit.inserted.size();
+}
@@ -0,0 +1,35 @@
+//
+// EditCommands.h - Cursor and selection edits shared by the window and
+// headless tools
+//
+// The selection is the range between selectionAnchor and the cursor (the gap
+// start), both byte offsets; an anchor of -1 means nothing is selected.
+//
+
+#ifndef EDITCOMMANDS_H
+#define EDITCOMMANDS_H
+
+#include "GapBuffer.h"
+#include <string>
+
+// Selected text, or "" without a selection
+std::string selectedText(const GapBuffer& buffer, int selectionAnchor);
+// Removes the selected text and clears the anchor; true if anything was removed
+bool deleteSelection(GapBuffer& buffer, int& selectionAnchor);
+// Types utf8 at the cursor, replacing the selection
+void insertAtCursor(GapBuffer& buffer, int& selectionAnchor, const std::string& utf8);
+// Backspace and Delete: the selection if there is one, otherwise one grapheme.
+// Return true if the text changed.
+bool deleteBackward(GapBuffer& buffer, int& selectionAnchor);
+bool deleteForward(GapBuffer& buffer, int& selectionAnchor);
+// Left/Right by count graphemes with a single gap move; extend keeps (or
+// starts) the selection
+void moveHorizontal(GapBuffer& buffer, int& selectionAnchor, bool right, bool extend,
+                    std::size_t count = 1);
+void selectAll(GapBuffer& buffer, int& selectionAnchor);
+
+// Where a byte offset recorded before edit ends up after it: offsets past the
+// change shift by its length, offsets inside removed text move to its start
+std::size_t rebaseOffset(std::size_t offset, const GapBuffer::Edit& edit);
+
+#endif //EDITCOMMANDS_H
@@ -0,0 +1,451 @@
+//
+// EditJournal.cpp - Implementation of the crash-recovery journal
+//
+
+#include "EditJournal.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// File layout: "TEJ1" followed by records of
+//   type (1 byte) | a (u64) | b (u64) | payload | checksum (u32, FNV-1a)
+// 'B' base is the file on disk: a = size, b = mtime in nanoseconds
+// 'C' checkpoint: b = length, payload = full text
+// 'I' insert: a = offset, b = length, payload = text
+// 'D' delete: a = offset, b = length
+// A torn record at the end (crash mid-write) fails its checksum and is ignored.
+// The instance writing a journal holds an exclusive flock on it.
+
+namespace {
+
+const char MAGIC[4] = {'T', 'E', 'J', '1'};
+const std::size_t HEADER_SIZE = 1 + 8 + 8;
+const char UNTITLED_PREFIX[] = ".text_editor_untitled-";
+const char JOURNAL_SUFFIX[] = ".journal";
+
+std::string homeDirectory() {
+    const char* home = std::getenv("HOME");
+    return home ? home : ".";
+}
+
+std::uint32_t fnv1a(const char* data, std::size_t len, std::uint32_t hash = 2166136261u) {
+    for (std::size_t i = 0; i < len; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// A journal someone holds the lock on is still in use. Locks taken through
+// other descriptors in this process count too.
+bool lockedElsewhere(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool locked = ::flock(fd, LOCK_EX | LOCK_NB) != 0 && errno == EWOULDBLOCK;
+    ::close(fd);
+    return locked;
+}
+
+// mtime is in nanoseconds, so a rewrite within the same second that keeps the
+// size is still told apart
+bool statFile(const std::string& path, std::uint64_t& size, std::int64_t& mtime) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+    size = static_cast<std::uint64_t>(info.st_size);
+#ifdef __APPLE__
+    const timespec& modified = info.st_mtimespec;
+#else
+    const timespec& modified = info.st_mtim;
+#endif
+    mtime = static_cast<std::int64_t>(modified.tv_sec) * 1000000000 + modified.tv_nsec;
+    return true;
+}
+
+// The snapshot is two spans; they are written as one 'C' record
+bool writeCheckpointRecord(std::FILE* out, const GapBuffer::Snapshot& snapshot) {
+    std::uint64_t len = snapshot.storage ? snapshot.size() : 0;
+    char header[HEADER_SIZE];
+    header[0] = 'C';
+    std::uint64_t zero = 0;
+    std::memcpy(header + 1, &zero, 8);
+    std::memcpy(header + 9, &len, 8);
+
+    std::uint32_t sum = fnv1a(header, HEADER_SIZE);
+    bool ok = std::fwrite(header, 1, HEADER_SIZE, out) == HEADER_SIZE;
+    if (len > 0) {
+        sum = fnv1a(snapshot.before(), snapshot.gapStart, sum);
+        sum = fnv1a(snapshot.after(), snapshot.afterSize(), sum);
+        ok = ok && std::fwrite(snapshot.before(), 1, snapshot.gapStart, out) == snapshot.gapStart &&
+             std::fwrite(snapshot.after(), 1, snapshot.afterSize(), out) == snapshot.afterSize();
+    }
+    return std::fwrite(&sum, 1, sizeof(sum), out) == sizeof(sum) && ok;
+}
+
+struct Record {
+    char type;
+    std::uint64_t a;
+    std::uint64_t b;
+    const char* payload;
+};
+
+} // namespace
+
+EditJournal::~EditJournal() {
+    // Keep the file: only an orderly shutdown calls discard()
+    finishCheckpoint(true);
+    flush();
+    closeFile();
+    for (const auto& parked : parkedLocks) {
+        ::close(parked.second);
+    }
+}
+
+std::string EditJournal::journalPathFor(const std::string& documentPath) {
+    std::string::size_type slash = documentPath.find_last_of('/');
+    if (slash == std::string::npos) {
+        return "." + documentPath + ".journal";
+    }
+    return documentPath.substr(0, slash + 1) + "." + documentPath.substr(slash + 1) + ".journal";
+}
+
+std::string EditJournal::untitledJournalPath(unsigned id) {
+    return homeDirectory() + "/" + UNTITLED_PREFIX + std::to_string(id) + JOURNAL_SUFFIX;
+}
+
+std::vector<unsigned> EditJournal::findUntitledJournals() {
+    std::vector<unsigned> ids;
+    DIR* dir = opendir(homeDirectory().c_str());
+    if (!dir) return ids;
+
+    const std::size_t prefixLen = sizeof(UNTITLED_PREFIX) - 1;
+    const std::size_t suffixLen = sizeof(JOURNAL_SUFFIX) - 1;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= prefixLen + suffixLen || name.compare(0, prefixLen, UNTITLED_PREFIX) != 0 ||
+            name.compare(name.size() - suffixLen, suffixLen, JOURNAL_SUFFIX) != 0) {
+            continue;
+        }
+        std::string digits = name.substr(prefixLen, name.size() - prefixLen - suffixLen);
+        if (digits.size() > 9 || digits.find_first_not_of("0123456789") != std::string::npos) continue;
+        if (lockedElsewhere(homeDirectory() + "/" + name)) continue;
+        ids.push_back(static_cast<unsigned>(std::stoul(digits)));
+    }
+    closedir(dir);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool EditJournal::begin(const std::string& path, const GapBuffer& buffer, bool matchesDisk) {
+    return start(path, journalPathFor(path), buffer, matchesDisk);
+}
+
+bool EditJournal::beginUntitled(unsigned id, const GapBuffer& buffer) {
+    return start("", untitledJournalPath(id), buffer, false);
+}
+
+bool EditJournal::start(const std::string& path, std::string journal, const GapBuffer& buffer, bool matchesDisk) {
+    discard();
+
+    // A journal this instance parked is taken back; one another instance
+    // holds is left alone
+    auto parked = parkedLocks.find(journal);
+    if (parked != parkedLocks.end()) {
+        ::close(parked->second);
+        parkedLocks.erase(parked);
+    }
+    if (lockedElsewhere(journal)) return false;
+
+    documentPath = path;
+    journalPath = std::move(journal);
+    std::remove(journalPath.c_str());
+
+    baseIsDiskFile = matchesDisk && !path.empty() && statFile(path, baseSize, baseMtime);
+    if (!baseIsDiskFile) {
+        baseSnapshot = buffer.snapshot();
+    }
+    bytesSinceCheckpoint = 0;
+    active = true;
+
+    // Text that exists nowhere on disk (e.g. just recovered) is persisted right
+    // away, and an untitled journal is created at once to claim its id
+    if (!baseIsDiskFile && (buffer.size() > 0 || path.empty())) {
+        openFile();
+        flush();
+    }
+    return true;
+}
+
+bool EditJournal::isActive() const {
+    return active;
+}
+
+bool EditJournal::openFile() {
+    // Locked before truncating, so a journal another instance just created
+    // under the same name is never emptied
+    int fd = ::open(journalPath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+    if (fd >= 0 && (::flock(fd, LOCK_EX | LOCK_NB) != 0 || ::ftruncate(fd, 0) != 0 ||
+                    !(file = ::fdopen(fd, "wb")))) {
+        ::close(fd);
+    }
+    if (!file) {
+        active = false;
+        journalPath.clear(); // not ours to remove
+        return false;
+    }
+
+    std::fwrite(MAGIC, 1, sizeof(MAGIC), file);
+    if (baseIsDiskFile) {
+        writeRecord('B', baseSize, static_cast<std::uint64_t>(baseMtime), nullptr, 0);
+    } else {
+        writeCheckpoint(baseSnapshot);
+        baseSnapshot = GapBuffer::Snapshot{};
+    }
+    bytesSinceCheckpoint = 0;
+    return true;
+}
+
+void EditJournal::closeFile() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+void EditJournal::writeRecord(char type, std::uint64_t a, std::uint64_t b, const char* data, std::size_t len) {
+    char header[HEADER_SIZE];
+    header[0] = type;
+    std::memcpy(header + 1, &a, 8);
+    std::memcpy(header + 9, &b, 8);
+
+    std::uint32_t sum = fnv1a(data, len, fnv1a(header, HEADER_SIZE));
+    std::fwrite(header, 1, HEADER_SIZE, file);
+    if (len > 0) std::fwrite(data, 1, len, file);
+    std::fwrite(&sum, 1, sizeof(sum), file);
+    if (checkpointing) {
+        checkpointTail.append(header, HEADER_SIZE);
+        checkpointTail.append(data, len);
+        checkpointTail.append(reinterpret_cast<const char*>(&sum), sizeof(sum));
+    }
+
+    bytesSinceCheckpoint += HEADER_SIZE + len + sizeof(sum);
+    dirty = true;
+}
+
+void EditJournal::writeCheckpoint(const GapBuffer::Snapshot& snapshot) {
+    writeCheckpointRecord(file, snapshot);
+    dirty = true;
+}
+
+void EditJournal::flushPendingInsert() {
+    if (pendingInsert.empty()) return;
+    writeRecord('I', pendingOffset, pendingInsert.size(), pendingInsert.data(), pendingInsert.size());
+    pendingInsert.clear();
+}
+
+void EditJournal::record(const GapBuffer::Edit& edit) {
+    if (!active) return;
+    if (!file && !openFile()) return;
+
+    // Typing extends the current insert run instead of adding a record per key
+    bool extendsRun = edit.removed == 0 && !pendingInsert.empty() &&
+                      edit.offset == pendingOffset + pendingInsert.size();
+    if (extendsRun) {
+        pendingInsert.append(edit.inserted.data(), edit.inserted.size());
+        return;
+    }
+
+    flushPendingInsert();
+    if (edit.removed > 0) {
+        writeRecord('D', edit.offset, edit.removed, nullptr, 0);
+    }
+    if (!edit.inserted.empty()) {
+        pendingOffset = edit.offset;
+        pendingInsert.assign(edit.inserted.data(), edit.inserted.size());
+    }
+}
+
+void EditJournal::flush() {
+    if (!file) return;
+    flushPendingInsert();
+    if (dirty) {
+        std::fflush(file);
+        fsync(fileno(file));
+        dirty = false;
+    }
+}
+
+void EditJournal::maybeCheckpoint(const GapBuffer& buffer) {
+    finishCheckpoint(false);
+    if (!file || checkpointing || bytesSinceCheckpoint <= std::max(CHECKPOINT_MIN_BYTES, buffer.size())) return;
+
+    // The snapshot holds every edit so far, the buffered insert included; the
+    // records that follow it are collected in checkpointTail
+    flushPendingInsert();
+    checkpointing = true;
+    checkpointTail.clear();
+    bytesSinceCheckpoint = 0;
+
+    // A fresh file next to the journal, renamed over it once complete
+    std::string path = journalPath + ".XXXXXX";
+    checkpointThread = std::thread([this, snapshot = buffer.snapshot(), path]() mutable {
+        int fd = ::mkstemp(&path[0]);
+        if (fd >= 0) ::flock(fd, LOCK_EX); // the journal stays locked once renamed over
+        std::FILE* out = fd >= 0 ? ::fdopen(fd, "wb") : nullptr;
+        if (fd >= 0 && !out) ::close(fd);
+        bool ok = out && std::fwrite(MAGIC, 1, sizeof(MAGIC), out) == sizeof(MAGIC) &&
+                  writeCheckpointRecord(out, snapshot) && std::fflush(out) == 0 && fsync(fd) == 0;
+        snapshot.storage.reset(); // let the editor write in place again
+
+        checkpointPath = fd >= 0 ? path : "";
+        checkpointFile = out;
+        checkpointOk = ok;
+        checkpointDone.store(true, std::memory_order_release);
+    });
+}
+
+void EditJournal::finishCheckpoint(bool wait) {
+    if (!checkpointing || (!wait && !checkpointDone.load(std::memory_order_acquire))) return;
+    checkpointThread.join();
+    checkpointing = false;
+    checkpointDone.store(false, std::memory_order_relaxed);
+
+    // Records made while it was written follow the checkpoint; any still
+    // buffered go to whichever file is current afterwards
+    bool ok = checkpointOk &&
+              std::fwrite(checkpointTail.data(), 1, checkpointTail.size(), checkpointFile) == checkpointTail.size() &&
+              std::fflush(checkpointFile) == 0 && fsync(fileno(checkpointFile)) == 0 &&
+              std::rename(checkpointPath.c_str(), journalPath.c_str()) == 0;
+    checkpointTail.clear();
+    if (ok) {
+        closeFile();
+        file = checkpointFile;
+    } else {
+        // The old journal is still complete; try again at the next threshold
+        if (checkpointFile) std::fclose(checkpointFile);
+        if (!checkpointPath.empty()) std::remove(checkpointPath.c_str());
+    }
+    checkpointFile = nullptr;
+    checkpointPath.clear();
+}
+
+void EditJournal::cancelCheckpoint() {
+    if (!checkpointing) return;
+    checkpointThread.join();
+    checkpointing = false;
+    checkpointDone.store(false, std::memory_order_relaxed);
+    checkpointTail.clear();
+    if (checkpointFile) std::fclose(checkpointFile);
+    if (!checkpointPath.empty()) std::remove(checkpointPath.c_str());
+    checkpointFile = nullptr;
+    checkpointPath.clear();
+}
+
+void EditJournal::discard() {
+    cancelCheckpoint();
+    // Removed while still locked; one never opened only if no other instance
+    // has taken the name since
+    if (!journalPath.empty() && (file || !lockedElsewhere(journalPath))) {
+        std::remove(journalPath.c_str());
+    }
+    closeFile();
+    active = false;
+    pendingInsert.clear();
+    baseSnapshot = GapBuffer::Snapshot{};
+    journalPath.clear();
+    documentPath.clear();
+}
+
+void EditJournal::suspend() {
+    finishCheckpoint(true);
+    flush();
+    if (file) {
+        // A duplicate descriptor keeps the lock once the file is closed
+        int held = ::dup(fileno(file));
+        if (held >= 0) parkedLocks[journalPath] = held;
+    }
+    closeFile();
+    active = false;
+    pendingInsert.clear();
+    baseSnapshot = GapBuffer::Snapshot{};
+    journalPath.clear();
+    documentPath.clear();
+}
+
+bool EditJournal::recover(const std::string& path, GapBuffer& buffer) {
+    return replay(journalPathFor(path), path, buffer);
+}
+
+bool EditJournal::recoverUntitled(unsigned id, GapBuffer& buffer) {
+    return replay(untitledJournalPath(id), "", buffer);
+}
+
+bool EditJournal::replay(const std::string& journal, const std::string& path, GapBuffer& buffer) {
+    if (lockedElsewhere(journal)) return false;
+    std::ifstream input(journal, std::ios::binary);
+    if (!input.is_open()) return false;
+    std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (contents.size() < sizeof(MAGIC) || std::memcmp(contents.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+
+    // Validate every record before touching the buffer
+    std::vector<Record> records;
+    std::size_t pos = sizeof(MAGIC);
+    while (pos + HEADER_SIZE + 4 <= contents.size()) {
+        Record rec;
+        rec.type = contents[pos];
+        std::memcpy(&rec.a, contents.data() + pos + 1, 8);
+        std::memcpy(&rec.b, contents.data() + pos + 9, 8);
+        std::size_t len = (rec.type == 'I' || rec.type == 'C') ? static_cast<std::size_t>(rec.b) : 0;
+        if (len > contents.size() - pos - HEADER_SIZE - 4) break;
+
+        rec.payload = contents.data() + pos + HEADER_SIZE;
+        std::uint32_t stored;
+        std::memcpy(&stored, rec.payload + len, 4);
+        if (fnv1a(rec.payload, len, fnv1a(contents.data() + pos, HEADER_SIZE)) != stored) break;
+
+        records.push_back(rec);
+        pos += HEADER_SIZE + len + 4;
+    }
+
+    if (records.empty()) return false;
+    const Record& base = records.front();
+    if (base.type == 'B' && !path.empty()) {
+        // Edits apply on top of the file as it was; bail out if it changed since
+        std::uint64_t size;
+        std::int64_t mtime;
+        if (!statFile(path, size, mtime) || size != base.a ||
+            mtime != static_cast<std::int64_t>(base.b) || buffer.size() != size) {
+            return false;
+        }
+        if (records.size() == 1) return false; // nothing to recover
+    } else if (base.type == 'C') {
+        if (records.size() == 1 && base.b == 0) return false;
+        buffer.clear();
+        buffer.insertString(std::string(base.payload, static_cast<std::size_t>(base.b)));
+    } else {
+        return false;
+    }
+
+    for (std::size_t i = 1; i < records.size(); i++) {
+        const Record& rec = records[i];
+        if (rec.a > buffer.size()) break;
+        if (rec.type == 'I') {
+            buffer.moveTo(static_cast<std::size_t>(rec.a));
+            buffer.insertString(std::string(rec.payload, static_cast<std::size_t>(rec.b)));
+        } else if (rec.type == 'D') {
+            buffer.deleteRange(static_cast<std::size_t>(rec.a), static_cast<std::size_t>(rec.a + rec.b));
+        }
+    }
+    return true;
+}
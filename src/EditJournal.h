@@ -0,0 +1,124 @@
+//
+// EditJournal.h - Crash-recovery journal of buffer edits
+//
+
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include "GapBuffer.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Appends compact edit records to a sidecar file next to the document
+// (".name.journal"). Untitled documents have no file to sit next to; each
+// gets a numbered journal, ~/.text_editor_untitled-<id>.journal, claimed as
+// soon as journaling begins. A journal in use, including one whose document
+// is parked in a background tab, holds an flock, so another running instance
+// neither recovers it nor replaces it.
+// The journal starts from a base: either a reference to the file on disk
+// (size + mtime in nanoseconds, no data) or a checkpoint of the full text.
+// When the records outgrow the document the journal is rewritten as a single
+// checkpoint, so the I/O cost tracks the edit rate rather than the document
+// size. The checkpoint is written from a snapshot on a background thread;
+// until it replaces the journal, records still go to the old one.
+class EditJournal {
+public:
+    EditJournal() = default;
+    ~EditJournal();
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    static std::string journalPathFor(const std::string& documentPath);
+    static std::string untitledJournalPath(unsigned id);
+    // Ids of the untitled journals on disk that no running instance holds,
+    // e.g. left behind by a crash
+    static std::vector<unsigned> findUntitledJournals();
+
+    // Start journaling documentPath from the buffer's current contents.
+    // matchesDisk means the buffer equals the file on disk, so the base can
+    // reference the file instead of copying it. Any old journal is removed;
+    // the new one is only created once the first edit arrives. Returns false,
+    // journaling nothing, if another instance holds the journal.
+    bool begin(const std::string& documentPath, const GapBuffer& buffer, bool matchesDisk);
+    // Start journaling untitled document `id`; the base is always a checkpoint.
+    // Returns false if another instance holds the id; pick another one.
+    bool beginUntitled(unsigned id, const GapBuffer& buffer);
+
+    void record(const GapBuffer::Edit& edit);
+
+    // Push buffered records to disk (fflush + fsync); call periodically
+    void flush();
+
+    // Start rewriting the journal as one checkpoint once it has outgrown the
+    // document, and swap in a checkpoint that has finished; call periodically
+    void maybeCheckpoint(const GapBuffer& buffer);
+
+    // Stop journaling and delete the journal file
+    void discard();
+    // Stop journaling but leave the flushed journal on disk, so a document
+    // moved to a background tab can still be recovered after a crash. The
+    // journal stays locked until it is begun again or the process exits.
+    void suspend();
+
+    bool isActive() const;
+
+    // Replays the journal for documentPath into buffer, which must hold the
+    // file's current contents (or be empty for untitled documents).
+    // Returns false and leaves buffer untouched if there is nothing usable
+    // or another instance holds the journal.
+    static bool recover(const std::string& documentPath, GapBuffer& buffer);
+    static bool recoverUntitled(unsigned id, GapBuffer& buffer);
+
+private:
+    static constexpr std::size_t CHECKPOINT_MIN_BYTES = 4 * 1024 * 1024;
+
+    std::string documentPath;
+    std::string journalPath;
+    std::FILE* file = nullptr;
+    bool active = false;
+
+    // Base written when the file is first created
+    bool baseIsDiskFile = false;
+    std::uint64_t baseSize = 0;
+    std::int64_t baseMtime = 0;
+    GapBuffer::Snapshot baseSnapshot;
+
+    std::size_t bytesSinceCheckpoint = 0;
+    bool dirty = false;
+
+    // Descriptors that keep the journals of suspended documents locked, by path
+    std::map<std::string, int> parkedLocks;
+
+    // Checkpoint being written by checkpointThread. Records made meanwhile are
+    // kept in checkpointTail to follow it; the thread sets checkpointPath,
+    // checkpointFile and checkpointOk before checkpointDone.
+    std::thread checkpointThread;
+    std::atomic<bool> checkpointDone{false};
+    bool checkpointing = false;
+    std::string checkpointTail;
+    std::string checkpointPath;
+    std::FILE* checkpointFile = nullptr;
+    bool checkpointOk = false;
+
+    // Consecutive typed characters are merged into one insert record
+    std::size_t pendingOffset = 0;
+    std::string pendingInsert;
+
+    bool start(const std::string& path, std::string journal, const GapBuffer& buffer, bool matchesDisk);
+    static bool replay(const std::string& journal, const std::string& path, GapBuffer& buffer);
+    bool openFile();
+    void closeFile();
+    void writeRecord(char type, std::uint64_t a, std::uint64_t b, const char* data, std::size_t len);
+    void writeCheckpoint(const GapBuffer::Snapshot& snapshot);
+    void flushPendingInsert();
+    // Swaps in the checkpoint once written, waiting for it if `wait`
+    void finishCheckpoint(bool wait);
+    void cancelCheckpoint();
+};
+
+#endif //EDITJOURNAL_H
@@ -0,0 +1,121 @@
+//
+// EventTrace.cpp - Conversion between SFML events and recorded trace events
+//
+
+#include "EventTrace.h"
+
+namespace {
+
+constexpr std::int32_t keyValue(sf::Keyboard::Key key) {
+    return static_cast<std::int32_t>(key);
+}
+
+// Headless replay interprets these codes without SFML
+static_assert(keyValue(sf::Keyboard::Key::A) == tracekey::A, "tracekey::A");
+static_assert(keyValue(sf::Keyboard::Key::C) == tracekey::C, "tracekey::C");
+static_assert(keyValue(sf::Keyboard::Key::F) == tracekey::F, "tracekey::F");
+static_assert(keyValue(sf::Keyboard::Key::V) == tracekey::V, "tracekey::V");
+static_assert(keyValue(sf::Keyboard::Key::X) == tracekey::X, "tracekey::X");
+static_assert(keyValue(sf::Keyboard::Key::Escape) == tracekey::Escape, "tracekey::Escape");
+static_assert(keyValue(sf::Keyboard::Key::Enter) == tracekey::Enter, "tracekey::Enter");
+static_assert(keyValue(sf::Keyboard::Key::Backspace) == tracekey::Backspace, "tracekey::Backspace");
+static_assert(keyValue(sf::Keyboard::Key::Delete) == tracekey::Delete, "tracekey::Delete");
+static_assert(keyValue(sf::Keyboard::Key::Left) == tracekey::Left, "tracekey::Left");
+static_assert(keyValue(sf::Keyboard::Key::Right) == tracekey::Right, "tracekey::Right");
+static_assert(keyValue(sf::Keyboard::Key::Up) == tracekey::Up, "tracekey::Up");
+static_assert(keyValue(sf::Keyboard::Key::Down) == tracekey::Down, "tracekey::Down");
+
+template <typename KeyEvent>
+TraceEvent keyRecord(TraceEvent::Type type, const KeyEvent& key) {
+    TraceEvent record;
+    record.type = type;
+    record.code = keyValue(key.code);
+    record.modifiers = (key.shift ? TraceEvent::Shift : 0) | (key.control ? TraceEvent::Control : 0) |
+                       (key.alt ? TraceEvent::Alt : 0) | (key.system ? TraceEvent::System : 0);
+    return record;
+}
+
+template <typename KeyEvent>
+KeyEvent keyEvent(const TraceEvent& record) {
+    KeyEvent key;
+    key.code = static_cast<sf::Keyboard::Key>(record.code);
+    key.shift = record.modifiers & TraceEvent::Shift;
+    key.control = record.modifiers & TraceEvent::Control;
+    key.alt = record.modifiers & TraceEvent::Alt;
+    key.system = record.modifiers & TraceEvent::System;
+    return key;
+}
+
+} // namespace
+
+std::optional<TraceEvent> toTraceEvent(const sf::Event& event, std::uint64_t timeUs) {
+    TraceEvent record;
+    if (const auto* text = event.getIf<sf::Event::TextEntered>()) {
+        record.type = TraceEvent::TextEntered;
+        record.code = static_cast<std::int32_t>(text->unicode);
+    } else if (const auto* key = event.getIf<sf::Event::KeyPressed>()) {
+        record = keyRecord(TraceEvent::KeyPressed, *key);
+    } else if (const auto* key = event.getIf<sf::Event::KeyReleased>()) {
+        record = keyRecord(TraceEvent::KeyReleased, *key);
+    } else if (const auto* move = event.getIf<sf::Event::MouseMoved>()) {
+        record.type = TraceEvent::MouseMoved;
+        record.x = move->position.x;
+        record.y = move->position.y;
+    } else if (const auto* press = event.getIf<sf::Event::MouseButtonPressed>()) {
+        record.type = TraceEvent::MouseButtonPressed;
+        record.code = static_cast<std::int32_t>(press->button);
+        record.x = press->position.x;
+        record.y = press->position.y;
+    } else if (const auto* release = event.getIf<sf::Event::MouseButtonReleased>()) {
+        record.type = TraceEvent::MouseButtonReleased;
+        record.code = static_cast<std::int32_t>(release->button);
+        record.x = release->position.x;
+        record.y = release->position.y;
+    } else if (const auto* wheel = event.getIf<sf::Event::MouseWheelScrolled>()) {
+        record.type = TraceEvent::MouseWheelScrolled;
+        record.code = static_cast<std::int32_t>(wheel->wheel);
+        record.delta = wheel->delta;
+        record.x = wheel->position.x;
+        record.y = wheel->position.y;
+    } else if (const auto* resized = event.getIf<sf::Event::Resized>()) {
+        record.type = TraceEvent::Resized;
+        record.x = static_cast<std::int32_t>(resized->size.x);
+        record.y = static_cast<std::int32_t>(resized->size.y);
+    } else if (event.is<sf::Event::FocusLost>()) {
+        record.type = TraceEvent::FocusLost;
+    } else if (event.is<sf::Event::Closed>()) {
+        record.type = TraceEvent::Closed;
+    } else {
+        return std::nullopt;
+    }
+    record.timeUs = timeUs;
+    return record;
+}
+
+std::optional<sf::Event> toSfmlEvent(const TraceEvent& record) {
+    sf::Vector2i position(record.x, record.y);
+    switch (record.type) {
+        case TraceEvent::TextEntered:
+            return sf::Event(sf::Event::TextEntered{static_cast<char32_t>(record.code)});
+        case TraceEvent::KeyPressed:
+            return sf::Event(keyEvent<sf::Event::KeyPressed>(record));
+        case TraceEvent::KeyReleased:
+            return sf::Event(keyEvent<sf::Event::KeyReleased>(record));
+        case TraceEvent::MouseMoved:
+            return sf::Event(sf::Event::MouseMoved{position});
+        case TraceEvent::MouseButtonPressed:
+            return sf::Event(sf::Event::MouseButtonPressed{static_cast<sf::Mouse::Button>(record.code), position});
+        case TraceEvent::MouseButtonReleased:
+            return sf::Event(sf::Event::MouseButtonReleased{static_cast<sf::Mouse::Button>(record.code), position});
+        case TraceEvent::MouseWheelScrolled:
+            return sf::Event(sf::Event::MouseWheelScrolled{static_cast<sf::Mouse::Wheel>(record.code), record.delta, position});
+        case TraceEvent::Resized:
+            return sf::Event(sf::Event::Resized{sf::Vector2u(static_cast<unsigned>(record.x), static_cast<unsigned>(record.y))});
+        case TraceEvent::FocusLost:
+            return sf::Event(sf::Event::FocusLost{});
+        case TraceEvent::Closed:
+            return sf::Event(sf::Event::Closed{});
+        default:
+            return std::nullopt;
+    }
+}
@@ -0,0 +1,16 @@
+//
+// EventTrace.h - Conversion between SFML events and recorded trace events
+//
+
+#ifndef EVENTTRACE_H
+#define EVENTTRACE_H
+
+#include "InputTrace.h"
+#include <SFML/Graphics.hpp>
+#include <optional>
+
+// The trace record for an event, or nothing for events the editor ignores
+std::optional<TraceEvent> toTraceEvent(const sf::Event& event, std::uint64_t timeUs);
+std::optional<sf::Event> toSfmlEvent(const TraceEvent& event);
+
+#endif //EVENTTRACE_H
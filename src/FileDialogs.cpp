@@ -0,0 +1,46 @@
+//
+// FileDialogs.cpp - Native open/save dialogs (nativefiledialog)
+//
+
+#include "FileDialogs.h"
+#include "FileOperations.h"
+#include "nfd.h"
+#include <cstdlib>
+#include <string>
+
+std::string resolveSavePath(const std::string& existingFileName) {
+    std::string pathToSave;
+
+    // If we have an existing filename, save directly to it (no dialog)
+    if (!existingFileName.empty() && existingFileName != "Untitled") {
+        pathToSave = existingFileName;
+    }
+    // Otherwise, show save dialog
+    else {
+        nfdchar_t *outPath = nullptr;
+        nfdresult_t result = NFD_SaveDialog(nullptr, nullptr, &outPath);
+
+        if (result == NFD_OKAY) {
+            pathToSave = std::string(outPath);
+            free(outPath);
+        } else {
+            if (outPath) free(outPath);
+            return ""; // User cancelled
+        }
+    }
+
+    return withTxtExtension(pathToSave);
+}
+
+std::string openFileDialog() {
+    nfdchar_t *outPath = nullptr;
+    nfdresult_t result = NFD_OpenDialog(nullptr, nullptr, &outPath);
+
+    if (result == NFD_OKAY) {
+        std::string path(outPath);
+        free(outPath);
+        return path;
+    }
+    if (outPath) free(outPath);
+    return "";
+}
@@ -0,0 +1,14 @@
+//
+// FileDialogs.h - Native open/save dialogs (nativefiledialog)
+//
+
+#pragma once
+
+#include <string>
+
+// Path a save should write to: existingFileName if set, otherwise the native
+// save dialog's choice. Adds ".txt" when missing; "" if the user cancelled.
+std::string resolveSavePath(const std::string& existingFileName);
+
+// Shows the native open dialog; returns the chosen path or "" if cancelled
+std::string openFileDialog();
@@ -3,69 +3,34 @@
 //
 
 #include "FileOperations.h"
+#include <filesystem>
 #include <fstream>
-#include "nfd.h"
+#include <iterator>
 #include <string>
 
-std::string saveToFile(const GapBuffer& buffer, const std::string& existingFileName) {
-    std::string pathToSave;
-
-    // If we have an existing filename, save directly to it (no dialog)
-    if (!existingFileName.empty() && existingFileName != "Untitled") {
-        pathToSave = existingFileName;
-    }
-    // Otherwise, show save dialog
-    else {
-        nfdchar_t *outPath = nullptr;
-        nfdresult_t result = NFD_SaveDialog(nullptr, nullptr, &outPath);
-
-        if (result == NFD_OKAY) {
-            pathToSave = std::string(outPath);
-            free(outPath);
-        } else {
-            if (outPath) free(outPath);
-            return ""; // User cancelled
-        }
-    }
-
-    // Add .txt extension if not present
-    if (pathToSave.size() < 4 || pathToSave.substr(pathToSave.size() - 4) != ".txt") {
-        pathToSave += ".txt";
+std::string withTxtExtension(const std::string& path) {
+    if (path.size() < 4 || path.substr(path.size() - 4) != ".txt") {
+        return path + ".txt";
     }
+    return path;
+}
 
-    // Save the file
-    std::ofstream outputFile(pathToSave);
-    if (outputFile.is_open()) {
-        outputFile << buffer.getString();
-        outputFile.close();
-        return pathToSave; // Return the saved filename
+bool loadFileIntoBuffer(const std::string& path, GapBuffer& buffer) {
+    std::ifstream inputFile(path, std::ios::binary);
+    if (!inputFile.is_open()) {
+        return false;
     }
 
-    return ""; // Save failed
+    // Read everything at once; insertString grows the gap a single time
+    std::string contents((std::istreambuf_iterator<char>(inputFile)),
+                         std::istreambuf_iterator<char>());
+    buffer.clear();
+    buffer.insertString(contents);
+    return true;
 }
 
-std::string loadFromFile(GapBuffer& buffer) {
-    nfdchar_t *outPath = nullptr;
-    nfdresult_t result = NFD_OpenDialog(nullptr, nullptr, &outPath);
-
-    if (result == NFD_OKAY) {
-        std::string pathLoaded(outPath);
-        std::ifstream inputFile(pathLoaded);
-
-        if (inputFile.is_open()) {
-            buffer.clear();
-            char ch;
-            while (inputFile.get(ch)) {
-                buffer.insert(ch);
-            }
-            inputFile.close();
-            free(outPath);
-            return pathLoaded;
-        }
-        free(outPath);
-    } else {
-        if (outPath) free(outPath);
-    }
-
-    return "";
-}
\ No newline at end of file
+std::size_t fileSizeOf(const std::string& path) {
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<std::size_t>(size);
+}
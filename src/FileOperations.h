@@ -7,5 +7,9 @@
 
 #include <string>
 
-std::string saveToFile(const GapBuffer& buffer, const std::string& suggestedName);
-std::string loadFromFile(GapBuffer& buffer);
\ No newline at end of file
+// Adds ".txt" when the path doesn't already end in it
+std::string withTxtExtension(const std::string& path);
+// Replaces the buffer contents with the file at path
+bool loadFileIntoBuffer(const std::string& path, GapBuffer& buffer);
+// Size of the file at path in bytes (0 if it cannot be read)
+std::size_t fileSizeOf(const std::string& path);
@@ -0,0 +1,44 @@
+//
+// FontCache.cpp - Implementation of the shared font cache
+//
+
+#include "FontCache.h"
+#include <algorithm>
+
+const sf::Font* FontCache::get(const std::string& path) {
+    auto found = fonts.find(path);
+    if (found != fonts.end()) return found->second.get();
+
+    auto font = std::make_unique<sf::Font>();
+    if (!font->openFromFile(path)) return nullptr;
+    return fonts.emplace(path, std::move(font)).first->second.get();
+}
+
+void FontCache::prewarm(const sf::Font& font, std::initializer_list<unsigned int> sizes) {
+    for (unsigned int size : sizes) {
+        prewarm(font, size);
+    }
+}
+
+void FontCache::prewarm(const sf::Font& font, unsigned int size) {
+    auto atlas = std::make_pair(&font, size);
+    if (std::find(atlases.begin(), atlases.end(), atlas) != atlases.end()) return;
+    atlases.push_back(atlas);
+
+    for (char32_t cp = U' '; cp <= U'~'; cp++) {
+        font.getGlyph(cp, size, false);
+    }
+}
+
+std::size_t FontCache::getAtlasBytes() const {
+    std::size_t bytes = 0;
+    for (const auto& [font, size] : atlases) {
+        sf::Vector2u textureSize = font->getTexture(size).getSize();
+        bytes += static_cast<std::size_t>(textureSize.x) * textureSize.y * 4;
+    }
+    return bytes;
+}
+
+std::size_t FontCache::getAtlasCount() const {
+    return atlases.size();
+}
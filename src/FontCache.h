@@ -0,0 +1,40 @@
+//
+// FontCache.h - Fonts loaded once and shared by every widget
+//
+// sf::Font keeps one glyph atlas per character size, so widgets that share a
+// font also share the glyphs rasterized at a size. The cache owns the fonts,
+// hands out references that stay valid for its lifetime, and can rasterize
+// the common glyphs ahead of the first frame.
+//
+
+#ifndef FONTCACHE_H
+#define FONTCACHE_H
+
+#include <SFML/Graphics.hpp>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class FontCache {
+public:
+    // The font at path, opened on first use; nullptr if it can't be opened
+    const sf::Font* get(const std::string& path);
+
+    // Rasterizes printable ASCII at each size so the first frames don't stall
+    // on glyph uploads. Sizes seen here are the ones counted below.
+    void prewarm(const sf::Font& font, std::initializer_list<unsigned int> sizes);
+    void prewarm(const sf::Font& font, unsigned int size);
+
+    // Atlas textures of the prewarmed sizes, as RGBA bytes
+    std::size_t getAtlasBytes() const;
+    std::size_t getAtlasCount() const;
+
+private:
+    std::map<std::string, std::unique_ptr<sf::Font>> fonts;   // stable addresses
+    std::vector<std::pair<const sf::Font*, unsigned int>> atlases;
+};
+
+#endif //FONTCACHE_H
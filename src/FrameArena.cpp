@@ -0,0 +1,55 @@
+//
+// FrameArena.cpp - Implementation of the per-frame bump allocator
+//
+
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(std::size_t blockSize) : blockSize(blockSize) {}
+
+void FrameArena::addBlock(std::size_t minSize) {
+    std::size_t size = std::max(blockSize, minSize);
+    blocks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+    offset = 0;
+}
+
+void* FrameArena::allocate(std::size_t bytes, std::size_t alignment) {
+    if (blocks.empty()) {
+        addBlock(bytes + alignment);
+    }
+    auto base = reinterpret_cast<std::uintptr_t>(blocks.back().data.get());
+    std::size_t aligned = (base + offset + alignment - 1) / alignment * alignment - base;
+    if (aligned + bytes > blocks.back().size) {
+        // Later blocks grow so a busy frame settles into few of them
+        addBlock(std::max(bytes + alignment, blocks.back().size * 2));
+        base = reinterpret_cast<std::uintptr_t>(blocks.back().data.get());
+        aligned = (base + alignment - 1) / alignment * alignment - base;
+    }
+    offset = aligned + bytes;
+    used += bytes;
+    return blocks.back().data.get() + aligned;
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        // Merge so the next frame of the same size fits in one block
+        std::size_t total = getCapacity();
+        blocks.clear();
+        addBlock(total);
+    }
+    offset = 0;
+    used = 0;
+}
+
+std::size_t FrameArena::getBytesUsed() const {
+    return used;
+}
+
+std::size_t FrameArena::getCapacity() const {
+    std::size_t total = 0;
+    for (const Block& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
@@ -0,0 +1,72 @@
+//
+// FrameArena.h - Bump allocator for temporaries that live for one frame
+//
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Hands out memory by bumping a pointer; nothing is freed individually.
+// reset() releases everything at once. Blocks are kept across resets (merged
+// into one sized for the peak), so a frame that needs no more than earlier
+// frames makes no heap allocations.
+class FrameArena {
+public:
+    explicit FrameArena(std::size_t blockSize = 64 * 1024);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+    void reset();
+
+    std::size_t getBytesUsed() const;
+    std::size_t getCapacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    void addBlock(std::size_t minSize);
+
+    std::size_t blockSize;
+    std::vector<Block> blocks;
+    std::size_t offset = 0;  // into blocks.back()
+    std::size_t used = 0;
+};
+
+// Standard allocator over a FrameArena; deallocate is a no-op
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, std::size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+    FrameArena* arena;
+};
+
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif //FRAMEARENA_H
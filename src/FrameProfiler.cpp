@@ -0,0 +1,128 @@
+//
+// FrameProfiler.cpp - Implementation of the frame profiler
+//
+
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+double millisecondsBetween(std::chrono::steady_clock::time_point from,
+                           std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+const char* FrameProfiler::stageName(Stage stage) {
+    static const char* names[STAGE_COUNT] = {
+        "Input", "Background", "Layout", "Status", "Search", "Draw", "Present"
+    };
+    return stage < STAGE_COUNT ? names[stage] : "?";
+}
+
+void FrameProfiler::setEnabled(bool value) {
+    enabled = value;
+    inFrame = false;
+}
+
+bool FrameProfiler::isEnabled() const {
+    return enabled;
+}
+
+void FrameProfiler::setAllocationCounter(AllocationCounterFn counter) {
+    allocationCounter = counter;
+}
+
+std::uint64_t FrameProfiler::allocationsSoFar() const {
+    return allocationCounter ? allocationCounter() : 0;
+}
+
+void FrameProfiler::beginFrame() {
+    if (!enabled) return;
+    frameStart = lastMark = Clock::now();
+    current = Frame{};
+    allocationsAtStart = allocationsSoFar();
+    inFrame = true;
+}
+
+void FrameProfiler::mark(Stage stage) {
+    if (!inFrame) return;
+    Clock::time_point now = Clock::now();
+    current.stageMs[stage] += millisecondsBetween(lastMark, now);
+    lastMark = now;
+}
+
+void FrameProfiler::endFrame() {
+    if (!inFrame) return;
+    current.totalMs = millisecondsBetween(frameStart, Clock::now());
+    current.allocations = allocationsSoFar() - allocationsAtStart;
+    frames[next] = current;
+    next = (next + 1) % CAPACITY;
+    count = std::min(count + 1, CAPACITY);
+    inFrame = false;
+}
+
+std::size_t FrameProfiler::getFrameCount() const {
+    return count;
+}
+
+const FrameProfiler::Frame& FrameProfiler::getFrame(std::size_t age) const {
+    return frames[(next + CAPACITY - 1 - age) % CAPACITY];
+}
+
+FrameProfiler::Frame FrameProfiler::average() const {
+    Frame sum;
+    if (count == 0) return sum;
+    for (std::size_t age = 0; age < count; age++) {
+        const Frame& frame = getFrame(age);
+        sum.totalMs += frame.totalMs;
+        for (std::size_t s = 0; s < STAGE_COUNT; s++) {
+            sum.stageMs[s] += frame.stageMs[s];
+        }
+    }
+    sum.totalMs /= static_cast<double>(count);
+    for (double& ms : sum.stageMs) {
+        ms /= static_cast<double>(count);
+    }
+    return sum;
+}
+
+double FrameProfiler::worstFrameMs() const {
+    double worst = 0.0;
+    for (std::size_t age = 0; age < count; age++) {
+        worst = std::max(worst, getFrame(age).totalMs);
+    }
+    return worst;
+}
+
+double FrameProfiler::averageAllocations() const {
+    if (count == 0) return 0.0;
+    double total = 0.0;
+    for (std::size_t age = 0; age < count; age++) {
+        total += static_cast<double>(getFrame(age).allocations);
+    }
+    return total / static_cast<double>(count);
+}
+
+bool FrameProfiler::exportCsv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << "frame,total_ms";
+    for (std::size_t s = 0; s < STAGE_COUNT; s++) {
+        out << ',' << stageName(static_cast<Stage>(s)) << "_ms";
+    }
+    out << ",allocations\n";
+
+    for (std::size_t i = 0; i < count; i++) {
+        const Frame& frame = getFrame(count - 1 - i);
+        out << i << ',' << frame.totalMs;
+        for (double ms : frame.stageMs) {
+            out << ',' << ms;
+        }
+        out << ',' << frame.allocations << '\n';
+    }
+    return out.good();
+}
@@ -0,0 +1,83 @@
+//
+// FrameProfiler.h - Per-stage frame timing with a ring buffer of recent frames
+//
+
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Times the stages of the main loop with a steady clock. Each mark() charges
+// the time since the previous mark (or beginFrame) to a stage, so the loop is
+// instrumented with one call per stage boundary. Heap allocations are counted
+// per frame through a counter the program supplies, so the profiler doesn't
+// pull in the operator new replacements. Has no SFML dependency.
+class FrameProfiler {
+public:
+    enum Stage {
+        Input,       // event handling and key repeat
+        Background,  // loader, saver, journal and blink bookkeeping
+        Layout,      // wrapping, text upload, cursor and scroll
+        Status,      // status bar metrics
+        Search,      // search highlight placement and drawing
+        Draw,        // everything else submitted to the window
+        Present,     // window.display(), including vsync / frame limiting
+        STAGE_COUNT
+    };
+
+    struct Frame {
+        double totalMs = 0.0;
+        std::array<double, STAGE_COUNT> stageMs{};
+        std::uint64_t allocations = 0; // heap allocations on any thread during the frame
+    };
+
+    static constexpr std::size_t CAPACITY = 240;
+
+    static const char* stageName(Stage stage);
+
+    // Returns the number of heap allocations made so far (allocationCount in
+    // the editor); without one, frames record no allocations
+    using AllocationCounterFn = std::uint64_t (*)();
+    void setAllocationCounter(AllocationCounterFn counter);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void beginFrame();
+    void mark(Stage stage);
+    void endFrame();
+
+    // Recorded frames, 0 = most recent
+    std::size_t getFrameCount() const;
+    const Frame& getFrame(std::size_t age) const;
+    Frame average() const;
+    double worstFrameMs() const;
+    double averageAllocations() const;
+
+    // Writes every recorded frame, oldest first
+    bool exportCsv(const std::string& path) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::uint64_t allocationsSoFar() const;
+
+    bool enabled = false;
+    bool inFrame = false;
+    AllocationCounterFn allocationCounter = nullptr;
+    Clock::time_point frameStart;
+    Clock::time_point lastMark;
+    std::uint64_t allocationsAtStart = 0;
+    Frame current;
+
+    std::vector<Frame> frames = std::vector<Frame>(CAPACITY);
+    std::size_t next = 0;    // slot the next frame is written to
+    std::size_t count = 0;
+};
+
+#endif //FRAMEPROFILER_H
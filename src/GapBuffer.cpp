@@ -3,10 +3,15 @@
 //
 
 #include "GapBuffer.h"
-#include "vector"
+#include "Utf8.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 
 GapBuffer::GapBuffer() {
-    buffer.resize(10);
+    buffer = std::make_shared<std::vector<char>>();
+    buffer->resize(10);
+    index.reset(buffer->size());
     setGapStart(0);
     setGapEnd(10);
 }
@@ -14,40 +19,62 @@ void GapBuffer::insert(char c) {
     if (getGapStart() == getGapEnd()) {
         expand();
     }
-    buffer[getGapStart()] = c;
+    detach();
+    (*buffer)[getGapStart()] = c;
     setGapStart(getGapStart() + 1);
+    version++;
+    notify(getGapStart() - 1, 0, std::string_view(&c, 1));
 }
-void GapBuffer::expand() {
-    int oldSize = buffer.size();
-    //doubling the buffer size
-    buffer.resize(buffer.size() * 2);
-    //run the loop backwards to move the characters
-    for (int i = oldSize - 1; i >= static_cast<int>(gapStart); i--) {
-        buffer[i + oldSize] = buffer[i];
+
+void GapBuffer::detach() {
+    if (buffer.use_count() > 1) {
+        // A snapshot still shares the storage; give the editor its own copy
+        buffer = std::make_shared<std::vector<char>>(*buffer);
+    } else {
+        // Order our writes after the last reader released its reference
+        std::atomic_thread_fence(std::memory_order_acquire);
     }
+}
+void GapBuffer::expand(std::size_t minGap) {
+    std::size_t oldSize = buffer->size();
+    std::size_t tail = oldSize - getGapEnd();
+    detach();
+    //doubling the buffer size, or more if a large insert needs it
+    std::size_t newSize = std::max(oldSize * 2, size() + minGap);
+    buffer->resize(newSize);
+    //move the text after the gap to the end of the new storage
+    std::copy_backward(buffer->begin() + getGapEnd(), buffer->begin() + oldSize, buffer->end());
+    //every chunk moved, so the index starts over
+    index.reset(newSize);
     //gapEnd point it to the new location
-    setGapEnd(getGapEnd() + oldSize);
+    gapEnd = newSize - tail;
 }
 void GapBuffer::backspace() {
     if (getGapStart() == 0) {
         //TODO: Start of the file
         return;
     }
-    setGapStart(getGapStart() - 1);
+    size_t oldStart = getGapStart();
+    setGapStart(prevGraphemeBoundary(oldStart));
+    version++;
+    notify(getGapStart(), oldStart - getGapStart(), {});
 }
 
 char GapBuffer::getChar(size_t i) const {
     if (i < gapStart) {
-        return buffer[i];
+        return (*buffer)[i];
     } else {
-        return buffer[i + (gapEnd - gapStart)];
+        return (*buffer)[i + (gapEnd - gapStart)];
     }
 }
 
+// The setters mark the bytes that entered or left the gap so the index stays in sync
 void GapBuffer::setGapStart(size_t i) {
+    index.markDirty(std::min(gapStart, i), std::max(gapStart, i));
     gapStart = i;
 }
 void GapBuffer::setGapEnd(size_t i) {
+    index.markDirty(std::min(gapEnd, i), std::max(gapEnd, i));
     gapEnd = i;
 }
 size_t GapBuffer::getGapStart() const {
@@ -58,57 +85,67 @@ size_t GapBuffer::getGapEnd() const {
 }
 std::string GapBuffer::getString() const {
     std::string word;
-    for (int i = 0; i < buffer.size() - (getGapEnd() - getGapStart()); i++) {
-        word += getChar(i);
-    }
+    word.reserve(size());
+    word.append(buffer->data(), getGapStart());
+    word.append(buffer->data() + getGapEnd(), buffer->size() - getGapEnd());
     return word;
 }
 
 void GapBuffer::moveLeft() {
-    if (getGapStart() == 0) {
-        return;
-    }
-    buffer[getGapEnd() - 1] = buffer[getGapStart() - 1];
-    setGapStart(getGapStart() - 1);
-    setGapEnd(getGapEnd() - 1);
+    moveTo(prevGraphemeBoundary(getGapStart()));
 }
 
 void GapBuffer::moveRight() {
-    if (getGapEnd() == buffer.size()) {
-        return;
-    }
-    buffer[getGapStart()] = buffer[getGapEnd()];
-    setGapStart(getGapStart() + 1);
-    setGapEnd(getGapEnd() + 1);
+    moveTo(nextGraphemeBoundary(getGapStart()));
 }
 
 void GapBuffer::moveTo(size_t i) {
+    i = std::min(i, size());
     if (getGapStart() == i) {
         return;
     }
+    detach();
     if (getGapStart() > i) {
-        //go left
-        while (getGapStart() > i) {
-            moveLeft();
-        }
-    }
-    if (getGapStart() < i) {
-        //go right
-        while (getGapStart() < i) {
-            moveRight();
-        }
+        //go left: bytes [i, gapStart) move to the end of the gap
+        size_t count = getGapStart() - i;
+        std::memmove(buffer->data() + getGapEnd() - count, buffer->data() + i, count);
+        setGapStart(i);
+        setGapEnd(getGapEnd() - count);
+    } else {
+        //go right: bytes [gapEnd, gapEnd + count) move to the start of the gap
+        size_t count = i - getGapStart();
+        std::memmove(buffer->data() + getGapStart(), buffer->data() + getGapEnd(), count);
+        setGapStart(getGapStart() + count);
+        setGapEnd(getGapEnd() + count);
     }
-
-
 }
 
 void GapBuffer::clear() {
-    buffer.resize(10);
+    size_t oldSize = size();
+    buffer = std::make_shared<std::vector<char>>(10);
+    index.reset(buffer->size());
     setGapStart(0);
     setGapEnd(10);
+    version++;
+    notify(0, oldSize, {});
+}
+
+void GapBuffer::restore(const Snapshot& snapshot) {
+    // Storage is only written after detach(), which copies it while the
+    // snapshot is still alive
+    buffer = std::const_pointer_cast<std::vector<char>>(snapshot.storage);
+    index.reset(buffer->size());
+    gapStart = snapshot.gapStart;
+    gapEnd = snapshot.gapEnd;
+    version++;
+}
+
+size_t GapBuffer::capacity() const {
+    return buffer->size();
 }
 
 void GapBuffer::deleteRange(size_t start, size_t end) {
+    end = std::min(end, size());
     if (start >= end) return;
 
     // Move gap to start position
@@ -118,20 +155,19 @@ void GapBuffer::deleteRange(size_t start, size_t end) {
     size_t deleteCount = end - start;
 
     // Expand the gap by moving gapEnd forward
-    size_t newGapEnd = getGapEnd() + deleteCount;
-    if (newGapEnd > buffer.size()) {
-        newGapEnd = buffer.size();
-    }
-    setGapEnd(newGapEnd);
+    setGapEnd(getGapEnd() + deleteCount);
+    version++;
+    notify(start, deleteCount, {});
 }
 
 std::string GapBuffer::getRange(size_t start, size_t end) const {
+    end = std::min(end, size());
     if (start >= end) return "";
 
     std::string result;
-    size_t textSize = buffer.size() - (getGapEnd() - getGapStart());
+    result.reserve(end - start);
 
-    for (size_t i = start; i < end && i < textSize; i++) {
+    for (size_t i = start; i < end; i++) {
         result += getChar(i);
     }
 
@@ -139,7 +175,225 @@ std::string GapBuffer::getRange(size_t start, size_t end) const {
 }
 
 void GapBuffer::insertString(const std::string& str) {
-    for (char c : str) {
-        insert(c);
+    if (str.empty()) return;
+    reserve(str.size());
+    detach();
+    std::memcpy(buffer->data() + getGapStart(), str.data(), str.size());
+    setGapStart(getGapStart() + str.size());
+    version++;
+    notify(getGapStart() - str.size(), 0, str);
+}
+
+void GapBuffer::append(std::string_view text) {
+    if (text.empty()) return;
+    size_t offset = size();
+    if (getGapEnd() == buffer->size()) {
+        // Nothing after the gap: the end of the text is the cursor, and the
+        // text goes into the gap as insertString would put it
+        reserve(text.size());
+        detach();
+        std::memcpy(buffer->data() + getGapStart(), text.data(), text.size());
+        setGapStart(getGapStart() + text.size());
+    } else {
+        detach();
+        buffer->insert(buffer->end(), text.begin(), text.end());
+        index.grow(buffer->size());
+    }
+    version++;
+    notify(offset, 0, text);
+}
+
+void GapBuffer::applyEdits(const std::vector<Edit>& edits) {
+    if (edits.empty()) return;
+    size_t insertedTotal = 0;
+    for (const Edit& edit : edits) {
+        insertedTotal += edit.inserted.size();
+    }
+    // Removals only widen the gap, so one reservation covers the whole pass
+    reserve(insertedTotal);
+
+    const Edit& last = edits.back();
+    if (getGapStart() >= last.offset + last.removed) {
+        // Back to front: offsets before an edit are unaffected by it, and the
+        // text goes in after the gap so the gap never carries it along
+        bool changed = false;
+        for (auto it = edits.rbegin(); it != edits.rend(); ++it) {
+            const Edit& edit = *it;
+            if (edit.removed == 0 && edit.inserted.empty()) continue;
+            size_t offset = std::min(edit.offset, size());
+            size_t removed = std::min(edit.removed, size() - offset);
+            moveTo(offset + removed);
+            detach();
+            setGapStart(offset);
+            setGapEnd(getGapEnd() - edit.inserted.size());
+            if (!edit.inserted.empty()) {
+                std::memcpy(buffer->data() + getGapEnd(), edit.inserted.data(), edit.inserted.size());
+            }
+            changed = true;
+            notify(offset, removed, edit.inserted);
+        }
+        moveTo(edits.front().offset + edits.front().inserted.size());
+        if (changed) version++;
+        return;
+    }
+
+    // Front to back: offsets shift by what earlier edits added or removed
+    size_t added = 0;
+    size_t removedSoFar = 0;
+    bool changed = false;
+    for (const Edit& edit : edits) {
+        if (edit.removed == 0 && edit.inserted.empty()) continue;
+        size_t offset = std::min(edit.offset + added - removedSoFar, size());
+        size_t removed = std::min(edit.removed, size() - offset);
+        moveTo(offset);
+        detach();
+        setGapEnd(getGapEnd() + removed);
+        if (!edit.inserted.empty()) {
+            std::memcpy(buffer->data() + getGapStart(), edit.inserted.data(), edit.inserted.size());
+        }
+        setGapStart(getGapStart() + edit.inserted.size());
+        added += edit.inserted.size();
+        removedSoFar += removed;
+        changed = true;
+        notify(offset, removed, edit.inserted);
+    }
+    if (changed) version++;
+}
+
+void GapBuffer::reserve(size_t bytes) {
+    if (getGapEnd() - getGapStart() < bytes) {
+        expand(bytes);
+    }
+}
+
+size_t GapBuffer::size() const {
+    return buffer->size() - (getGapEnd() - getGapStart());
+}
+
+void GapBuffer::setEditObserver(EditObserver editObserver) {
+    observer = std::move(editObserver);
+}
+
+void GapBuffer::notify(size_t offset, size_t removed, std::string_view inserted) {
+    if (observer) {
+        observer({offset, removed, inserted});
     }
-}
\ No newline at end of file
+}
+
+size_t GapBuffer::getVersion() const {
+    return version;
+}
+
+GapBuffer::Snapshot GapBuffer::snapshot() const {
+    Snapshot snap;
+    snap.storage = buffer;
+    snap.gapStart = gapStart;
+    snap.gapEnd = gapEnd;
+    snap.version = version;
+    return snap;
+}
+
+GapBuffer::Spans GapBuffer::spans() const {
+    const char* data = buffer->data();
+    return {std::string_view(data, gapStart), std::string_view(data + gapEnd, buffer->size() - gapEnd)};
+}
+
+size_t GapBuffer::Snapshot::size() const {
+    return gapStart + afterSize();
+}
+
+StorageView GapBuffer::view() const {
+    return {buffer->data(), buffer->size(), gapStart, gapEnd};
+}
+
+size_t GapBuffer::codePointCount() const {
+    return index.total(view()).codePoints;
+}
+
+ChunkSummary GapBuffer::statistics(size_t start, size_t end) const {
+    end = std::min(end, size());
+    start = std::min(start, end);
+    size_t gap = gapEnd - gapStart;
+    size_t physicalStart = start < gapStart ? start : start + gap;
+    size_t physicalEnd = end <= gapStart ? end : end + gap;
+    return index.range(view(), physicalStart, physicalEnd);
+}
+
+size_t GapBuffer::codePointIndex(size_t byteOffset) const {
+    byteOffset = std::min(byteOffset, size());
+    size_t physical = byteOffset < gapStart ? byteOffset : byteOffset + (gapEnd - gapStart);
+    return index.prefix(view(), physical).codePoints;
+}
+
+size_t GapBuffer::byteOffsetOfCodePoint(size_t codePoint) const {
+    return index.findCodePoint(view(), codePoint);
+}
+
+size_t GapBuffer::lineIndex(size_t byteOffset) const {
+    byteOffset = std::min(byteOffset, size());
+    size_t physical = byteOffset < gapStart ? byteOffset : byteOffset + (gapEnd - gapStart);
+    return index.prefix(view(), physical).newlines;
+}
+
+size_t GapBuffer::lineStart(size_t line) const {
+    return index.findLineStart(view(), line);
+}
+
+char32_t GapBuffer::decodeAt(size_t offset, size_t& len) const {
+    char bytes[4];
+    size_t n = std::min<size_t>(4, size() - offset);
+    for (size_t k = 0; k < n; k++) {
+        bytes[k] = getChar(offset + k);
+    }
+    return utf8::decode(bytes, n, len);
+}
+
+size_t GapBuffer::prevCodePointStart(size_t offset) const {
+    size_t p = offset - 1;
+    while (p > 0 && offset - p < 4 && utf8::isContinuation(static_cast<unsigned char>(getChar(p)))) {
+        p--;
+    }
+    return p;
+}
+
+size_t GapBuffer::nextGraphemeBoundary(size_t offset) const {
+    size_t n = size();
+    if (offset >= n) return n;
+
+    size_t len;
+    char32_t cp = decodeAt(offset, len);
+    size_t pos = offset + len;
+
+    // Absorb combining marks, modifiers, ZWJ sequences and CRLF
+    while (pos < n) {
+        char32_t next = decodeAt(pos, len);
+        bool isControl = cp == '\n' || cp == '\r';
+        bool joins = (utf8::isGraphemeExtend(next) && !isControl) ||
+                     cp == utf8::ZERO_WIDTH_JOINER ||
+                     (cp == '\r' && next == '\n');
+        if (!joins) break;
+        cp = next;
+        pos += len;
+    }
+    return pos;
+}
+
+size_t GapBuffer::prevGraphemeBoundary(size_t offset) const {
+    offset = std::min(offset, size());
+    if (offset == 0) return 0;
+
+    size_t pos = prevCodePointStart(offset);
+    while (pos > 0) {
+        size_t len;
+        char32_t cp = decodeAt(pos, len);
+        size_t before = prevCodePointStart(pos);
+        char32_t prev = decodeAt(before, len);
+        bool isControl = prev == '\n' || prev == '\r';
+        bool joins = (utf8::isGraphemeExtend(cp) && !isControl) ||
+                     prev == utf8::ZERO_WIDTH_JOINER ||
+                     (prev == '\r' && cp == '\n');
+        if (!joins) break;
+        pos = before;
+    }
+    return pos;
+}
@@ -4,15 +4,62 @@
 
 #ifndef GAPBUFFER_H
 #define GAPBUFFER_H
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
+#include "ChunkIndex.h"
 
 
+// Stores UTF-8 text. Offsets passed in and out are byte offsets; the chunk
+// index converts between bytes and code points in O(log n).
+// Storage is copy-on-write so snapshot() is O(1): the first write after a
+// snapshot copies the storage if the snapshot is still alive.
 class GapBuffer {
+public:
+    // Immutable view of the text at one version, safe to read from another thread
+    struct Snapshot {
+        std::shared_ptr<const std::vector<char>> storage;
+        std::size_t gapStart = 0;
+        std::size_t gapEnd = 0;
+        std::size_t version = 0;
+
+        std::size_t size() const;
+        // The text is [0, gapStart) followed by [gapEnd, storage->size())
+        const char* before() const { return storage->data(); }
+        const char* after() const { return storage->data() + gapEnd; }
+        std::size_t afterSize() const { return storage->size() - gapEnd; }
+    };
+
+    // One text change: `removed` bytes at `offset` were replaced by `inserted`
+    struct Edit {
+        std::size_t offset;
+        std::size_t removed;
+        std::string_view inserted;
+    };
+    using EditObserver = std::function<void(const Edit&)>;
+
+    // The text as the runs before and after the gap
+    struct Spans {
+        std::string_view before;
+        std::string_view after;
+    };
+
 private:
-    std::vector<char> buffer;
-    std::size_t gapStart;
-    std::size_t gapEnd;
-    void expand();
+    std::shared_ptr<std::vector<char>> buffer;
+    std::size_t gapStart = 0;
+    std::size_t gapEnd = 0;
+    std::size_t version = 0;
+    mutable ChunkIndex index;
+    EditObserver observer;
+    void expand(std::size_t minGap = 1);
+    void detach();
+    void notify(std::size_t offset, std::size_t removed, std::string_view inserted);
+    StorageView view() const;
+    char32_t decodeAt(std::size_t offset, std::size_t& len) const;
+    std::size_t prevCodePointStart(std::size_t offset) const;
 public:
     GapBuffer();
     std::size_t getGapStart() const;
@@ -21,17 +68,63 @@ public:
     void setGapEnd(std::size_t gapEnd);
     void insert(char c);
     void backspace();
-    char getChar(size_t i) const;
+    char getChar(std::size_t i) const;
     std::string getString() const;
     void moveLeft();
     void moveRight();
-    void moveTo(size_t i);
+    void moveTo(std::size_t i);
     void clear();
-    void deleteRange(size_t start, size_t end);
-    std::string getRange(size_t start, size_t end) const;
+    void deleteRange(std::size_t start, std::size_t end);
+    std::string getRange(std::size_t start, std::size_t end) const;
     void insertString(const std::string& str);
+    // Adds text at the end of the document, wherever the cursor is. A cursor
+    // at the end moves past the new text; any other stays put and the text
+    // goes in after the last byte of storage, so the gap never moves.
+    void append(std::string_view text);
+    // Grow the gap so the next `bytes` of inserts need no reallocation
+    void reserve(std::size_t bytes);
+    // Applies edits sorted by offset, non-overlapping and given in the
+    // original text's offsets, in one sweep of the gap. With the gap past the
+    // last edit they are applied back to front and the gap ends after the
+    // first one's inserted text; otherwise front to back, ending after the
+    // last one's. The observer sees each edit as it is applied, with its
+    // offset as of that point.
+    void applyEdits(const std::vector<Edit>& edits);
+    // Replace the text with a snapshot's, sharing its storage until the next
+    // write. Like switching documents, this is not reported to the edit
+    // observer; the cursor goes to the snapshot's gap.
+    void restore(const Snapshot& snapshot);
+
+    // Bytes of storage, gap included
+    std::size_t capacity() const;
+
+    // Text length in bytes
+    std::size_t size() const;
+
+    // Bumped on every change to the text (not on cursor moves)
+    std::size_t getVersion() const;
+    Snapshot snapshot() const;
+    // Reads the text in place instead of copying it like getString(); valid
+    // until the next edit or cursor move
+    Spans spans() const;
+
+    // Called after every text change, e.g. to journal edits
+    void setEditObserver(EditObserver editObserver);
+
+    // UTF-8 aware positions
+    std::size_t codePointCount() const;
+    // Bytes, code points, newlines and words of [start, end), from the chunk
+    // index: O(log n) plus the partial chunks at the ends
+    ChunkSummary statistics(std::size_t start, std::size_t end) const;
+    std::size_t codePointIndex(std::size_t byteOffset) const;
+    std::size_t byteOffsetOfCodePoint(std::size_t codePoint) const;
+    // Line numbers from the index's newline counts, also O(log n)
+    std::size_t lineIndex(std::size_t byteOffset) const;
+    std::size_t lineStart(std::size_t line) const;
+    std::size_t nextGraphemeBoundary(std::size_t offset) const;
+    std::size_t prevGraphemeBoundary(std::size_t offset) const;
 };
 
 
 
-#endif //GAPBUFFER_H
\ No newline at end of file
+#endif //GAPBUFFER_H
@@ -3,8 +3,10 @@
 //
 #pragma once
 #include <SFML/Graphics.hpp>
+#include "BatchedText.h"
 #include "GapBuffer.h"
 #include "UI.h"
+#include "WrapLayout.h"
 
 enum class MouseState {
     Idle,
@@ -13,5 +15,6 @@ enum class MouseState {
     ScrollbarDragging
 };
 
-void handleMouseClick(sf::Vector2i mousePos, GapBuffer& buffer, const sf::Text& text,
-                      const sf::RenderWindow& window, const sf::View& textView);
\ No newline at end of file
+// Moves the cursor to the glyph under the mouse; `state` is the layout `text` shows
+void handleMouseClick(sf::Vector2i mousePos, GapBuffer& buffer, const DisplayState& state,
+                      const BatchedText& text, const sf::RenderWindow& window, const sf::View& textView);
\ No newline at end of file
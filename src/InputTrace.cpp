@@ -0,0 +1,199 @@
+//
+// InputTrace.cpp - Compact binary recording of the editor's input events
+//
+
+#include "InputTrace.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char MAGIC[4] = {'T', 'E', 'T', '1'};
+const std::size_t FLUSH_THRESHOLD = 64 * 1024;
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void putSigned(std::string& out, std::int32_t value) {
+    auto wide = static_cast<std::int64_t>(value);
+    putVarint(out, static_cast<std::uint64_t>((wide << 1) ^ (wide >> 63)));
+}
+
+struct Cursor {
+    const unsigned char* data;
+    std::size_t size;
+    std::size_t pos = 0;
+
+    bool byte(std::uint8_t& out) {
+        if (pos >= size) return false;
+        out = data[pos++];
+        return true;
+    }
+
+    bool varint(std::uint64_t& out) {
+        out = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t b;
+            if (!byte(b)) return false;
+            out |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool signedVarint(std::int32_t& out) {
+        std::uint64_t raw;
+        if (!varint(raw)) return false;
+        out = static_cast<std::int32_t>(static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1));
+        return true;
+    }
+};
+
+} // namespace
+
+InputTraceWriter::~InputTraceWriter() {
+    close();
+}
+
+bool InputTraceWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    pending.assign(MAGIC, sizeof(MAGIC));
+    lastTimeUs = 0;
+    eventCount = 0;
+    return true;
+}
+
+void InputTraceWriter::write(const TraceEvent& event) {
+    if (!file) return;
+
+    pending += static_cast<char>(event.type);
+    putVarint(pending, event.timeUs >= lastTimeUs ? event.timeUs - lastTimeUs : 0);
+    lastTimeUs = std::max(lastTimeUs, event.timeUs);
+
+    switch (event.type) {
+        case TraceEvent::TextEntered:
+            putVarint(pending, static_cast<std::uint32_t>(event.code));
+            break;
+        case TraceEvent::KeyPressed:
+        case TraceEvent::KeyReleased:
+            putSigned(pending, event.code);
+            pending += static_cast<char>(event.modifiers);
+            break;
+        case TraceEvent::MouseMoved:
+            putSigned(pending, event.x);
+            putSigned(pending, event.y);
+            break;
+        case TraceEvent::MouseButtonPressed:
+        case TraceEvent::MouseButtonReleased:
+            putSigned(pending, event.code);
+            putSigned(pending, event.x);
+            putSigned(pending, event.y);
+            break;
+        case TraceEvent::MouseWheelScrolled: {
+            putSigned(pending, event.code);
+            char raw[sizeof(float)];
+            std::memcpy(raw, &event.delta, sizeof(float));
+            pending.append(raw, sizeof(raw));
+            putSigned(pending, event.x);
+            putSigned(pending, event.y);
+            break;
+        }
+        case TraceEvent::Resized:
+            putSigned(pending, event.x);
+            putSigned(pending, event.y);
+            break;
+        default:
+            break;
+    }
+    eventCount++;
+
+    if (pending.size() >= FLUSH_THRESHOLD) {
+        flush();
+    }
+}
+
+void InputTraceWriter::flush() {
+    if (!file || pending.empty()) return;
+    std::fwrite(pending.data(), 1, pending.size(), file);
+    std::fflush(file);
+    pending.clear();
+}
+
+void InputTraceWriter::close() {
+    if (!file) return;
+    flush();
+    std::fclose(file);
+    file = nullptr;
+}
+
+bool readInputTrace(const std::string& path, std::vector<TraceEvent>& events) {
+    events.clear();
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    std::string contents;
+    char chunk[64 * 1024];
+    std::size_t got;
+    while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        contents.append(chunk, got);
+    }
+    std::fclose(file);
+
+    if (contents.size() < sizeof(MAGIC) || std::memcmp(contents.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+
+    Cursor in{reinterpret_cast<const unsigned char*>(contents.data()), contents.size(), sizeof(MAGIC)};
+    std::uint64_t timeUs = 0;
+    while (in.pos < in.size) {
+        TraceEvent event;
+        std::uint8_t type;
+        std::uint64_t elapsed;
+        if (!in.byte(type) || type >= TraceEvent::TypeCount || !in.varint(elapsed)) break;
+        event.type = static_cast<TraceEvent::Type>(type);
+        timeUs += elapsed;
+        event.timeUs = timeUs;
+
+        bool ok = true;
+        switch (event.type) {
+            case TraceEvent::TextEntered: {
+                std::uint64_t cp;
+                ok = in.varint(cp);
+                event.code = static_cast<std::int32_t>(cp);
+                break;
+            }
+            case TraceEvent::KeyPressed:
+            case TraceEvent::KeyReleased:
+                ok = in.signedVarint(event.code) && in.byte(event.modifiers);
+                break;
+            case TraceEvent::MouseMoved:
+            case TraceEvent::Resized:
+                ok = in.signedVarint(event.x) && in.signedVarint(event.y);
+                break;
+            case TraceEvent::MouseButtonPressed:
+            case TraceEvent::MouseButtonReleased:
+                ok = in.signedVarint(event.code) && in.signedVarint(event.x) && in.signedVarint(event.y);
+                break;
+            case TraceEvent::MouseWheelScrolled:
+                ok = in.signedVarint(event.code) && in.pos + sizeof(float) <= in.size;
+                if (ok) {
+                    std::memcpy(&event.delta, in.data + in.pos, sizeof(float));
+                    in.pos += sizeof(float);
+                    ok = in.signedVarint(event.x) && in.signedVarint(event.y);
+                }
+                break;
+            default:
+                break;
+        }
+        if (!ok) break;
+        events.push_back(event);
+    }
+    return true;
+}
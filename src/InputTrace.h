@@ -0,0 +1,95 @@
+//
+// InputTrace.h - Compact binary recording of the editor's input events
+//
+// A trace is the "TET1" magic followed by one record per event: a type byte,
+// the time since the previous event in microseconds, then a type-specific
+// payload. Integers are LEB128 varints (zigzag for signed values), so typing
+// costs about four bytes per event.
+//
+
+#ifndef INPUTTRACE_H
+#define INPUTTRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    enum Type : std::uint8_t {
+        TextEntered,
+        KeyPressed,
+        KeyReleased,
+        MouseMoved,
+        MouseButtonPressed,
+        MouseButtonReleased,
+        MouseWheelScrolled,
+        Resized,
+        FocusLost,
+        Closed,
+        TypeCount
+    };
+
+    enum Modifier : std::uint8_t {
+        Shift   = 1 << 0,
+        Control = 1 << 1,
+        Alt     = 1 << 2,
+        System  = 1 << 3
+    };
+
+    Type type = Closed;
+    std::uint64_t timeUs = 0;  // since the start of the recording
+    std::int32_t code = 0;     // code point, key, mouse button or wheel
+    std::uint8_t modifiers = 0;
+    std::int32_t x = 0;        // mouse position or new window size
+    std::int32_t y = 0;
+    float delta = 0.f;         // wheel movement
+};
+
+// Key codes used by headless replay. They are sf::Keyboard::Key values; the
+// GUI checks them against SFML at compile time.
+namespace tracekey {
+constexpr std::int32_t A = 0;
+constexpr std::int32_t C = 2;
+constexpr std::int32_t F = 5;
+constexpr std::int32_t V = 21;
+constexpr std::int32_t X = 23;
+constexpr std::int32_t Escape = 36;
+constexpr std::int32_t Enter = 58;
+constexpr std::int32_t Backspace = 59;
+constexpr std::int32_t Delete = 66;
+constexpr std::int32_t Left = 71;
+constexpr std::int32_t Right = 72;
+constexpr std::int32_t Up = 73;
+constexpr std::int32_t Down = 74;
+}
+
+class InputTraceWriter {
+public:
+    InputTraceWriter() = default;
+    ~InputTraceWriter();
+    InputTraceWriter(const InputTraceWriter&) = delete;
+    InputTraceWriter& operator=(const InputTraceWriter&) = delete;
+
+    bool open(const std::string& path);
+    bool isOpen() const { return file != nullptr; }
+    void write(const TraceEvent& event);
+    // Writes out buffered records; also done when the buffer fills and on close
+    void flush();
+    void close();
+
+    std::size_t getEventCount() const { return eventCount; }
+
+private:
+    std::FILE* file = nullptr;
+    std::string pending;
+    std::uint64_t lastTimeUs = 0;
+    std::size_t eventCount = 0;
+};
+
+// Reads a whole trace. A record cut short by a crash ends the trace; false only
+// if the file cannot be read or is not a trace.
+bool readInputTrace(const std::string& path, std::vector<TraceEvent>& events);
+
+#endif //INPUTTRACE_H
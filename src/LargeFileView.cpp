@@ -0,0 +1,272 @@
+//
+// LargeFileView.cpp - Implementation of the memory-mapped large file view
+//
+
+#include "LargeFileView.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+LargeFileView::~LargeFileView() {
+    close();
+}
+
+bool LargeFileView::open(const std::string& filePath, unsigned int threads) {
+    close();
+
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapped == MAP_FAILED) return false;
+
+    path = filePath;
+    data = static_cast<const char*>(mapped);
+    size = static_cast<std::size_t>(info.st_size);
+
+    blocks.assign((size + INDEX_BLOCK - 1) / INDEX_BLOCK, BlockIndex{});
+    blocksMerged = 0;
+    linesThrough.clear();
+    knownLines = 1;
+    bytesIndexed = 0;
+    indexedCounts = TextCounts{};
+    invalidUtf8.reset();
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned int>(std::min<std::size_t>(threads, blocks.size()));
+
+    stopRequested = false;
+    nextBlock = 0;
+    bytesScanned = 0;
+    workersRunning = threads;
+    indexing = true;
+    for (unsigned int i = 0; i < threads; i++) {
+        indexers.emplace_back(&LargeFileView::indexWorker, this);
+    }
+    return true;
+}
+
+void LargeFileView::close() {
+    stopRequested = true;
+    for (std::thread& indexer : indexers) {
+        indexer.join();
+    }
+    indexers.clear();
+    indexing = false;
+
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    path.clear();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    blocks.clear();
+    blocksMerged = 0;
+    linesThrough.clear();
+    knownLines = 0;
+    bytesIndexed = 0;
+    indexedCounts = TextCounts{};
+    invalidUtf8.reset();
+}
+
+bool LargeFileView::isOpen() const {
+    return data != nullptr;
+}
+
+const std::string& LargeFileView::getPath() const {
+    return path;
+}
+
+std::size_t LargeFileView::getFileSize() const {
+    return size;
+}
+
+bool LargeFileView::isIndexing() const {
+    return indexing;
+}
+
+double LargeFileView::getIndexProgress() const {
+    if (size == 0) return 1.0;
+    return static_cast<double>(bytesScanned) / static_cast<double>(size);
+}
+
+std::size_t LargeFileView::getEstimatedLineCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (bytesIndexed >= size || bytesIndexed == 0) {
+        return knownLines;
+    }
+    // Extrapolate from the average line length seen so far
+    double estimate = static_cast<double>(knownLines) * static_cast<double>(size) /
+                      static_cast<double>(bytesIndexed);
+    return std::max(knownLines, static_cast<std::size_t>(estimate));
+}
+
+std::size_t LargeFileView::getWordCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return indexedCounts.wordStarts;
+}
+
+std::optional<std::size_t> LargeFileView::getInvalidUtf8Offset() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return invalidUtf8;
+}
+
+void LargeFileView::indexWorker() {
+    while (!stopRequested) {
+        std::size_t block = nextBlock++;
+        if (block >= blocks.size()) break;
+
+        BlockIndex result;
+        indexBlock(block, result);
+        if (stopRequested) break;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        blocks[block] = std::move(result);
+        blocks[block].done = true;
+        mergeFinishedBlocks();
+    }
+
+    if (--workersRunning == 0) {
+        indexing = false;
+    }
+}
+
+void LargeFileView::indexBlock(std::size_t block, BlockIndex& out) {
+    std::size_t begin = block * INDEX_BLOCK;
+    std::size_t end = std::min(size, begin + INDEX_BLOCK);
+
+    // Ask the OS to read ahead the block we are about to scan
+    std::size_t page = static_cast<std::size_t>(getpagesize());
+    std::size_t alignedBegin = begin - begin % page;
+    madvise(const_cast<char*>(data) + alignedBegin, end - alignedBegin, MADV_WILLNEED);
+
+    // The block checks the UTF-8 sequences that start in it; leading
+    // continuation bytes belong to a sequence the previous block checks
+    std::size_t validated = block == 0 ? 0 : nextLeadByte(begin);
+
+    for (std::size_t slice = begin; slice < end && !stopRequested; slice += SCAN_SLICE) {
+        std::size_t sliceEnd = std::min(end, slice + SCAN_SLICE);
+
+        const char* p = data + slice;
+        const char* stop = data + sliceEnd;
+        while (p < stop) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', stop - p));
+            if (!nl) break;
+            out.newlines++;
+            if (out.newlines % LINE_STRIDE == 0) {
+                out.checkpoints.push_back(static_cast<std::uint64_t>(nl + 1 - data));
+            }
+            p = nl + 1;
+        }
+
+        out.counts = TextCounts::combine(out.counts, countText(std::string_view(data + slice, sliceEnd - slice)));
+
+        std::size_t checkEnd = nextLeadByte(sliceEnd);
+        if (!out.invalidUtf8 && validated < checkEnd) {
+            std::size_t bad = utf8::findInvalid(data + validated, checkEnd - validated);
+            if (bad < checkEnd - validated) {
+                out.invalidUtf8 = validated + bad;
+            }
+        }
+        validated = std::max(validated, checkEnd);
+        bytesScanned += sliceEnd - slice;
+    }
+}
+
+void LargeFileView::mergeFinishedBlocks() {
+    while (blocksMerged < blocks.size() && blocks[blocksMerged].done) {
+        const BlockIndex& block = blocks[blocksMerged];
+        linesThrough.push_back((linesThrough.empty() ? 0 : linesThrough.back()) + block.newlines);
+        indexedCounts = TextCounts::combine(indexedCounts, block.counts);
+        if (!invalidUtf8) {
+            invalidUtf8 = block.invalidUtf8;
+        }
+        blocksMerged++;
+    }
+    knownLines = (linesThrough.empty() ? 0 : linesThrough.back()) + 1;
+    bytesIndexed = std::min(size, blocksMerged * INDEX_BLOCK);
+}
+
+std::size_t LargeFileView::nextLeadByte(std::size_t offset) const {
+    while (offset < size && utf8::isContinuation(static_cast<unsigned char>(data[offset]))) {
+        offset++;
+    }
+    return offset;
+}
+
+std::size_t LargeFileView::findLineStart(std::size_t line) const {
+    std::size_t checkpoint;
+    std::size_t skip;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (line == 0) {
+            return 0;
+        } else if (line < knownLines) {
+            // Line `line` starts after the line-th newline; find its block,
+            // then the nearest checkpoint in it
+            auto through = std::lower_bound(linesThrough.begin(), linesThrough.end(), line);
+            std::size_t block = static_cast<std::size_t>(through - linesThrough.begin());
+            std::size_t local = line - (block > 0 ? static_cast<std::size_t>(linesThrough[block - 1]) : 0);
+            std::size_t stride = local / LINE_STRIDE;
+            if (stride > 0) {
+                checkpoint = static_cast<std::size_t>(blocks[block].checkpoints[stride - 1]);
+                skip = local % LINE_STRIDE;
+            } else {
+                checkpoint = block * INDEX_BLOCK;
+                skip = local;
+            }
+        } else {
+            // Not indexed yet: guess from the average line length, then snap
+            // to the next line boundary
+            double average = knownLines > 0 && bytesIndexed > 0
+                ? static_cast<double>(bytesIndexed) / static_cast<double>(knownLines)
+                : 80.0;
+            checkpoint = std::min(size, static_cast<std::size_t>(static_cast<double>(line) * average));
+            skip = checkpoint > 0 ? 1 : 0;
+            if (checkpoint > 0) checkpoint--;
+        }
+    }
+
+    std::size_t offset = checkpoint;
+    while (skip > 0 && offset < size) {
+        const char* nl = static_cast<const char*>(std::memchr(data + offset, '\n', size - offset));
+        if (!nl) return size;
+        offset = static_cast<std::size_t>(nl + 1 - data);
+        skip--;
+    }
+    return offset;
+}
+
+std::string LargeFileView::getLines(std::size_t first, std::size_t count) const {
+    std::string result;
+    if (!data || count == 0) return result;
+
+    std::size_t offset = findLineStart(first);
+    for (std::size_t i = 0; i < count && offset < size; i++) {
+        const char* nl = static_cast<const char*>(std::memchr(data + offset, '\n', size - offset));
+        std::size_t lineEnd = nl ? static_cast<std::size_t>(nl - data) : size;
+
+        // Very long lines are clipped so a single-line file stays responsive
+        std::size_t shown = std::min(lineEnd - offset, MAX_LINE_BYTES);
+        if (i > 0) result += '\n';
+        result.append(data + offset, shown);
+
+        offset = lineEnd + 1;
+    }
+    return result;
+}
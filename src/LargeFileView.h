@@ -0,0 +1,103 @@
+//
+// LargeFileView.h - Read-only, memory-mapped view of very large files
+//
+
+#ifndef LARGEFILEVIEW_H
+#define LARGEFILEVIEW_H
+
+#include "TextMetrics.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Opens a file instantly by mapping it instead of reading it into a GapBuffer.
+// Background threads, one per core, index the file in blocks: newlines, word
+// counts and a UTF-8 check. Finished blocks join the line index in file order;
+// until a block is in, line positions past the indexed region are
+// extrapolated from the average line length so far.
+class LargeFileView {
+public:
+    // Files at least this big open in large-file mode
+    static constexpr std::size_t THRESHOLD = 64ull * 1024 * 1024;
+
+    LargeFileView() = default;
+    ~LargeFileView();
+    LargeFileView(const LargeFileView&) = delete;
+    LargeFileView& operator=(const LargeFileView&) = delete;
+
+    // threads = 0 indexes with one thread per core
+    bool open(const std::string& path, unsigned int threads = 0);
+    void close();
+
+    bool isOpen() const;
+    const std::string& getPath() const;
+    std::size_t getFileSize() const;
+
+    // Indexing progress
+    bool isIndexing() const;
+    double getIndexProgress() const;        // 0..1
+    std::size_t getEstimatedLineCount() const;
+    // Words in the indexed part of the file
+    std::size_t getWordCount() const;
+    // Offset of the first malformed UTF-8 byte found so far
+    std::optional<std::size_t> getInvalidUtf8Offset() const;
+
+    // Text of lines [first, first + count), joined with '\n'. Only the pages
+    // backing these lines are touched.
+    std::string getLines(std::size_t first, std::size_t count) const;
+
+private:
+    // Every LINE_STRIDE-th line start is stored; the rest are found by scanning
+    static constexpr std::size_t LINE_STRIDE = 64;
+    // Unit of work for one indexing thread
+    static constexpr std::size_t INDEX_BLOCK = 4ull * 1024 * 1024;
+    // A block is scanned in slices small enough that the counting passes over
+    // a slice after the first read it from cache
+    static constexpr std::size_t SCAN_SLICE = 256 * 1024;
+    static constexpr std::size_t MAX_LINE_BYTES = 4096;
+
+    // What was found in one block; written by one indexing thread, then
+    // read-only once merged
+    struct BlockIndex {
+        bool done = false;
+        std::size_t newlines = 0;
+        std::vector<std::uint64_t> checkpoints;   // offset after every LINE_STRIDE-th newline
+        TextCounts counts;
+        std::optional<std::size_t> invalidUtf8;
+    };
+
+    std::string path;
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+    mutable std::mutex mutex;
+    std::vector<BlockIndex> blocks;
+    std::size_t blocksMerged = 0;             // blocks [0, blocksMerged) form the line index
+    std::vector<std::uint64_t> linesThrough;  // newlines in blocks [0, b]
+    std::size_t knownLines = 0;               // lines whose start offset is known
+    std::size_t bytesIndexed = 0;             // bytes of the merged blocks
+    TextCounts indexedCounts;
+    std::optional<std::size_t> invalidUtf8;
+
+    std::atomic<bool> indexing{false};
+    std::atomic<bool> stopRequested{false};
+    std::atomic<std::size_t> nextBlock{0};
+    std::atomic<std::size_t> bytesScanned{0};
+    std::atomic<unsigned int> workersRunning{0};
+    std::vector<std::thread> indexers;
+
+    void indexWorker();
+    void indexBlock(std::size_t block, BlockIndex& out);
+    // Moves finished blocks that directly follow the merged ones into the
+    // line index; called with the mutex held
+    void mergeFinishedBlocks();
+    std::size_t nextLeadByte(std::size_t offset) const;
+    std::size_t findLineStart(std::size_t line) const;
+};
+
+#endif //LARGEFILEVIEW_H
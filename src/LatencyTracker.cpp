@@ -0,0 +1,128 @@
+//
+// LatencyTracker.cpp - Keystroke-to-frame latency histograms and budgets
+//
+
+#include "LatencyTracker.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LatencySummary summarizeLatencies(std::vector<double> samplesUs) {
+    LatencySummary summary;
+    summary.count = samplesUs.size();
+    if (samplesUs.empty()) return summary;
+
+    std::sort(samplesUs.begin(), samplesUs.end());
+    auto at = [&](double fraction) {
+        auto index = static_cast<std::size_t>(fraction * static_cast<double>(samplesUs.size() - 1) + 0.5);
+        return samplesUs[index];
+    };
+    summary.p50Us = at(0.50);
+    summary.p99Us = at(0.99);
+    summary.maxUs = samplesUs.back();
+    return summary;
+}
+
+const char* LatencyTracker::kindName(Kind kind) {
+    switch (kind) {
+        case Text: return "text";
+        case Key:  return "key";
+        default:   return "?";
+    }
+}
+
+double LatencyTracker::bucketLimitMs(std::size_t bucket) {
+    if (bucket + 1 >= BUCKETS) return std::numeric_limits<double>::infinity();
+    return std::ldexp(1.0, static_cast<int>(bucket));
+}
+
+LatencyTracker::~LatencyTracker() {
+    closeLog();
+}
+
+void LatencyTracker::eventArrived(Kind kind, Clock::time_point when) {
+    pending.push_back({kind, when});
+}
+
+void LatencyTracker::framePresented(Clock::time_point when) {
+    for (const Pending& event : pending) {
+        record(event.kind, std::chrono::duration<double, std::micro>(when - event.arrived).count());
+    }
+    pending.clear();
+    frame++;
+}
+
+void LatencyTracker::record(Kind kind, double latencyUs) {
+    Series& s = series[kind];
+    double ms = latencyUs / 1000.0;
+
+    std::size_t bucket = 0;
+    while (bucket + 1 < BUCKETS && ms >= bucketLimitMs(bucket)) {
+        bucket++;
+    }
+    s.histogram[bucket]++;
+
+    if (s.recentUs.size() < RECENT) {
+        s.recentUs.push_back(latencyUs);
+    } else {
+        s.recentUs[s.next] = latencyUs;
+    }
+    s.next = (s.next + 1) % RECENT;
+    s.count++;
+
+    bool over = ms > budgetMs;
+    if (over) s.overBudget++;
+
+    if (log) {
+        char row[96];
+        std::snprintf(row, sizeof(row), "%llu,%s,%.1f,%d\n", static_cast<unsigned long long>(frame),
+                      kindName(kind), latencyUs, over ? 1 : 0);
+        logBuffer += row;
+    }
+}
+
+void LatencyTracker::setBudgetMs(double ms) {
+    budgetMs = ms;
+}
+
+double LatencyTracker::getBudgetMs() const {
+    return budgetMs;
+}
+
+std::size_t LatencyTracker::getCount(Kind kind) const {
+    return series[kind].count;
+}
+
+std::size_t LatencyTracker::getOverBudget(Kind kind) const {
+    return series[kind].overBudget;
+}
+
+const std::array<std::uint64_t, LatencyTracker::BUCKETS>& LatencyTracker::getHistogram(Kind kind) const {
+    return series[kind].histogram;
+}
+
+LatencySummary LatencyTracker::recent(Kind kind) const {
+    return summarizeLatencies(series[kind].recentUs);
+}
+
+bool LatencyTracker::openLog(const std::string& path) {
+    closeLog();
+    log = std::fopen(path.c_str(), "w");
+    if (!log) return false;
+    logBuffer = "frame,kind,latency_us,over_budget\n";
+    return true;
+}
+
+void LatencyTracker::flushLog() {
+    if (!log || logBuffer.empty()) return;
+    std::fwrite(logBuffer.data(), 1, logBuffer.size(), log);
+    std::fflush(log);
+    logBuffer.clear();
+}
+
+void LatencyTracker::closeLog() {
+    if (!log) return;
+    flushLog();
+    std::fclose(log);
+    log = nullptr;
+}
@@ -0,0 +1,89 @@
+//
+// LatencyTracker.h - Keystroke-to-frame latency histograms and budgets
+//
+
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct LatencySummary {
+    std::size_t count = 0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+LatencySummary summarizeLatencies(std::vector<double> samplesUs);
+
+// Input events are stamped when they are polled and charged when the frame that
+// shows their effect has been presented. Each kind keeps a lifetime histogram
+// and its most recent samples for percentiles. Has no SFML dependency.
+class LatencyTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Kind {
+        Text,   // TextEntered
+        Key,    // KeyPressed
+        KIND_COUNT
+    };
+
+    // Bucket b holds latencies below 2^b ms; the last one is open-ended
+    static constexpr std::size_t BUCKETS = 9;
+    static constexpr std::size_t RECENT = 512;
+
+    static const char* kindName(Kind kind);
+    // Upper edge of a bucket in milliseconds (infinity for the last)
+    static double bucketLimitMs(std::size_t bucket);
+
+    void eventArrived(Kind kind, Clock::time_point when = Clock::now());
+    // Every event that has arrived so far is now on screen
+    void framePresented(Clock::time_point when = Clock::now());
+    void record(Kind kind, double latencyUs);
+
+    void setBudgetMs(double ms);
+    double getBudgetMs() const;
+
+    std::size_t getCount(Kind kind) const;
+    std::size_t getOverBudget(Kind kind) const;
+    const std::array<std::uint64_t, BUCKETS>& getHistogram(Kind kind) const;
+    // Percentiles over the last RECENT samples
+    LatencySummary recent(Kind kind) const;
+
+    // Appends one CSV row per sample; rows are buffered until flushLog()
+    bool openLog(const std::string& path);
+    void flushLog();
+    void closeLog();
+    ~LatencyTracker();
+
+private:
+    struct Pending {
+        Kind kind;
+        Clock::time_point arrived;
+    };
+
+    struct Series {
+        std::array<std::uint64_t, BUCKETS> histogram{};
+        std::vector<double> recentUs; // ring of the last RECENT samples
+        std::size_t next = 0;
+        std::size_t count = 0;
+        std::size_t overBudget = 0;
+    };
+
+    std::vector<Pending> pending;
+    std::array<Series, KIND_COUNT> series;
+    double budgetMs = 33.3;
+    std::uint64_t frame = 0;
+
+    std::FILE* log = nullptr;
+    std::string logBuffer;
+};
+
+#endif //LATENCYTRACKER_H
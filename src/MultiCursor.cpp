@@ -0,0 +1,177 @@
+//
+// MultiCursor.cpp - Implementation of multi-cursor edits
+//
+
+#include "MultiCursor.h"
+#include <algorithm>
+
+namespace {
+
+// Every cursor, the primary one included, in document order
+std::vector<Caret> allCarets(const GapBuffer& buffer, int selectionAnchor, const std::vector<Caret>& carets) {
+    std::vector<Caret> all = carets;
+    all.push_back({buffer.getGapStart(), selectionAnchor});
+    std::sort(all.begin(), all.end(),
+              [](const Caret& a, const Caret& b) { return a.position < b.position; });
+    return all;
+}
+
+// Cursors at the same offset merge; the first or last, whichever is nearer,
+// becomes the gap
+void assignCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets, std::vector<Caret>& all) {
+    all.erase(std::unique(all.begin(), all.end(),
+                          [](const Caret& a, const Caret& b) { return a.position == b.position; }),
+              all.end());
+    std::size_t gap = buffer.getGapStart();
+    std::size_t toFirst = gap > all.front().position ? gap - all.front().position : all.front().position - gap;
+    std::size_t toLast = gap > all.back().position ? gap - all.back().position : all.back().position - gap;
+    auto primary = toFirst < toLast ? all.begin() : all.end() - 1;
+    buffer.moveTo(primary->position);
+    selectionAnchor = primary->anchor;
+    all.erase(primary);
+    carets.swap(all);
+}
+
+// Replaces the range rangeOf gives for each cursor with textOf(i) for the
+// i-th cursor in document order; ranges that overlap merge, as do their
+// cursors, keeping the text of the one that starts first
+template <typename RangeOf, typename TextOf>
+bool replaceAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                     RangeOf rangeOf, TextOf textOf) {
+    std::vector<Caret> all = allCarets(buffer, selectionAnchor, carets);
+
+    // Cursors are ordered by position, but a selection can start before the
+    // cursors ahead of it, so the ranges are sorted by their start to merge
+    struct Range {
+        std::size_t start;
+        std::size_t end;
+        std::size_t caret;
+    };
+    std::vector<Range> ranges;
+    ranges.reserve(all.size());
+    for (std::size_t i = 0; i < all.size(); i++) {
+        std::pair<std::size_t, std::size_t> range = rangeOf(all[i]);
+        ranges.push_back({range.first, range.second, i});
+    }
+    std::stable_sort(ranges.begin(), ranges.end(),
+                     [](const Range& a, const Range& b) { return a.start < b.start; });
+
+    std::vector<GapBuffer::Edit> edits;
+    edits.reserve(ranges.size());
+    for (const Range& range : ranges) {
+        if (!edits.empty() && range.start <= edits.back().offset + edits.back().removed) {
+            GapBuffer::Edit& last = edits.back();
+            last.removed = std::max(last.offset + last.removed, range.end) - last.offset;
+            continue;
+        }
+        edits.push_back({range.start, range.end - range.start, textOf(range.caret)});
+    }
+
+    bool changed = false;
+    for (const GapBuffer::Edit& edit : edits) {
+        changed = changed || edit.removed > 0 || !edit.inserted.empty();
+    }
+    buffer.applyEdits(edits);
+
+    // Each cursor lands after its inserted text, shifted by the edits before it
+    all.clear();
+    std::size_t added = 0;
+    std::size_t removed = 0;
+    for (const GapBuffer::Edit& edit : edits) {
+        added += edit.inserted.size();
+        all.push_back({edit.offset + added - removed, -1});
+        removed += edit.removed;
+    }
+    assignCarets(buffer, selectionAnchor, carets, all);
+    return changed;
+}
+
+std::pair<std::size_t, std::size_t> selectionOf(const Caret& caret) {
+    if (caret.anchor == -1) return {caret.position, caret.position};
+    std::size_t anchor = static_cast<std::size_t>(caret.anchor);
+    return {std::min(anchor, caret.position), std::max(anchor, caret.position)};
+}
+
+} // namespace
+
+void addCaret(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets, std::size_t offset) {
+    std::vector<Caret> all = carets;
+    all.push_back({buffer.getGapStart(), selectionAnchor});
+    all.push_back({std::min(offset, buffer.size()), -1});
+    setCarets(buffer, selectionAnchor, carets, std::move(all));
+}
+
+void setCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets, std::vector<Caret> all) {
+    if (all.empty()) return;
+    std::stable_sort(all.begin(), all.end(),
+                     [](const Caret& a, const Caret& b) { return a.position < b.position; });
+    assignCarets(buffer, selectionAnchor, carets, all);
+}
+
+std::string selectedTextAtCarets(const GapBuffer& buffer, int selectionAnchor, const std::vector<Caret>& carets) {
+    std::string text;
+    std::vector<Caret> all = allCarets(buffer, selectionAnchor, carets);
+    for (std::size_t i = 0; i < all.size(); i++) {
+        if (i > 0) text += '\n';
+        std::pair<std::size_t, std::size_t> range = selectionOf(all[i]);
+        text += buffer.getRange(range.first, range.second);
+    }
+    return text;
+}
+
+void insertAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                    const std::string& utf8) {
+    std::string_view text = utf8;
+    replaceAtCarets(buffer, selectionAnchor, carets, selectionOf, [&](std::size_t) { return text; });
+}
+
+void pasteAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                   const std::string& utf8) {
+    std::vector<std::string_view> lines;
+    std::string_view rest = utf8;
+    while (true) {
+        std::size_t nl = rest.find('\n');
+        lines.push_back(rest.substr(0, nl));
+        if (nl == std::string_view::npos) break;
+        rest.remove_prefix(nl + 1);
+    }
+    if (lines.size() != carets.size() + 1) {
+        insertAtCarets(buffer, selectionAnchor, carets, utf8);
+        return;
+    }
+    replaceAtCarets(buffer, selectionAnchor, carets, selectionOf, [&](std::size_t i) { return lines[i]; });
+}
+
+bool deleteBackwardAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets) {
+    return replaceAtCarets(buffer, selectionAnchor, carets, [&](const Caret& caret) {
+        if (caret.anchor != -1) return selectionOf(caret);
+        return std::make_pair(buffer.prevGraphemeBoundary(caret.position), caret.position);
+    }, [](std::size_t) { return std::string_view(); });
+}
+
+bool deleteForwardAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets) {
+    return replaceAtCarets(buffer, selectionAnchor, carets, [&](const Caret& caret) {
+        if (caret.anchor != -1) return selectionOf(caret);
+        return std::make_pair(caret.position, buffer.nextGraphemeBoundary(caret.position));
+    }, [](std::size_t) { return std::string_view(); });
+}
+
+void moveCaretsHorizontal(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                          bool right, bool extend, std::size_t count) {
+    // Targets are found without moving the gap; it moves once, to the last
+    std::vector<Caret> all = allCarets(buffer, selectionAnchor, carets);
+    for (Caret& caret : all) {
+        if (!extend) {
+            caret.anchor = -1;
+        } else if (caret.anchor == -1) {
+            caret.anchor = static_cast<int>(caret.position);
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            std::size_t next = right ? buffer.nextGraphemeBoundary(caret.position)
+                                     : buffer.prevGraphemeBoundary(caret.position);
+            if (next == caret.position) break;
+            caret.position = next;
+        }
+    }
+    assignCarets(buffer, selectionAnchor, carets, all);
+}
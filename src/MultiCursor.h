@@ -0,0 +1,48 @@
+//
+// MultiCursor.h - Editing at several cursors at once
+//
+// The primary cursor stays the gap start with its selectionAnchor, as for
+// the single-cursor commands in EditCommands. Extra cursors are kept in a
+// vector of carets, and the gap is always kept on the first or last cursor in
+// document order: an edit at every cursor then goes through
+// GapBuffer::applyEdits in one sweep toward the other end, which leaves the
+// gap on the cursor at that end, and the new positions follow from a running
+// offset in O(k).
+//
+
+#ifndef MULTICURSOR_H
+#define MULTICURSOR_H
+
+#include "GapBuffer.h"
+#include <string>
+#include <vector>
+
+// A cursor other than the gap, with its own selection anchor (-1 for none)
+struct Caret {
+    std::size_t position = 0;
+    int anchor = -1;
+};
+
+// Adds a cursor at offset; one already there is not duplicated
+void addCaret(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets, std::size_t offset);
+// Replaces every cursor, the primary one included, with `all`
+void setCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets, std::vector<Caret> all);
+
+// The selected text of every cursor in document order, one per line
+std::string selectedTextAtCarets(const GapBuffer& buffer, int selectionAnchor, const std::vector<Caret>& carets);
+
+// Types utf8 at every cursor, replacing the selections
+void insertAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                    const std::string& utf8);
+// Pastes utf8 at every cursor; text with one line per cursor (as copied from
+// them) is split up, a line to each
+void pasteAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                   const std::string& utf8);
+// Backspace and Delete at every cursor; true if the text changed
+bool deleteBackwardAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets);
+bool deleteForwardAtCarets(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets);
+// Left/Right by count graphemes for every cursor; cursors that meet merge
+void moveCaretsHorizontal(GapBuffer& buffer, int& selectionAnchor, std::vector<Caret>& carets,
+                          bool right, bool extend, std::size_t count = 1);
+
+#endif //MULTICURSOR_H
@@ -0,0 +1,159 @@
+//
+// ProfilerOverlay.cpp - Implementation of the profiler overlay
+//
+
+#include "ProfilerOverlay.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+ProfilerOverlay::ProfilerOverlay(const sf::Font& font) : label(font) {
+    panel.setFillColor(sf::Color(20, 20, 20, 220));
+    panel.setOutlineColor(sf::Color(90, 90, 90));
+    panel.setOutlineThickness(1.f);
+    label.setCharacterSize(13);
+    label.setFillColor(sf::Color(230, 230, 230));
+}
+
+sf::Color ProfilerOverlay::stageColor(FrameProfiler::Stage stage) {
+    static const sf::Color colors[FrameProfiler::STAGE_COUNT] = {
+        sf::Color(120, 120, 255),  // Input
+        sf::Color(160, 160, 160),  // Background
+        sf::Color(255, 170, 60),   // Layout
+        sf::Color(90, 200, 120),   // Status
+        sf::Color(240, 220, 70),   // Search
+        sf::Color(230, 90, 90),    // Draw
+        sf::Color(70, 70, 90),     // Present
+    };
+    return colors[stage];
+}
+
+void ProfilerOverlay::draw(sf::RenderWindow& window, const FrameProfiler& profiler, const LatencyTracker& latency,
+                           const FontCache& fonts, float top) {
+    const std::size_t stageCount = FrameProfiler::STAGE_COUNT;
+    float lineHeight = label.getFont().getLineSpacing(label.getCharacterSize());
+    float stagesHeight = PADDING * 3 + GRAPH_HEIGHT + lineHeight * static_cast<float>(stageCount + 1);
+    float height = stagesHeight + lineHeight * 2 + HISTOGRAM_HEIGHT + lineHeight * 3 + PADDING;
+    float left = static_cast<float>(window.getSize().x) - WIDTH - 22.f; // clear of the scrollbar
+
+    panel.setPosition({left, top});
+    panel.setSize({WIDTH, height});
+    window.draw(panel);
+
+    // Stacked bar per frame, newest on the right, one pixel wide each
+    float graphLeft = left + PADDING;
+    float graphBottom = top + PADDING + GRAPH_HEIGHT;
+    float pixelsPerMs = GRAPH_HEIGHT / GRAPH_SCALE_MS;
+    float barWidth = (WIDTH - 2 * PADDING) / static_cast<float>(FrameProfiler::CAPACITY);
+
+    bars.clear();
+    auto addRect = [&](float x, float y, float w, float h, sf::Color color) {
+        bars.append({{x, y}, color});
+        bars.append({{x + w, y}, color});
+        bars.append({{x, y + h}, color});
+        bars.append({{x, y + h}, color});
+        bars.append({{x + w, y}, color});
+        bars.append({{x + w, y + h}, color});
+    };
+
+    std::size_t frames = profiler.getFrameCount();
+    for (std::size_t age = 0; age < frames; age++) {
+        const FrameProfiler::Frame& frame = profiler.getFrame(age);
+        float x = graphLeft + static_cast<float>(FrameProfiler::CAPACITY - 1 - age) * barWidth;
+        float y = graphBottom;
+        for (std::size_t s = 0; s < stageCount && y > graphBottom - GRAPH_HEIGHT; s++) {
+            float h = std::min(static_cast<float>(frame.stageMs[s]) * pixelsPerMs, y - (graphBottom - GRAPH_HEIGHT));
+            y -= h;
+            addRect(x, y, barWidth, h, stageColor(static_cast<FrameProfiler::Stage>(s)));
+        }
+    }
+
+    // 60 FPS budget line
+    float budgetY = graphBottom - 16.7f * pixelsPerMs;
+    addRect(graphLeft, budgetY, WIDTH - 2 * PADDING, 1.f, sf::Color(255, 255, 255, 120));
+    window.draw(bars);
+
+    // Per-stage averages with a colour key
+    FrameProfiler::Frame avg = profiler.average();
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "avg %.2f ms   worst %.2f ms", avg.totalMs, profiler.worstFrameMs());
+    std::string summary = buffer;
+    // Includes the few this overlay's own text needs
+    std::snprintf(buffer, sizeof(buffer), "allocs/frame %.1f avg   %llu last", profiler.averageAllocations(),
+                  static_cast<unsigned long long>(frames ? profiler.getFrame(0).allocations : 0));
+    std::string allocations = buffer;
+    std::snprintf(buffer, sizeof(buffer), "\nglyph atlas %.0f KB in %zu sizes",
+                  static_cast<double>(fonts.getAtlasBytes()) / 1024.0, fonts.getAtlasCount());
+    allocations += buffer;
+
+    float textTop = graphBottom + PADDING;
+    for (std::size_t s = 0; s < stageCount; s++) {
+        std::snprintf(buffer, sizeof(buffer), "\n%-11s %7.3f ms",
+                      FrameProfiler::stageName(static_cast<FrameProfiler::Stage>(s)), avg.stageMs[s]);
+        summary += buffer;
+
+        sf::RectangleShape key({8.f, 8.f});
+        key.setFillColor(stageColor(static_cast<FrameProfiler::Stage>(s)));
+        key.setPosition({left + PADDING, textTop + lineHeight * static_cast<float>(s + 1) + 4.f});
+        window.draw(key);
+    }
+
+    label.setString(summary);
+    label.setPosition({left + PADDING + 14.f, textTop});
+    window.draw(label);
+
+    label.setString(allocations);
+    label.setPosition({left + PADDING, top + stagesHeight});
+    window.draw(label);
+
+    drawLatency(window, latency, left, top + stagesHeight + lineHeight * 2);
+}
+
+void ProfilerOverlay::drawLatency(sf::RenderWindow& window, const LatencyTracker& latency, float left, float top) {
+    float lineHeight = label.getFont().getLineSpacing(label.getCharacterSize());
+
+    std::array<std::uint64_t, LatencyTracker::BUCKETS> combined{};
+    std::uint64_t tallest = 1;
+    for (std::size_t k = 0; k < LatencyTracker::KIND_COUNT; k++) {
+        const auto& histogram = latency.getHistogram(static_cast<LatencyTracker::Kind>(k));
+        for (std::size_t b = 0; b < LatencyTracker::BUCKETS; b++) {
+            combined[b] += histogram[b];
+            tallest = std::max(tallest, combined[b]);
+        }
+    }
+
+    // One bar per bucket; buckets that reach past the budget are red
+    float graphTop = top + lineHeight * 2;
+    float slot = (WIDTH - 2 * PADDING) / static_cast<float>(LatencyTracker::BUCKETS);
+    for (std::size_t b = 0; b < LatencyTracker::BUCKETS; b++) {
+        float h = HISTOGRAM_HEIGHT * static_cast<float>(combined[b]) / static_cast<float>(tallest);
+        sf::RectangleShape bar({slot - 4.f, std::max(h, 1.f)});
+        bool overBudget = LatencyTracker::bucketLimitMs(b) > latency.getBudgetMs();
+        bar.setFillColor(overBudget ? sf::Color(230, 90, 90) : sf::Color(90, 200, 120));
+        bar.setPosition({left + PADDING + slot * static_cast<float>(b) + 2.f, graphTop + HISTOGRAM_HEIGHT - h});
+        window.draw(bar);
+    }
+
+    std::string text;
+    char buffer[96];
+    for (std::size_t k = 0; k < LatencyTracker::KIND_COUNT; k++) {
+        auto kind = static_cast<LatencyTracker::Kind>(k);
+        LatencySummary summary = latency.recent(kind);
+        std::snprintf(buffer, sizeof(buffer), "%s%-4s p50 %5.1f  p99 %5.1f ms  %zu over",
+                      k ? "\n" : "", LatencyTracker::kindName(kind), summary.p50Us / 1000.0,
+                      summary.p99Us / 1000.0, latency.getOverBudget(kind));
+        text += buffer;
+    }
+    label.setString(text);
+    label.setPosition({left + PADDING, top});
+    window.draw(label);
+
+    // Bucket edges (ms) under the gaps between bars
+    for (std::size_t b = 0; b + 1 < LatencyTracker::BUCKETS; b++) {
+        std::snprintf(buffer, sizeof(buffer), "%.0f", LatencyTracker::bucketLimitMs(b));
+        label.setString(buffer);
+        float x = left + PADDING + slot * static_cast<float>(b + 1) - label.getLocalBounds().size.x / 2.f;
+        label.setPosition({x, graphTop + HISTOGRAM_HEIGHT + 2.f});
+        window.draw(label);
+    }
+}
@@ -0,0 +1,37 @@
+//
+// ProfilerOverlay.h - Frame-time graph and per-stage breakdown drawn over the editor
+//
+
+#ifndef PROFILEROVERLAY_H
+#define PROFILEROVERLAY_H
+
+#include <SFML/Graphics.hpp>
+#include "FontCache.h"
+#include "FrameProfiler.h"
+#include "LatencyTracker.h"
+
+class ProfilerOverlay {
+public:
+    explicit ProfilerOverlay(const sf::Font& font);
+
+    // Draws in the top-right corner below the header, in UI coordinates
+    void draw(sf::RenderWindow& window, const FrameProfiler& profiler, const LatencyTracker& latency,
+              const FontCache& fonts, float top);
+
+private:
+    static constexpr float WIDTH = 260.f;
+    static constexpr float GRAPH_HEIGHT = 80.f;
+    static constexpr float GRAPH_SCALE_MS = 33.3f;   // frame time at the top of the graph
+    static constexpr float PADDING = 10.f;
+    static constexpr float HISTOGRAM_HEIGHT = 40.f;
+
+    sf::RectangleShape panel;
+    sf::Text label;
+    sf::VertexArray bars{sf::PrimitiveType::Triangles};
+
+    static sf::Color stageColor(FrameProfiler::Stage stage);
+    // Keystroke latency histogram (text and keys combined) with percentiles
+    void drawLatency(sf::RenderWindow& window, const LatencyTracker& latency, float left, float top);
+};
+
+#endif //PROFILEROVERLAY_H
@@ -81,7 +81,7 @@ void Scrollbar::draw(sf::RenderWindow& window, const sf::FloatRect& textBounds,
     float windowH = static_cast<float>(window.getSize().y);
     
     // Draw Track
-    sf::RectangleShape scrollTrack({12.f, windowH});
+    scrollTrack.setSize({12.f, windowH});
     scrollTrack.setFillColor(darkTheme ? sf::Color(40, 40, 40) : sf::Color(210, 210, 210));
     scrollTrack.setPosition(sf::Vector2f(windowW - 12.f, 0.f));
     window.draw(scrollTrack);
@@ -97,7 +97,7 @@ void Scrollbar::draw(sf::RenderWindow& window, const sf::FloatRect& textBounds,
         float ratio = scrollOffset / maxScrollY;
         float thumbY = ratio * (windowH - thumbHeight);
 
-        sf::RectangleShape scrollThumb({10.f, thumbHeight});
+        scrollThumb.setSize({10.f, thumbHeight});
         scrollThumb.setFillColor(darkTheme ? sf::Color(150, 150, 150) : sf::Color(120, 120, 120));
         scrollThumb.setPosition(sf::Vector2f(windowW - 11.f, thumbY));
         scrollThumb.setOutlineColor(darkTheme ? sf::Color(80, 80, 80) : sf::Color(160, 160, 160));
@@ -26,4 +26,7 @@ private:
     bool isDragging;
     sf::Vector2i mousePressPos;
     bool darkTheme = true;
+    // Kept between frames so drawing doesn't rebuild their geometry
+    sf::RectangleShape scrollTrack;
+    sf::RectangleShape scrollThumb;
 };
\ No newline at end of file
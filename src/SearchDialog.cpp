@@ -3,6 +3,7 @@
 //
 
 #include "SearchDialog.h"
+#include "TextSearch.h"
 #include <algorithm>
 
 SearchDialog::SearchDialog(const sf::Font& font)
@@ -105,18 +106,7 @@ void SearchDialog::updateSearch(const std::string& text) {
     }
 
     // Case-insensitive search
-    std::string lowerText = text;
-    std::string lowerQuery = searchQuery;
-
-    std::transform(lowerText.begin(), lowerText.end(), lowerText.begin(), ::tolower);
-    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
-
-    // Find all matches
-    size_t pos = 0;
-    while ((pos = lowerText.find(lowerQuery, pos)) != std::string::npos) {
-        matchPositions.push_back(pos);
-        pos += 1;  // Continue searching from next character
-    }
+    matchPositions = findAllMatches(text, searchQuery);
 
     // Set to first match if any found
     if (!matchPositions.empty()) {
@@ -162,11 +152,13 @@ int SearchDialog::getTotalMatches() const {
     return matchPositions.size();
 }
 
-void SearchDialog::update() {
+bool SearchDialog::update() {
     // Update cursor blinking
+    bool blinked = false;
     if (cursorBlinkClock.getElapsedTime() >= sf::milliseconds(500)) {
         cursorVisible = !cursorVisible;
         cursorBlinkClock.restart();
+        blinked = isVisible;
     }
 
     // Update search text display
@@ -187,6 +179,7 @@ void SearchDialog::update() {
         resultText.setString("Type to search... (Esc to close)");
         resultText.setFillColor(sf::Color(200, 200, 200));
     }
+    return blinked;
 }
 
 void SearchDialog::draw(sf::RenderWindow& window) {
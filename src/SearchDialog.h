@@ -48,7 +48,8 @@ public:
     int getCurrentMatchIndex() const;
     int getTotalMatches() const;
 
-    void update();
+    // Returns true when the caret blinked and the dialog needs a redraw
+    bool update();
     void draw(sf::RenderWindow& window);
 
     void setPosition(sf::Vector2f windowSize);
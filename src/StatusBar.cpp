@@ -3,8 +3,57 @@
 //
 
 #include "StatusBar.h"
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <string_view>
+#include <type_traits>
+
+namespace {
+
+// Field text built on the stack, with numbers written by std::to_chars
+class FieldText {
+public:
+    FieldText& operator<<(std::string_view text) {
+        size_t count = std::min(text.size(), static_cast<size_t>(limit() - end));
+        end = std::copy_n(text.data(), count, end);
+        return *this;
+    }
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    FieldText& operator<<(T value) {
+        end = std::to_chars(end, limit(), value).ptr;
+        return *this;
+    }
+    const char* c_str() {
+        *end = '\0';
+        return data;
+    }
+
+private:
+    char data[128];
+    char* end = data;
+    char* limit() { return data + sizeof(data) - 1; }
+};
+
+// "0 B", "512.0 B", "1.5 KB": one decimal, formatted as integer tenths rounded
+// like printf's %.1f
+void appendFileSize(FieldText& out, size_t bytes) {
+    if (bytes == 0) {
+        out << "0 B";
+        return;
+    }
+    const char* units[] = {"B", "KB", "MB", "GB"};
+    int unitIndex = 0;
+    double size = static_cast<double>(bytes);
+    while (size >= 1024.0 && unitIndex < 3) {
+        size /= 1024.0;
+        unitIndex++;
+    }
+    auto tenths = static_cast<unsigned long long>(std::nearbyint(size * 10.0));
+    out << tenths / 10 << "." << tenths % 10 << " " << units[unitIndex];
+}
+
+} // namespace
 
 StatusBar::StatusBar(const sf::Font& font, float windowWidth)
     : width(windowWidth),
@@ -13,7 +62,9 @@ StatusBar::StatusBar(const sf::Font& font, float windowWidth)
       wordCountText(font),
       fileSizeText(font),
       modifiedIndicator(font),
-      fontSizeText(font) {
+      fontSizeText(font),
+      messageText(font),
+      selectionText(font) {
     
     // Background - positioned at bottom will be done in draw()
     background.setSize(sf::Vector2f(width, HEIGHT));
@@ -39,103 +90,162 @@ StatusBar::StatusBar(const sf::Font& font, float windowWidth)
     
     modifiedIndicator.setCharacterSize(14);
     modifiedIndicator.setPosition(sf::Vector2f(width - 30, 0)); // Y will be set dynamically
+    
+    messageText.setCharacterSize(12);
+    messageText.setPosition(sf::Vector2f(500, 0)); // Y will be set dynamically
+    
+    selectionText.setCharacterSize(12);
+    selectionText.setPosition(sf::Vector2f(500, 0)); // Y will be set dynamically
 }
 
 StatusMetrics StatusBar::calculateMetrics(const GapBuffer& buffer, bool unsavedChanges,
                                           int selectionAnchor, unsigned int fontSize) {
-    std::string content = buffer.getString();
+    StatusMetrics metrics = shown;
+    metrics.isModified = unsavedChanges;
+    metrics.fontSize = fontSize;
+
+    size_t version = buffer.getVersion();
     size_t cursorPos = buffer.getGapStart();
-    
-    // Calculate line and column
-    size_t line = 1, column = 0;
-    for (size_t i = 0; i < cursorPos && i < content.length(); i++) {
-        if (content[i] == '\n') {
-            line++;
-            column = 0;
-        } else {
-            column++;
-        }
-    }
-    
-    // Character count
-    size_t charCount = content.length();
-    
-    // Word count
-    size_t wordCount = countWords(content);
-    
-    // Line count
-    size_t lineCount = 1;
-    for (char c : content) {
-        if (c == '\n') lineCount++;
+    bool textChanged = !fieldsValid || version != countedVersion;
+    if (!textChanged && cursorPos == countedCursor && selectionAnchor == countedAnchor) {
+        return metrics;
     }
-    
-    return {line, column, charCount, wordCount, lineCount, unsavedChanges, fontSize};
-}
+    countedVersion = version;
+    countedCursor = cursorPos;
+    countedAnchor = selectionAnchor;
+
+    // Line from the newlines before the cursor
+    ChunkSummary beforeCursor = buffer.statistics(0, cursorPos);
+    metrics.line = beforeCursor.newlines + 1;
 
-std::string StatusBar::formatFileSize(size_t bytes) {
-    if (bytes == 0) return "0 B";
+    // Byte offset where the cursor's line starts; the cursor is the gap, so
+    // everything before it is one run
+    std::string_view before = buffer.spans().before;
+    size_t lastNewline = before.rfind('\n');
+    size_t lineStart = lastNewline == std::string_view::npos ? 0 : lastNewline + 1;
     
-    const char* units[] = {"B", "KB", "MB", "GB"};
-    int unitIndex = 0;
-    double size = static_cast<double>(bytes);
+    // Column counts code points, not bytes, so multi-byte characters count once
+    metrics.column = beforeCursor.codePoints - buffer.codePointIndex(lineStart);
     
-    while (size >= 1024.0 && unitIndex < 3) {
-        size /= 1024.0;
-        unitIndex++;
+    if (textChanged) {
+        ChunkSummary total = buffer.statistics(0, buffer.size());
+        metrics.charCount = total.codePoints;
+        metrics.byteCount = total.bytes;
+        metrics.wordCount = total.wordStarts;
+        metrics.lineCount = total.newlines + 1;
     }
-    
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(1) << size << " " << units[unitIndex];
-    return oss.str();
-}
 
-size_t StatusBar::countWords(const std::string& text) {
-    if (text.empty()) return 0;
-    
-    size_t wordCount = 0;
-    bool inWord = false;
-    
-    for (char c : text) {
-        if (std::isspace(static_cast<unsigned char>(c))) {
-            inWord = false;
-        } else if (!inWord) {
-            inWord = true;
-            wordCount++;
-        }
+    metrics.selectedChars = metrics.selectedWords = metrics.selectedLines = 0;
+    if (selectionAnchor != -1 && static_cast<size_t>(selectionAnchor) != cursorPos) {
+        size_t anchor = static_cast<size_t>(selectionAnchor);
+        ChunkSummary selected = buffer.statistics(std::min(anchor, cursorPos), std::max(anchor, cursorPos));
+        metrics.selectedChars = selected.codePoints;
+        metrics.selectedWords = selected.wordStarts;
+        metrics.selectedLines = selected.newlines + 1;
     }
-    
-    return wordCount;
+    return metrics;
 }
 
 void StatusBar::update(const GapBuffer& buffer, bool unsavedChanges,
                        int selectionAnchor, unsigned int fontSize) {
     StatusMetrics metrics = calculateMetrics(buffer, unsavedChanges, selectionAnchor, fontSize);
-    
+    bool all = !fieldsValid;
+
     // Update line and column
-    std::ostringstream lineColStream;
-    lineColStream << "Ln " << metrics.line << ", Col " << metrics.column;
-    lineColText.setString(lineColStream.str());
+    if (all || metrics.line != shown.line || metrics.column != shown.column) {
+        FieldText field;
+        field << "Ln " << metrics.line << ", Col " << metrics.column;
+        lineColText.setString(field.c_str());
+    }
     
     // Update character count
-    std::ostringstream charStream;
-    charStream << metrics.charCount << " chars";
-    charCountText.setString(charStream.str());
+    if (all || metrics.charCount != shown.charCount) {
+        FieldText field;
+        field << metrics.charCount << " chars";
+        charCountText.setString(field.c_str());
+    }
     
     // Update word count
-    std::ostringstream wordStream;
-    wordStream << metrics.wordCount << " words";
-    wordCountText.setString(wordStream.str());
+    if (all || metrics.wordCount != shown.wordCount) {
+        FieldText field;
+        field << metrics.wordCount << " words";
+        wordCountText.setString(field.c_str());
+    }
     
     // Update file size
-    fileSizeText.setString(formatFileSize(metrics.charCount));
+    if (all || metrics.byteCount != shown.byteCount) {
+        FieldText field;
+        appendFileSize(field, metrics.byteCount);
+        fileSizeText.setString(field.c_str());
+    }
     
     // Update font size
-    std::ostringstream fontStream;
-    fontStream << "Text Size: " << metrics.fontSize << "pt";
-    fontSizeText.setString(fontStream.str());
+    if (all || metrics.fontSize != shown.fontSize) {
+        FieldText field;
+        field << "Text Size: " << metrics.fontSize << "pt";
+        fontSizeText.setString(field.c_str());
+    }
     
     // Update modified indicator
-    modifiedIndicator.setString(metrics.isModified ? "●" : "");
+    if (all || metrics.isModified != shown.isModified) {
+        modifiedIndicator.setString(metrics.isModified ? sf::String(U"\u25CF") : sf::String());
+    }
+    
+    // Update selection summary
+    if (all || metrics.selectedChars != shown.selectedChars || metrics.selectedWords != shown.selectedWords ||
+        metrics.selectedLines != shown.selectedLines) {
+        FieldText field;
+        if (metrics.selectedChars > 0) {
+            field << "Selected: " << metrics.selectedChars << " chars, " << metrics.selectedWords << " words, "
+                  << metrics.selectedLines << " lines";
+        }
+        selectionText.setString(field.c_str());
+    }
+
+    shown = metrics;
+    fieldsValid = true;
+}
+
+void StatusBar::updateLargeFile(size_t topLine, size_t estimatedLines, size_t fileBytes,
+                                unsigned int fontSize) {
+    // Shares the fields with update(), which has to refill them all afterwards
+    fieldsValid = false;
+
+    FieldText line;
+    line << "Ln " << topLine;
+    lineColText.setString(line.c_str());
+    
+    FieldText lines;
+    lines << "~" << estimatedLines << " lines";
+    charCountText.setString(lines.c_str());
+    
+    wordCountText.setString("read-only");
+    FieldText size;
+    appendFileSize(size, fileBytes);
+    fileSizeText.setString(size.c_str());
+    
+    FieldText fontSizeField;
+    fontSizeField << "Text Size: " << fontSize << "pt";
+    fontSizeText.setString(fontSizeField.c_str());
+    
+    modifiedIndicator.setString("");
+    selectionText.setString("");
+}
+
+void StatusBar::setMessage(const std::string& message) {
+    hasMessage = !message.empty();
+    messageText.setString(message);
+}
+
+void StatusBar::setProgress(const std::string& task, double fraction, double bytesPerSecond,
+                            const std::string& hint) {
+    FieldText field;
+    field << task << " " << static_cast<int>(fraction * 100.0) << "% (";
+    appendFileSize(field, static_cast<size_t>(bytesPerSecond));
+    field << "/s)";
+    if (!hint.empty()) field << " - " << hint;
+    hasMessage = true;
+    messageText.setString(field.c_str());
 }
 
 void StatusBar::draw(sf::RenderWindow& window, const Theme& theme) {
@@ -159,6 +269,8 @@ void StatusBar::draw(sf::RenderWindow& window, const Theme& theme) {
     wordCountText.setFillColor(theme.textColor());
     fileSizeText.setFillColor(theme.textColor());
     fontSizeText.setFillColor(theme.textColor());
+    messageText.setFillColor(theme.dimText());
+    selectionText.setFillColor(theme.dimText());
     modifiedIndicator.setFillColor(theme.isDark ? sf::Color::Yellow : sf::Color(200, 100, 0));
     
     // Update Y positions for all text
@@ -167,6 +279,8 @@ void StatusBar::draw(sf::RenderWindow& window, const Theme& theme) {
     charCountText.setPosition(sf::Vector2f(150, textY));
     wordCountText.setPosition(sf::Vector2f(280, textY));
     fileSizeText.setPosition(sf::Vector2f(400, textY));
+    messageText.setPosition(sf::Vector2f(500, textY));
+    selectionText.setPosition(sf::Vector2f(500, textY));
     fontSizeText.setPosition(sf::Vector2f(width - 180, textY));
     modifiedIndicator.setPosition(sf::Vector2f(width - 30, textY - 2.0f));
     
@@ -176,6 +290,11 @@ void StatusBar::draw(sf::RenderWindow& window, const Theme& theme) {
     window.draw(wordCountText);
     window.draw(fileSizeText);
     window.draw(fontSizeText);
+    if (hasMessage) {
+        window.draw(messageText);
+    } else {
+        window.draw(selectionText);
+    }
     window.draw(modifiedIndicator);
 }
 
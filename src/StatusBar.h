@@ -12,11 +12,15 @@
 struct StatusMetrics {
     size_t line;
     size_t column;
-    size_t charCount;
+    size_t charCount;   // code points
+    size_t byteCount;
     size_t wordCount;
     size_t lineCount;
     bool isModified;
     unsigned int fontSize;
+    size_t selectedChars;   // 0 without a selection
+    size_t selectedWords;
+    size_t selectedLines;
 };
 
 class StatusBar {
@@ -30,20 +34,39 @@ private:
     sf::Text fileSizeText;
     sf::Text modifiedIndicator;
     sf::Text fontSizeText;
+    sf::Text messageText;
+    sf::Text selectionText;     // shown in the message slot while it is empty
+    bool hasMessage = false;
     
     float width;
     
+    // What the fields show now; update() only rebuilds the ones that differ.
+    // Counts come from the buffer's chunk index, so even totals and large
+    // selections are O(log n); they are only queried again when the version,
+    // cursor or selection anchor changes.
+    StatusMetrics shown{};
+    bool fieldsValid = false;       // false until update() fills every field
+    size_t countedVersion = 0;
+    size_t countedCursor = 0;
+    int countedAnchor = -1;
+    
     // Helper functions
     StatusMetrics calculateMetrics(const GapBuffer& buffer, bool unsavedChanges, 
                                    int selectionAnchor, unsigned int fontSize);
-    std::string formatFileSize(size_t bytes);
-    size_t countWords(const std::string& text);
 
 public:
     StatusBar(const sf::Font& font, float windowWidth);
     
     void update(const GapBuffer& buffer, bool unsavedChanges, 
                 int selectionAnchor, unsigned int fontSize);
+    // Metrics for a read-only large file, where only the top visible line is known
+    void updateLargeFile(size_t topLine, size_t estimatedLines, size_t fileBytes,
+                         unsigned int fontSize);
+    // Free-form status such as background task progress ("" hides it)
+    void setMessage(const std::string& message);
+    // e.g. "Loading 42% (120.3 MB/s)" followed by an optional hint
+    void setProgress(const std::string& task, double fraction, double bytesPerSecond,
+                     const std::string& hint = "");
     void draw(sf::RenderWindow& window, const Theme& theme);
     void setWidth(float newWidth);
     
@@ -0,0 +1,492 @@
+//
+// SyntaxHighlighter.cpp - Line tokenizers and incrementally updated token runs
+//
+
+#include "SyntaxHighlighter.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+// C/C++ line states
+constexpr LineState CPP_NORMAL = 0;
+constexpr LineState CPP_BLOCK_COMMENT = 1;
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Bytes of multi-byte UTF-8 sequences count as letters, so words in any
+// script stay whole
+bool isWordStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool isWordChar(char c) {
+    return isWordStart(c) || isDigit(c);
+}
+
+std::size_t wordEnd(std::string_view line, std::size_t i) {
+    while (i < line.size() && isWordChar(line[i])) i++;
+    return i;
+}
+
+void push(std::vector<TokenRun>& out, std::size_t start, std::size_t end, TokenKind kind) {
+    if (end > start) {
+        out.push_back({static_cast<std::uint32_t>(start), static_cast<std::uint32_t>(end - start), kind});
+    }
+}
+
+// End of the quoted string starting at i, or of the line if it is unclosed
+std::size_t quotedEnd(std::string_view line, std::size_t i) {
+    char quote = line[i];
+    for (std::size_t j = i + 1; j < line.size(); j++) {
+        if (line[j] == '\\') {
+            j++;
+        } else if (line[j] == quote) {
+            return j + 1;
+        }
+    }
+    return line.size();
+}
+
+std::vector<std::string_view> sorted(std::vector<std::string_view> words) {
+    std::sort(words.begin(), words.end());
+    return words;
+}
+
+bool contains(const std::vector<std::string_view>& words, std::string_view word) {
+    return std::binary_search(words.begin(), words.end(), word);
+}
+
+const std::vector<std::string_view>& cppKeywords() {
+    static const std::vector<std::string_view> words = sorted({
+        "alignas", "alignof", "asm", "break", "case", "catch", "class", "concept", "const", "const_cast",
+        "consteval", "constexpr", "constinit", "continue", "co_await", "co_return", "co_yield", "decltype",
+        "default", "delete", "do", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+        "final", "for", "friend", "goto", "if", "inline", "mutable", "namespace", "new", "noexcept", "nullptr",
+        "operator", "override", "private", "protected", "public", "register", "reinterpret_cast", "requires",
+        "return", "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this",
+        "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union", "using", "virtual",
+        "volatile", "while",
+    });
+    return words;
+}
+
+const std::vector<std::string_view>& cppTypes() {
+    static const std::vector<std::string_view> words = sorted({
+        "auto", "bool", "char", "char16_t", "char32_t", "char8_t", "double", "float", "int", "int16_t",
+        "int32_t", "int64_t", "int8_t", "long", "ptrdiff_t", "short", "signed", "size_t", "uint16_t",
+        "uint32_t", "uint64_t", "uint8_t", "unsigned", "void", "wchar_t",
+    });
+    return words;
+}
+
+LineState tokenizeCpp(std::string_view line, LineState state, std::vector<TokenRun>& out) {
+    const std::size_t n = line.size();
+    std::size_t i = 0;
+
+    if (state == CPP_BLOCK_COMMENT) {
+        std::size_t close = line.find("*/");
+        if (close == std::string_view::npos) {
+            push(out, 0, n, TokenKind::Comment);
+            return CPP_BLOCK_COMMENT;
+        }
+        i = close + 2;
+        push(out, 0, i, TokenKind::Comment);
+    } else {
+        // A directive: '#' and its name, then the rest as ordinary code
+        std::size_t first = line.find_first_not_of(" \t");
+        if (first != std::string_view::npos && line[first] == '#') {
+            std::size_t j = line.find_first_not_of(" \t", first + 1);
+            j = j == std::string_view::npos ? n : wordEnd(line, j);
+            push(out, first, j, TokenKind::Preprocessor);
+            i = j;
+        }
+    }
+
+    while (i < n) {
+        char c = line[i];
+        char next = i + 1 < n ? line[i + 1] : '\0';
+        if (c == '/' && next == '/') {
+            push(out, i, n, TokenKind::Comment);
+            return CPP_NORMAL;
+        }
+        if (c == '/' && next == '*') {
+            std::size_t close = line.find("*/", i + 2);
+            if (close == std::string_view::npos) {
+                push(out, i, n, TokenKind::Comment);
+                return CPP_BLOCK_COMMENT;
+            }
+            push(out, i, close + 2, TokenKind::Comment);
+            i = close + 2;
+        } else if (c == '"' || c == '\'') {
+            std::size_t j = quotedEnd(line, i);
+            push(out, i, j, TokenKind::String);
+            i = j;
+        } else if (isDigit(c) || (c == '.' && isDigit(next))) {
+            // Suffixes, hex digits, digit separators and signed exponents
+            std::size_t j = i + 1;
+            while (j < n && (isWordChar(line[j]) || line[j] == '.' || line[j] == '\'' ||
+                             ((line[j] == '+' || line[j] == '-') &&
+                              (line[j - 1] == 'e' || line[j - 1] == 'E' ||
+                               line[j - 1] == 'p' || line[j - 1] == 'P')))) {
+                j++;
+            }
+            push(out, i, j, TokenKind::Number);
+            i = j;
+        } else if (isWordStart(c)) {
+            std::size_t j = wordEnd(line, i);
+            std::string_view word = line.substr(i, j - i);
+            if (contains(cppKeywords(), word)) {
+                push(out, i, j, TokenKind::Keyword);
+            } else if (contains(cppTypes(), word)) {
+                push(out, i, j, TokenKind::Type);
+            }
+            i = j;
+        } else {
+            i++;
+        }
+    }
+    return CPP_NORMAL;
+}
+
+LineState tokenizeJson(std::string_view line, std::vector<TokenRun>& out) {
+    const std::size_t n = line.size();
+    std::size_t i = 0;
+    while (i < n) {
+        char c = line[i];
+        if (c == '"') {
+            // A string followed by ':' is a key
+            std::size_t j = quotedEnd(line, i);
+            std::size_t after = line.find_first_not_of(" \t", j);
+            bool key = after != std::string_view::npos && line[after] == ':';
+            push(out, i, j, key ? TokenKind::Key : TokenKind::String);
+            i = j;
+        } else if (c == '-' || isDigit(c)) {
+            std::size_t j = i + 1;
+            while (j < n && (isDigit(line[j]) || line[j] == '.' || line[j] == 'e' || line[j] == 'E' ||
+                             line[j] == '+' || line[j] == '-')) {
+                j++;
+            }
+            push(out, i, j, TokenKind::Number);
+            i = j;
+        } else if (isWordStart(c)) {
+            std::size_t j = wordEnd(line, i);
+            std::string_view word = line.substr(i, j - i);
+            if (word == "true" || word == "false" || word == "null") {
+                push(out, i, j, TokenKind::Keyword);
+            }
+            i = j;
+        } else {
+            i++;
+        }
+    }
+    return 0;
+}
+
+bool digitsAt(std::string_view line, std::size_t at, std::size_t count) {
+    if (at + count > line.size()) return false;
+    for (std::size_t k = 0; k < count; k++) {
+        if (!isDigit(line[at + k])) return false;
+    }
+    return true;
+}
+
+// hh:mm:ss with an optional fraction and zone; returns `at` if there is none
+std::size_t matchTime(std::string_view line, std::size_t at) {
+    if (!digitsAt(line, at, 2) || at + 8 > line.size() || line[at + 2] != ':' ||
+        !digitsAt(line, at + 3, 2) || line[at + 5] != ':' || !digitsAt(line, at + 6, 2)) {
+        return at;
+    }
+    std::size_t j = at + 8;
+    if (j + 1 < line.size() && (line[j] == '.' || line[j] == ',') && isDigit(line[j + 1])) {
+        j++;
+        while (j < line.size() && isDigit(line[j])) j++;
+    }
+    if (j < line.size() && line[j] == 'Z') {
+        j++;
+    } else if (j < line.size() && (line[j] == '+' || line[j] == '-') && digitsAt(line, j + 1, 2)) {
+        j += 3;
+        if (j < line.size() && line[j] == ':' && digitsAt(line, j + 1, 2)) {
+            j += 3;
+        } else if (digitsAt(line, j, 2)) {
+            j += 2;
+        }
+    }
+    return j;
+}
+
+// yyyy-mm-dd (or with '/'), optionally followed by 'T' or ' ' and a time; or
+// a time on its own. Returns `at` if neither starts there.
+std::size_t matchTimestamp(std::string_view line, std::size_t at) {
+    if (digitsAt(line, at, 4) && at + 10 <= line.size() && (line[at + 4] == '-' || line[at + 4] == '/') &&
+        digitsAt(line, at + 5, 2) && line[at + 7] == line[at + 4] && digitsAt(line, at + 8, 2)) {
+        std::size_t j = at + 10;
+        if (j < line.size() && (line[j] == 'T' || line[j] == ' ')) {
+            std::size_t time = matchTime(line, j + 1);
+            if (time != j + 1) return time;
+        }
+        return j;
+    }
+    return matchTime(line, at);
+}
+
+// Level names in upper or lower case
+TokenKind logLevel(std::string_view word) {
+    static const std::vector<std::string_view> errors = sorted(
+        {"ALERT", "CRIT", "CRITICAL", "EMERG", "ERR", "ERROR", "FATAL", "PANIC", "SEVERE"});
+    static const std::vector<std::string_view> warnings = sorted({"WARN", "WARNING"});
+    static const std::vector<std::string_view> infos = sorted({"INFO", "NOTICE"});
+    static const std::vector<std::string_view> debugs = sorted({"DEBUG", "TRACE", "VERBOSE"});
+
+    if (word.size() > 8) return TokenKind::Text;
+    char upper[8];
+    bool allUpper = true;
+    bool allLower = true;
+    for (std::size_t k = 0; k < word.size(); k++) {
+        char c = word[k];
+        allUpper = allUpper && c >= 'A' && c <= 'Z';
+        allLower = allLower && c >= 'a' && c <= 'z';
+        upper[k] = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    if (!allUpper && !allLower) return TokenKind::Text;
+
+    std::string_view key(upper, word.size());
+    if (contains(errors, key)) return TokenKind::Error;
+    if (contains(warnings, key)) return TokenKind::Warning;
+    if (contains(infos, key)) return TokenKind::Info;
+    if (contains(debugs, key)) return TokenKind::Debug;
+    return TokenKind::Text;
+}
+
+LineState tokenizeLog(std::string_view line, std::vector<TokenRun>& out) {
+    const std::size_t n = line.size();
+    std::size_t i = 0;
+    while (i < n) {
+        char c = line[i];
+        if (isDigit(c) && (i == 0 || !isWordChar(line[i - 1]))) {
+            std::size_t j = matchTimestamp(line, i);
+            if (j != i) {
+                push(out, i, j, TokenKind::Timestamp);
+            } else {
+                j = i + 1;
+                bool hex = c == '0' && j < n && (line[j] == 'x' || line[j] == 'X');
+                if (hex) j++;
+                while (j < n && (isDigit(line[j]) || line[j] == '.' ||
+                                 (hex && std::isxdigit(static_cast<unsigned char>(line[j]))))) {
+                    j++;
+                }
+                // Digits that run into letters are part of an identifier
+                if (j < n && isWordStart(line[j])) {
+                    j = wordEnd(line, j);
+                } else {
+                    push(out, i, j, TokenKind::Number);
+                }
+            }
+            i = j;
+        } else if (isWordStart(c)) {
+            std::size_t j = wordEnd(line, i);
+            TokenKind level = logLevel(line.substr(i, j - i));
+            if (level != TokenKind::Text) {
+                push(out, i, j, level);
+            }
+            i = j;
+        } else if (c == '"') {
+            std::size_t j = quotedEnd(line, i);
+            push(out, i, j, TokenKind::String);
+            i = j;
+        } else {
+            i++;
+        }
+    }
+    return 0;
+}
+
+// Line starting at `offset`, without its '\n'; copied into `scratch` only
+// when it straddles the gap
+std::string_view readLine(const GapBuffer::Spans& spans, std::size_t offset, std::string& scratch) {
+    if (offset < spans.before.size()) {
+        std::size_t nl = spans.before.find('\n', offset);
+        if (nl != std::string_view::npos) return spans.before.substr(offset, nl - offset);
+        std::size_t end = std::min(spans.after.find('\n'), spans.after.size());
+        scratch.assign(spans.before.data() + offset, spans.before.size() - offset);
+        scratch.append(spans.after.data(), end);
+        return scratch;
+    }
+    std::size_t at = std::min(offset - spans.before.size(), spans.after.size());
+    std::size_t nl = std::min(spans.after.find('\n', at), spans.after.size());
+    return spans.after.substr(at, nl - at);
+}
+
+} // namespace
+
+Language languageForPath(const std::string& path) {
+    std::size_t dot = path.find_last_of('.');
+    std::size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return Language::Plain;
+
+    std::string ext = path.substr(dot + 1);
+    for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    if (ext == "log" || ext == "out") return Language::Log;
+    if (ext == "json") return Language::Json;
+    if (ext == "c" || ext == "h" || ext == "cc" || ext == "cpp" || ext == "cxx" || ext == "hh" ||
+        ext == "hpp" || ext == "hxx" || ext == "inl") {
+        return Language::Cpp;
+    }
+    return Language::Plain;
+}
+
+const char* languageName(Language language) {
+    switch (language) {
+        case Language::Log:  return "Log";
+        case Language::Cpp:  return "C/C++";
+        case Language::Json: return "JSON";
+        default:             return "Plain text";
+    }
+}
+
+LineState tokenizeLine(Language language, std::string_view line, LineState start, std::vector<TokenRun>& out) {
+    switch (language) {
+        case Language::Log:  return tokenizeLog(line, out);
+        case Language::Cpp:  return tokenizeCpp(line, start, out);
+        case Language::Json: return tokenizeJson(line, out);
+        default:             return start;
+    }
+}
+
+void SyntaxHighlighter::setLanguage(Language newLanguage) {
+    if (newLanguage == language) return;
+    language = newLanguage;
+    lines.clear();
+    firstInvalid = endInvalid = 0;
+}
+
+Language SyntaxHighlighter::getLanguage() const {
+    return language;
+}
+
+void SyntaxHighlighter::reset() {
+    lines.clear();
+    firstInvalid = endInvalid = 0;
+}
+
+void SyntaxHighlighter::markInvalid(std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+        lines[i].valid = false;
+    }
+    if (firstInvalid >= endInvalid) {
+        firstInvalid = begin;
+        endInvalid = end;
+    } else {
+        firstInvalid = std::min(firstInvalid, begin);
+        endInvalid = std::max(endInvalid, end);
+    }
+}
+
+void SyntaxHighlighter::noteEdit(const GapBuffer& buffer, const GapBuffer::Edit& edit) {
+    // Nothing is tokenized yet (or the text is plain); update() counts the lines
+    if (lines.empty()) return;
+
+    // Old lines [first, first + removed] became new lines [first, first + inserted]
+    std::size_t newCount = buffer.lineIndex(buffer.size()) + 1;
+    std::size_t inserted = static_cast<std::size_t>(std::count(edit.inserted.begin(), edit.inserted.end(), '\n'));
+    std::size_t removed = lineCount + inserted > newCount ? lineCount + inserted - newCount : 0;
+    lineCount = newCount;
+
+    std::size_t first = buffer.lineIndex(edit.offset);
+    if (first >= lines.size()) return;
+    if (first + removed >= lines.size()) {
+        // Reaches past what was tokenized; the rest is tokenized afresh
+        lines.resize(first);
+        endInvalid = std::min(endInvalid, first);
+        return;
+    }
+
+    // The last new line inherits the end state the line after it started from
+    LineState endState = lines[first + removed].endState;
+    auto at = lines.begin() + static_cast<std::ptrdiff_t>(first + 1);
+    if (inserted > removed) {
+        lines.insert(at, inserted - removed, Line());
+    } else if (removed > inserted) {
+        lines.erase(at, at + static_cast<std::ptrdiff_t>(removed - inserted));
+    }
+    // Bounds of the invalid range move with the lines after the replaced
+    // ones; a bound among the replaced lines moves to the new lines' edge
+    if (firstInvalid < endInvalid) {
+        std::size_t oldEnd = first + removed + 1;
+        if (firstInvalid >= oldEnd) {
+            firstInvalid = firstInvalid + inserted - removed;
+        } else if (firstInvalid > first) {
+            firstInvalid = first;
+        }
+        if (endInvalid > oldEnd) {
+            endInvalid = endInvalid + inserted - removed;
+        } else if (endInvalid > first) {
+            endInvalid = first + inserted + 1;
+        }
+    }
+    markInvalid(first, first + inserted + 1);
+    lines[first + inserted].endState = endState;
+}
+
+void SyntaxHighlighter::update(const GapBuffer& buffer, std::size_t lastLine) {
+    linesTokenized = 0;
+    if (language == Language::Plain) return;
+    if (lines.empty()) {
+        lineCount = buffer.lineIndex(buffer.size()) + 1;
+        firstInvalid = endInvalid = 0;
+    }
+    lastLine = std::min(lastLine, lineCount - 1);
+
+    GapBuffer::Spans spans = buffer.spans();
+    std::size_t i = firstInvalid < endInvalid ? firstInvalid : lines.size();
+    std::size_t offset = 0;
+    bool haveOffset = false;
+    while (i <= lastLine) {
+        if (i < lines.size() && lines[i].valid) {
+            // Up to date; skip to the next line that is not, or past the
+            // tracked lines once no invalid ones are left
+            std::size_t limit = std::min({lines.size(), lastLine + 1, endInvalid});
+            while (i < limit && lines[i].valid) i++;
+            if (i >= endInvalid) i = lines.size();
+            haveOffset = false;
+            continue;
+        }
+        if (!haveOffset) {
+            offset = buffer.lineStart(i);
+            haveOffset = true;
+        }
+
+        std::string_view text = readLine(spans, offset, scratch);
+        LineState start = i == 0 ? 0 : lines[i - 1].endState;
+        if (i == lines.size()) {
+            lines.emplace_back();
+        }
+        Line& line = lines[i];
+        LineState oldEnd = line.endState;
+        line.runs.clear();
+        line.endState = tokenizeLine(language, text, start, line.runs);
+        line.valid = true;
+        // The next line started from the old end state; it is only out of
+        // date if that changed, which is where re-tokenizing stops
+        if (line.endState != oldEnd && i + 1 < lines.size()) {
+            markInvalid(i + 1, i + 2);
+        }
+
+        offset += text.size() + 1;
+        linesTokenized++;
+        i++;
+    }
+    firstInvalid = i;
+}
+
+const std::vector<TokenRun>& SyntaxHighlighter::runsOf(std::size_t line) const {
+    if (line < lines.size() && lines[line].valid) return lines[line].runs;
+    return empty;
+}
+
+std::size_t SyntaxHighlighter::getLinesTokenized() const {
+    return linesTokenized;
+}
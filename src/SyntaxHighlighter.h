@@ -0,0 +1,102 @@
+//
+// SyntaxHighlighter.h - Line tokenizers and incrementally updated token runs
+//
+// Each logical line is tokenized from the state the previous line ended in
+// (e.g. inside a block comment). Those end states are kept per line, so an
+// edit re-tokenizes from the edited line only until the end states agree with
+// the old ones again. Lines are tokenized lazily, up to the last one shown.
+//
+
+#ifndef SYNTAXHIGHLIGHTER_H
+#define SYNTAXHIGHLIGHTER_H
+
+#include "GapBuffer.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class Language {
+    Plain,
+    Log,
+    Cpp,
+    Json,
+};
+
+// From the file extension; unknown extensions are Plain
+Language languageForPath(const std::string& path);
+const char* languageName(Language language);
+
+enum class TokenKind : std::uint8_t {
+    Text,
+    Keyword,
+    Type,
+    String,
+    Number,
+    Comment,
+    Preprocessor,
+    Key,        // JSON object key
+    Timestamp,
+    Error,      // log levels
+    Warning,
+    Info,
+    Debug,
+    Count,
+};
+
+// Bytes [start, start + length) of a line; the text between runs is Text
+struct TokenRun {
+    std::uint32_t start;
+    std::uint32_t length;
+    TokenKind kind;
+};
+
+// Tokenizer state carried from the end of one line to the start of the next
+using LineState = std::uint8_t;
+
+// Appends the runs of one line (without its '\n') to `out` and returns the
+// state the line ends in
+LineState tokenizeLine(Language language, std::string_view line, LineState start, std::vector<TokenRun>& out);
+
+class SyntaxHighlighter {
+public:
+    void setLanguage(Language language);
+    Language getLanguage() const;
+
+    // Forget every line, e.g. after the whole text was replaced
+    void reset();
+    // Called from the buffer's edit observer, after the edit
+    void noteEdit(const GapBuffer& buffer, const GapBuffer::Edit& edit);
+
+    // Tokenizes what is out of date in lines [0, lastLine]
+    void update(const GapBuffer& buffer, std::size_t lastLine);
+    // Runs of a line brought up to date by update(); empty past them
+    const std::vector<TokenRun>& runsOf(std::size_t line) const;
+
+    // Lines tokenized by the last update()
+    std::size_t getLinesTokenized() const;
+
+private:
+    struct Line {
+        std::vector<TokenRun> runs;
+        LineState endState = 0;
+        bool valid = false;
+    };
+
+    Language language = Language::Plain;
+    // Lines [0, lines.size()) have been tokenized at least once; those after
+    // have never been and are not tracked
+    std::vector<Line> lines;
+    std::size_t lineCount = 1;             // lines in the document, kept while any are tokenized
+    // Tracked lines outside [firstInvalid, endInvalid) are up to date; the
+    // range is empty when firstInvalid >= endInvalid
+    std::size_t firstInvalid = 0;
+    std::size_t endInvalid = 0;
+    std::size_t linesTokenized = 0;
+    std::string scratch;                   // a line that straddles the gap
+    std::vector<TokenRun> empty;
+
+    void markInvalid(std::size_t begin, std::size_t end);
+};
+
+#endif //SYNTAXHIGHLIGHTER_H
@@ -0,0 +1,180 @@
+//
+// TextMetrics.cpp - Implementation of word and line counting
+//
+
+#include "TextMetrics.h"
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TEXTMETRICS_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TEXTMETRICS_NEON 1
+#endif
+
+namespace {
+
+inline bool isSpace(unsigned char c) {
+    return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+// Scalar pass continuing after a byte whose "is space" state is afterSpace
+void countScalar(const unsigned char* p, std::size_t len, bool afterSpace, TextCounts& counts) {
+    for (std::size_t i = 0; i < len; i++) {
+        bool space = isSpace(p[i]);
+        counts.newlines += p[i] == '\n';
+        counts.wordStarts += !space && afterSpace;
+        afterSpace = space;
+    }
+}
+
+// Byte lanes count up by one per match and are folded into the totals before
+// they can wrap
+constexpr std::size_t FOLD_BLOCKS = 255;
+
+#if TEXTMETRICS_SSE2
+
+std::size_t sumLanes(__m128i lanes) {
+    __m128i sums = _mm_sad_epu8(lanes, _mm_setzero_si128());
+    return static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) +
+           static_cast<std::size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+}
+
+// Processes whole 16-byte blocks and returns how many bytes it consumed
+std::size_t countBlocks(const unsigned char* p, std::size_t len, TextCounts& counts) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i blank = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i controlRange = _mm_set1_epi8('\r' - '\t');
+
+    std::size_t blocks = len / 16;
+    // Space state of the previous block; the text starts "after a space"
+    __m128i previousSpace = _mm_set1_epi8(-1);
+
+    for (std::size_t done = 0; done < blocks;) {
+        std::size_t batch = blocks - done < FOLD_BLOCKS ? blocks - done : FOLD_BLOCKS;
+        __m128i newlineLanes = _mm_setzero_si128();
+        __m128i startLanes = _mm_setzero_si128();
+
+        for (std::size_t b = 0; b < batch; b++) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + (done + b) * 16));
+            __m128i offset = _mm_sub_epi8(bytes, tab);
+            __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(offset, controlRange), offset);
+            __m128i space = _mm_or_si128(control, _mm_cmpeq_epi8(bytes, blank));
+
+            // Space state of each byte's predecessor
+            __m128i before = _mm_or_si128(_mm_slli_si128(space, 1), _mm_srli_si128(previousSpace, 15));
+            __m128i starts = _mm_andnot_si128(space, before);
+
+            newlineLanes = _mm_sub_epi8(newlineLanes, _mm_cmpeq_epi8(bytes, newline));
+            startLanes = _mm_sub_epi8(startLanes, starts);
+            previousSpace = space;
+        }
+        counts.newlines += sumLanes(newlineLanes);
+        counts.wordStarts += sumLanes(startLanes);
+        done += batch;
+    }
+    return blocks * 16;
+}
+
+#elif TEXTMETRICS_NEON
+
+std::size_t countBlocks(const unsigned char* p, std::size_t len, TextCounts& counts) {
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    const uint8x16_t blank = vdupq_n_u8(' ');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    const uint8x16_t controlRange = vdupq_n_u8('\r' - '\t');
+
+    std::size_t blocks = len / 16;
+    uint8x16_t previousSpace = vdupq_n_u8(0xFF);
+
+    for (std::size_t done = 0; done < blocks;) {
+        std::size_t batch = blocks - done < FOLD_BLOCKS ? blocks - done : FOLD_BLOCKS;
+        uint8x16_t newlineLanes = vdupq_n_u8(0);
+        uint8x16_t startLanes = vdupq_n_u8(0);
+
+        for (std::size_t b = 0; b < batch; b++) {
+            uint8x16_t bytes = vld1q_u8(p + (done + b) * 16);
+            uint8x16_t control = vcleq_u8(vsubq_u8(bytes, tab), controlRange);
+            uint8x16_t space = vorrq_u8(control, vceqq_u8(bytes, blank));
+
+            uint8x16_t before = vextq_u8(previousSpace, space, 15);
+            uint8x16_t starts = vbicq_u8(before, space);
+
+            newlineLanes = vsubq_u8(newlineLanes, vceqq_u8(bytes, newline));
+            startLanes = vsubq_u8(startLanes, starts);
+            previousSpace = space;
+        }
+        counts.newlines += vaddlvq_u8(newlineLanes);
+        counts.wordStarts += vaddlvq_u8(startLanes);
+        done += batch;
+    }
+    return blocks * 16;
+}
+
+#else
+
+std::size_t countBlocks(const unsigned char*, std::size_t, TextCounts&) {
+    return 0;
+}
+
+#endif
+
+} // namespace
+
+TextCounts TextCounts::combine(const TextCounts& left, const TextCounts& right) {
+    if (left.bytes == 0) return right;
+    if (right.bytes == 0) return left;
+
+    TextCounts counts;
+    counts.bytes = left.bytes + right.bytes;
+    counts.newlines = left.newlines + right.newlines;
+    counts.wordStarts = left.wordStarts + right.wordStarts - (left.endsInWord && right.startsInWord);
+    counts.startsInWord = left.startsInWord;
+    counts.endsInWord = right.endsInWord;
+    return counts;
+}
+
+TextCounts countText(std::string_view text) {
+    TextCounts counts;
+    if (text.empty()) return counts;
+
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    counts.bytes = text.size();
+    counts.startsInWord = !isSpace(p[0]);
+    counts.endsInWord = !isSpace(p[text.size() - 1]);
+
+    std::size_t done = countBlocks(p, text.size(), counts);
+    bool afterSpace = done == 0 || isSpace(p[done - 1]);
+    countScalar(p + done, text.size() - done, afterSpace, counts);
+    return counts;
+}
+
+TextCounts countTextScalar(std::string_view text) {
+    TextCounts counts;
+    if (text.empty()) return counts;
+
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    counts.bytes = text.size();
+    counts.startsInWord = !isSpace(p[0]);
+    counts.endsInWord = !isSpace(p[text.size() - 1]);
+    countScalar(p, text.size(), true, counts);
+    return counts;
+}
+
+std::size_t countWords(std::string_view text) {
+    return countText(text).wordStarts;
+}
+
+std::size_t countLines(std::string_view text) {
+    return countText(text).newlines + 1;
+}
+
+std::size_t countWords(std::string_view first, std::string_view second) {
+    return TextCounts::combine(countText(first), countText(second)).wordStarts;
+}
+
+std::size_t countLines(std::string_view first, std::string_view second) {
+    return countText(first).newlines + countText(second).newlines + 1;
+}
@@ -0,0 +1,43 @@
+//
+// TextMetrics.h - Word and line counting over document text
+//
+
+#ifndef TEXTMETRICS_H
+#define TEXTMETRICS_H
+
+#include <cstddef>
+#include <string_view>
+
+// Byte, newline and word counts of a run of text. Words are runs of
+// non-whitespace bytes (' ', \t, \n, \v, \f, \r separate them), so UTF-8
+// sequences always count as word bytes.
+struct TextCounts {
+    std::size_t bytes = 0;
+    std::size_t newlines = 0;
+    std::size_t wordStarts = 0;     // a word at the very start counts too
+    bool startsInWord = false;      // first byte is a word byte
+    bool endsInWord = false;        // last byte is a word byte
+
+    // Counts of left followed directly by right; a word spanning the
+    // boundary is counted once
+    static TextCounts combine(const TextCounts& left, const TextCounts& right);
+};
+
+// All three counts in one pass, 16 bytes at a time with SSE2 or NEON where
+// available
+TextCounts countText(std::string_view text);
+// Byte-at-a-time version of countText, used for tails and as the reference
+TextCounts countTextScalar(std::string_view text);
+
+// Runs of non-whitespace characters
+std::size_t countWords(std::string_view text);
+
+// Number of lines, i.e. newlines + 1
+std::size_t countLines(std::string_view text);
+
+// The same over text held in two runs, e.g. either side of a gap buffer's gap;
+// a word that straddles the runs counts once
+std::size_t countWords(std::string_view first, std::string_view second);
+std::size_t countLines(std::string_view first, std::string_view second);
+
+#endif //TEXTMETRICS_H
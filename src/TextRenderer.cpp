@@ -3,149 +3,108 @@
 #include <limits>
 #include <algorithm>
 
-DisplayState wrapText(const GapBuffer& buffer, sf::Text& textObj, float maxWidth) {
-    std::string raw = buffer.getString();
-    std::string displayString;
-    std::string currentLine;
-    std::string wordBuffer;
-
-    size_t rawCursorIndex = buffer.getGapStart();
-    size_t displayCursorIndex = 0;
-    bool cursorFound = false;
-
-    for (size_t i = 0; i < raw.size(); i++) {
-        char c = raw[i];
-
-        if (i == rawCursorIndex) {
-            displayCursorIndex = displayString.size() + currentLine.size() + wordBuffer.size();
-            cursorFound = true;
-        }
-
-        if (c == '\n') {
-            currentLine += wordBuffer;
-            displayString += currentLine + "\n";
-            currentLine.clear();
-            wordBuffer.clear();
-            continue;
-        }
-
-        wordBuffer += c;
-
-        if (c == ' ' || i == raw.size() - 1) {
-            sf::Text temp = textObj;
-            temp.setString(currentLine + wordBuffer);
-
-            if (temp.getLocalBounds().size.x > maxWidth) {
-                displayString += currentLine + "\n";
-                currentLine.clear();
-            }
-
-            currentLine += wordBuffer;
-            wordBuffer.clear();
-        }
-    }
-
-    if (!cursorFound) {
-        displayCursorIndex = displayString.size() + currentLine.size() + wordBuffer.size();
-    }
+float FontWidthProvider::measure(std::string_view utf8) const {
+    return BatchedText::measure(text.getFont(), text.getCharacterSize(), utf8);
+}
 
-    displayString += currentLine + wordBuffer;
-    return {displayString, displayCursorIndex};
+void wrapText(const GapBuffer& buffer, const BatchedText& textObj, float maxWidth, DisplayState& out,
+              FrameArena& arena) {
+    wrapLayout(buffer.spans(), buffer.getGapStart(), FontWidthProvider(textObj), maxWidth, out, arena);
 }
 
-void moveCursorVertical(GapBuffer& buffer, const sf::Text& text, const sf::Font& font, bool down) {
-    int currentY = text.findCharacterPos(buffer.getGapStart()).y;
-    int currentX = text.findCharacterPos(buffer.getGapStart()).x;
+void moveCursorVertical(GapBuffer& buffer, const DisplayState& state, const BatchedText& text,
+                        const sf::Font& font, bool down) {
+    size_t cursorGlyph = displayGlyphIndex(state, buffer, buffer.getGapStart());
+    int currentY = text.findCharacterPos(cursorGlyph).y;
+    int currentX = text.findCharacterPos(cursorGlyph).x;
     int spacing = font.getLineSpacing(text.getCharacterSize());
     int targetY = down ? currentY + spacing : currentY - spacing;
 
-    int bestIndex = -1;
-    float bestDistance = std::numeric_limits<float>::max();
-
-    for (size_t i = 0; i < text.getString().getSize(); i++) {
-        sf::Vector2f charPos = text.findCharacterPos(i);
-        if (static_cast<int>(charPos.y) == targetY) {
-            float dist = std::abs(charPos.x - static_cast<float>(currentX));
-            if (dist < bestDistance) {
-                bestDistance = dist;
-                bestIndex = i;
-            }
-        }
-    }
+    // Nearest glyph boundary on the neighbouring line
+    int bestIndex = text.findCharacterAt(sf::Vector2f(static_cast<float>(currentX),
+                                                      static_cast<float>(targetY) + 1.f));
 
     if (bestIndex != -1) {
-        buffer.moveTo(bestIndex);
+        buffer.moveTo(rawOffsetOfDisplayGlyph(state, buffer, static_cast<size_t>(bestIndex)));
     }
 }
 
-void drawSelection(sf::RenderWindow& window, const sf::Text& text, const sf::Font& font, 
-                  int selectionAnchor, int gapStart) {
-    if (selectionAnchor != -1 && selectionAnchor != gapStart) {
-        size_t start = std::min((size_t)selectionAnchor, (size_t)gapStart);
-        size_t end   = std::max((size_t)selectionAnchor, (size_t)gapStart);
-
-        for (size_t i = start; i < end; ++i) {
-            sf::Vector2f charPos = text.findCharacterPos(i);
-            sf::Vector2f nextCharPos = text.findCharacterPos(i + 1);
-
-            float width = nextCharPos.x - charPos.x;
-            float height = font.getLineSpacing(text.getCharacterSize());
-
-            if (nextCharPos.y != charPos.y || width <= 0) {
-                width = 10.f; // Fallback width for newlines
-            }
-
-            sf::RectangleShape selectionRect({width, height});
-            selectionRect.setFillColor(sf::Color(100, 100, 255, 128));
-            selectionRect.setPosition(charPos);
-            window.draw(selectionRect);
+void appendSelection(sf::VertexArray& quads, const BatchedText& text, const sf::Font& font,
+                     std::size_t anchorGlyph, std::size_t cursorGlyph) {
+    const sf::Color color(100, 100, 255, 128);
+    float height = font.getLineSpacing(text.getCharacterSize());
+    std::size_t start = std::min(anchorGlyph, cursorGlyph);
+    std::size_t end   = std::max(anchorGlyph, cursorGlyph);
+
+    // Each row is one rectangle from its first selected glyph to its last
+    while (start < end) {
+        std::size_t rowEnd = text.getLineEnd(start);
+        sf::Vector2f left = text.findCharacterPos(start);
+        float right = text.findCharacterPos(std::min(end, rowEnd)).x;
+        if (end > rowEnd) {
+            right += 10.f; // Fallback width for the newline
         }
+
+        sf::Vector2f topRight(right, left.y);
+        sf::Vector2f bottomLeft(left.x, left.y + height);
+        sf::Vector2f bottomRight(right, left.y + height);
+        quads.append({left, color});
+        quads.append({topRight, color});
+        quads.append({bottomLeft, color});
+        quads.append({bottomLeft, color});
+        quads.append({topRight, color});
+        quads.append({bottomRight, color});
+        start = rowEnd + 1;
     }
 }
 
-size_t mapRawToDisplay(const std::string& raw, size_t rawPos, sf::Text& textObj, float maxWidth) {
-    std::string displayString;
-    std::string currentLine;
-    std::string wordBuffer;
-    size_t displayPos = 0;
-    bool posFound = false;
-
-    for (size_t i = 0; i < raw.size(); i++) {
-        if (i == rawPos) {
-            displayPos = displayString.size() + currentLine.size() + wordBuffer.size();
-            posFound = true;
-            break;
-        }
-
-        char c = raw[i];
-
-        if (c == '\n') {
-            currentLine += wordBuffer;
-            displayString += currentLine + "\n";
-            currentLine.clear();
-            wordBuffer.clear();
-            continue;
-        }
-
-        wordBuffer += c;
-
-        if (c == ' ' || i == raw.size() - 1) {
-            sf::Text temp = textObj;
-            temp.setString(currentLine + wordBuffer);
+void drawSelection(sf::RenderWindow& window, const BatchedText& text, const sf::Font& font,
+                  int selectionAnchor, int gapStart, sf::VertexArray& quads) {
+    if (selectionAnchor != -1 && selectionAnchor != gapStart) {
+        quads.setPrimitiveType(sf::PrimitiveType::Triangles);
+        quads.clear();
+        appendSelection(quads, text, font, static_cast<std::size_t>(selectionAnchor),
+                        static_cast<std::size_t>(gapStart));
+        window.draw(quads);
+    }
+}
 
-            if (temp.getLocalBounds().size.x > maxWidth) {
-                displayString += currentLine + "\n";
-                currentLine.clear();
+void applyHighlighting(BatchedText& text, const DisplayState& state, const GapBuffer& buffer,
+                       SyntaxHighlighter& highlighter, const Theme& theme, std::size_t firstLine,
+                       std::size_t lastLine, std::vector<BatchedText::ColorSpan>& spans) {
+    lastLine = std::min(lastLine, state.lineStarts.size());
+    if (firstLine >= lastLine) return;
+
+    size_t lastRaw = lastLine < state.lineStarts.size() ? state.lineStarts[lastLine] : buffer.size();
+    size_t logical = buffer.lineIndex(state.lineStarts[firstLine]);
+    highlighter.update(buffer, buffer.lineIndex(lastRaw));
+
+    // Display lines that start at a soft break continue the same logical line
+    size_t logicalStart = buffer.lineStart(logical);
+    auto softBreak = std::upper_bound(state.softBreaks.begin(), state.softBreaks.end(),
+                                      state.lineStarts[firstLine]);
+    for (size_t d = firstLine; d < lastLine; d++) {
+        size_t rawStart = state.lineStarts[d];
+        if (d > firstLine) {
+            if (softBreak != state.softBreaks.end() && *softBreak == rawStart) {
+                ++softBreak;
+            } else {
+                logical++;
+                logicalStart = rawStart;
             }
-
-            currentLine += wordBuffer;
-            wordBuffer.clear();
         }
+        size_t rawEnd = d + 1 < state.lineStarts.size() ? state.lineStarts[d + 1] : buffer.size();
+
+        // Runs are sorted, so the first one reaching this display line is found by search
+        const std::vector<TokenRun>& runs = highlighter.runsOf(logical);
+        auto run = std::upper_bound(runs.begin(), runs.end(), rawStart - logicalStart,
+                                    [](size_t offset, const TokenRun& r) { return offset < r.start + r.length; });
+        spans.clear();
+        for (; run != runs.end() && logicalStart + run->start < rawEnd; ++run) {
+            size_t begin = std::max(rawStart, logicalStart + run->start);
+            size_t end = std::min(rawEnd, logicalStart + run->start + run->length);
+            spans.push_back({begin - rawStart, end - begin, theme.tokenColor(run->kind)});
+        }
+        text.setLineColors(d, spans);
     }
-
-    if (!posFound) {
-        displayPos = displayString.size() + currentLine.size() + wordBuffer.size();
-    }
-
-    return displayPos;
-}
\ No newline at end of file
+}
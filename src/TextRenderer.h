@@ -1,16 +1,41 @@
 #pragma once
 #include <SFML/Graphics.hpp>
 #include <string>
+#include <vector>
+#include "BatchedText.h"
 #include "GapBuffer.h"
+#include "SyntaxHighlighter.h"
+#include "UI.h"
+#include "WrapLayout.h"
 
-struct DisplayState {
-    std::string content;
-    size_t cursorIndex;
+// Measures with the font and size of a BatchedText
+class FontWidthProvider : public GlyphWidthProvider {
+public:
+    explicit FontWidthProvider(const BatchedText& text) : text(text) {}
+    float measure(std::string_view utf8) const override;
+
+private:
+    const BatchedText& text;
 };
 
-DisplayState wrapText(const GapBuffer& buffer, sf::Text& textObj, float maxWidth);
-void moveCursorVertical(GapBuffer& buffer, const sf::Text& text, const sf::Font& font, bool down);
-void drawSelection(sf::RenderWindow& window, const sf::Text& text, const sf::Font& font, 
-                  int selectionAnchor, int gapStart);
+// Lays out the buffer into `out`, reusing its storage; scratch comes from arena
+void wrapText(const GapBuffer& buffer, const BatchedText& textObj, float maxWidth, DisplayState& out,
+              FrameArena& arena);
+// Moves the cursor to the nearest glyph on the visual line above or below;
+// `state` is the layout `text` shows
+void moveCursorVertical(GapBuffer& buffer, const DisplayState& state, const BatchedText& text,
+                        const sf::Font& font, bool down);
+// Selected glyphs go into `quads` (kept by the caller so its storage is reused)
+// and are drawn in one call
+void drawSelection(sf::RenderWindow& window, const BatchedText& text, const sf::Font& font,
+                  int selectionAnchor, int gapStart, sf::VertexArray& quads);
+// Appends the selection between two glyph indices to `quads`, one rectangle per row
+void appendSelection(sf::VertexArray& quads, const BatchedText& text, const sf::Font& font,
+                     std::size_t anchorGlyph, std::size_t cursorGlyph);
 
-size_t mapRawToDisplay(const std::string& raw, size_t rawPos, sf::Text& textObj, float maxWidth);
+// Brings the highlighter up to date through display lines [firstLine,
+// lastLine) and colours their glyphs from its token runs; `spans` is scratch
+// kept by the caller
+void applyHighlighting(BatchedText& text, const DisplayState& state, const GapBuffer& buffer,
+                       SyntaxHighlighter& highlighter, const Theme& theme, std::size_t firstLine,
+                       std::size_t lastLine, std::vector<BatchedText::ColorSpan>& spans);
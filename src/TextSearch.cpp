@@ -0,0 +1,59 @@
+//
+// TextSearch.cpp - Implementation of case-insensitive search
+//
+
+#include "TextSearch.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace {
+
+char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+char toUpper(char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+// Next position at or after `from` holding either case of `c`
+const char* findFirstChar(const char* from, const char* end, char lower, char upper) {
+    const char* a = static_cast<const char*>(std::memchr(from, lower, end - from));
+    if (lower == upper) return a;
+    // Only scan for the other case up to the first hit of this one
+    const char* limit = a ? a : end;
+    const char* b = static_cast<const char*>(std::memchr(from, upper, limit - from));
+    return b ? b : a;
+}
+
+} // namespace
+
+std::vector<std::size_t> findAllMatches(std::string_view text, std::string_view query) {
+    std::vector<std::size_t> matches;
+    if (query.empty() || query.size() > text.size()) return matches;
+
+    // Fold the query once; the text is compared in place instead of copied
+    std::string folded(query);
+    std::transform(folded.begin(), folded.end(), folded.begin(), toLower);
+    char lower = folded[0];
+    char upper = toUpper(lower);
+
+    const char* begin = text.data();
+    const char* last = begin + (text.size() - query.size()) + 1; // one past the last possible start
+    const char* p = begin;
+    while (p < last) {
+        p = findFirstChar(p, last, lower, upper);
+        if (!p) break;
+
+        std::size_t i = 1;
+        while (i < folded.size() && toLower(p[i]) == folded[i]) {
+            i++;
+        }
+        if (i == folded.size()) {
+            matches.push_back(static_cast<std::size_t>(p - begin));
+        }
+        p++;  // Continue searching from next character
+    }
+    return matches;
+}
@@ -0,0 +1,16 @@
+//
+// TextSearch.h - Case-insensitive substring search over document text
+//
+
+#ifndef TEXTSEARCH_H
+#define TEXTSEARCH_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Byte offsets of every (possibly overlapping) occurrence of `query` in `text`,
+// ignoring ASCII case. Multi-byte UTF-8 sequences must match exactly.
+std::vector<std::size_t> findAllMatches(std::string_view text, std::string_view query);
+
+#endif //TEXTSEARCH_H
@@ -1,4 +1,5 @@
 #include "UI.h"
+#include <algorithm>
 
 Button createButton(const sf::Font& font, const std::string& label, sf::Vector2f pos) {
     Button btn(font);
@@ -121,17 +122,17 @@ void DropdownMenu::close() {
     hoveredIndex = -1;
 }
 
-void DropdownMenu::handleHover(sf::Vector2f mousePos) {
+bool DropdownMenu::handleHover(sf::Vector2f mousePos) {
     if (!open) {
         // Subtle hover tint on the menu button
-        if (menuBtn.getGlobalBounds().contains(mousePos)) {
-            menuBtn.setFillColor(sf::Color(70, 70, 70));
-        } else {
-            menuBtn.setFillColor(sf::Color(50, 50, 50));
-        }
-        return;
+        sf::Color tint = menuBtn.getGlobalBounds().contains(mousePos)
+            ? sf::Color(70, 70, 70) : sf::Color(50, 50, 50);
+        if (menuBtn.getFillColor() == tint) return false;
+        menuBtn.setFillColor(tint);
+        return true;
     }
 
+    int previous = hoveredIndex;
     hoveredIndex = -1;
     float panelY = position.y + BTN_H + 4.f;
     float panelX = position.x;
@@ -145,6 +146,7 @@ void DropdownMenu::handleHover(sf::Vector2f mousePos) {
             break;
         }
     }
+    return hoveredIndex != previous;
 }
 
 int DropdownMenu::handleClick(sf::Vector2f mousePos) {
@@ -204,4 +206,79 @@ void DropdownMenu::draw(sf::RenderWindow& window) const {
             window.draw(rows[i].shortcutText);
         }
     }
-}
\ No newline at end of file
+}
+TabBar::TabBar(const sf::Font& font) : font(font) {}
+
+void TabBar::setArea(sf::Vector2f pos, float areaWidth) {
+    if (pos == position && areaWidth == width) return;
+    position = pos;
+    width = areaWidth;
+    layout();
+}
+
+void TabBar::setTabs(const std::vector<std::string>& newLabels, std::size_t newActive) {
+    if (newLabels == labels && newActive == active) return;
+    labels = newLabels;
+    active = newActive;
+    layout();
+}
+
+void TabBar::layout() {
+    tabs.clear();
+    if (labels.empty()) return;
+
+    float count = static_cast<float>(labels.size());
+    float tabW = std::min(MAX_TAB_W, (width - GAP * (count - 1.f)) / count);
+    if (tabW <= 2.f * PADDING_X) return;
+
+    for (size_t i = 0; i < labels.size(); ++i) {
+        Tab tab(font);
+        bool isActive = i == active;
+        sf::Vector2f tabPos(position.x + static_cast<float>(i) * (tabW + GAP), position.y);
+
+        tab.shape.setSize(sf::Vector2f(tabW, TAB_H));
+        tab.shape.setPosition(tabPos);
+        tab.shape.setFillColor(isActive ? theme.rowHighlight() : theme.btnNormal());
+
+        // Long names lose characters from the end until they fit
+        tab.label.setCharacterSize(14);
+        tab.label.setFillColor(isActive ? theme.textColor() : theme.dimText());
+        sf::String label = sf::String::fromUtf8(labels[i].begin(), labels[i].end());
+        tab.label.setString(label);
+        while (label.getSize() > 1 &&
+               tab.label.getLocalBounds().size.x > tabW - 2.f * PADDING_X) {
+            label.erase(label.getSize() - 1);
+            tab.label.setString(label + "...");
+        }
+
+        sf::FloatRect tb = tab.label.getLocalBounds();
+        tab.label.setPosition(sf::Vector2f(tabPos.x + PADDING_X - tb.position.x,
+                                           tabPos.y + (TAB_H - tb.size.y) / 2.f - tb.position.y));
+        tabs.push_back(std::move(tab));
+    }
+}
+
+int TabBar::handleClick(sf::Vector2f mousePos) const {
+    for (size_t i = 0; i < tabs.size(); ++i) {
+        if (tabs[i].shape.getGlobalBounds().contains(mousePos)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool TabBar::containsPoint(sf::Vector2f mousePos) const {
+    return handleClick(mousePos) != -1;
+}
+
+void TabBar::applyTheme(const Theme& newTheme) {
+    theme = newTheme;
+    layout();
+}
+
+void TabBar::draw(sf::RenderWindow& window) const {
+    for (const Tab& tab : tabs) {
+        window.draw(tab.shape);
+        window.draw(tab.label);
+    }
+}
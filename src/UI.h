@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include "SyntaxHighlighter.h"
 
 struct Theme {
     bool isDark = true;
@@ -29,6 +30,25 @@ struct Theme {
     // Scrollbar
     sf::Color scrollbarTrack() const { return isDark ? sf::Color(30,30,30)  : sf::Color(210,210,210); }
     sf::Color scrollbarThumb() const { return isDark ? sf::Color(80,80,80)  : sf::Color(140,140,140); }
+
+    // Syntax highlighting
+    sf::Color tokenColor(TokenKind kind) const {
+        switch (kind) {
+            case TokenKind::Keyword:      return isDark ? sf::Color(86,156,214)  : sf::Color(0,0,255);
+            case TokenKind::Type:         return isDark ? sf::Color(78,201,176)  : sf::Color(38,127,153);
+            case TokenKind::String:       return isDark ? sf::Color(206,145,120) : sf::Color(163,21,21);
+            case TokenKind::Number:       return isDark ? sf::Color(181,206,168) : sf::Color(9,134,88);
+            case TokenKind::Comment:      return isDark ? sf::Color(106,153,85)  : sf::Color(0,128,0);
+            case TokenKind::Preprocessor: return isDark ? sf::Color(197,134,192) : sf::Color(175,0,219);
+            case TokenKind::Key:          return isDark ? sf::Color(156,220,254) : sf::Color(4,81,165);
+            case TokenKind::Timestamp:    return isDark ? sf::Color(150,150,220) : sf::Color(90,90,160);
+            case TokenKind::Error:        return isDark ? sf::Color(244,71,71)   : sf::Color(205,49,49);
+            case TokenKind::Warning:      return isDark ? sf::Color(220,180,60)  : sf::Color(175,120,0);
+            case TokenKind::Info:         return isDark ? sf::Color(110,200,110) : sf::Color(0,128,0);
+            case TokenKind::Debug:        return dimText();
+            default:                      return textColor();
+        }
+    }
 };
 
 struct Button {
@@ -55,8 +75,8 @@ public:
     // Returns index of item clicked (-1 if none), and toggles open/close
     int handleClick(sf::Vector2f mousePos);
 
-    // Call every frame with current mouse position to update hover state
-    void handleHover(sf::Vector2f mousePos);
+    // Update hover state from the mouse position; true if anything changed
+    bool handleHover(sf::Vector2f mousePos);
 
     // Close the dropdown (e.g. when clicking elsewhere)
     void close();
@@ -70,7 +90,8 @@ public:
     void draw(sf::RenderWindow& window) const;
 
 private:
-    sf::Font font;
+    // Shared with the rest of the UI, so rows draw from the same glyph atlas
+    const sf::Font& font;
 
     // The clickable "File" button in the header bar
     sf::RectangleShape menuBtn;
@@ -104,5 +125,46 @@ private:
     void buildRows();
 };
 
+// One tab per open document, laid out left to right in a strip of the header
+class TabBar {
+public:
+    explicit TabBar(const sf::Font& font);
+
+    void setArea(sf::Vector2f pos, float width);
+    // Labels are rebuilt only when they or the active tab changed
+    void setTabs(const std::vector<std::string>& labels, std::size_t active);
+
+    // Index of the tab under mousePos, or -1
+    int handleClick(sf::Vector2f mousePos) const;
+    bool containsPoint(sf::Vector2f mousePos) const;
+
+    void applyTheme(const Theme& theme);
+    void draw(sf::RenderWindow& window) const;
+
+private:
+    const sf::Font& font;
+
+    struct Tab {
+        sf::RectangleShape shape;
+        sf::Text label;
+        Tab(const sf::Font& font) : label(font) {}
+    };
+
+    std::vector<Tab> tabs;
+    std::vector<std::string> labels;
+    std::size_t active = 0;
+    Theme theme;
+
+    sf::Vector2f position;
+    float width = 0.f;
+
+    static constexpr float TAB_H     = 30.f;
+    static constexpr float MAX_TAB_W = 160.f;
+    static constexpr float GAP       = 4.f;
+    static constexpr float PADDING_X = 8.f;
+
+    void layout();
+};
+
 Button createButton(const sf::Font& font, const std::string& label, sf::Vector2f pos);
 void updateCursorSize(sf::RectangleShape& cursor, const sf::Font& font, unsigned int charSize);
\ No newline at end of file
@@ -0,0 +1,176 @@
+//
+// Utf8.cpp - Implementation of UTF-8 helpers
+//
+
+#include "Utf8.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UTF8_USE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define UTF8_USE_NEON 1
+#endif
+
+namespace utf8 {
+
+std::size_t sequenceLength(unsigned char lead) {
+    if (lead < 0x80) return 1;
+    if ((lead & 0xE0) == 0xC0) return 2;
+    if ((lead & 0xF0) == 0xE0) return 3;
+    if ((lead & 0xF8) == 0xF0) return 4;
+    return 1;
+}
+
+char32_t decode(const char* data, std::size_t len, std::size_t& consumed) {
+    consumed = 1;
+    if (len == 0) return REPLACEMENT;
+
+    auto lead = static_cast<unsigned char>(data[0]);
+    std::size_t need = sequenceLength(lead);
+    if (need == 1) {
+        return lead < 0x80 ? static_cast<char32_t>(lead) : REPLACEMENT;
+    }
+    if (need > len) return REPLACEMENT;
+
+    char32_t cp = lead & (0x7F >> need);
+    for (std::size_t i = 1; i < need; i++) {
+        auto byte = static_cast<unsigned char>(data[i]);
+        if (!isContinuation(byte)) return REPLACEMENT;
+        cp = (cp << 6) | (byte & 0x3F);
+    }
+
+    // Reject overlong forms, surrogates and out-of-range values
+    static const char32_t minValue[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (cp < minValue[need] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return REPLACEMENT;
+    }
+
+    consumed = need;
+    return cp;
+}
+
+void append(std::string& out, char32_t cp) {
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        cp = REPLACEMENT;
+    }
+
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+std::string encode(char32_t cp) {
+    std::string out;
+    append(out, cp);
+    return out;
+}
+
+std::size_t findInvalid(const char* data, std::size_t len) {
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+    std::size_t i = 0;
+    while (i < len) {
+        if (i + 8 <= len) {
+            std::uint64_t word;
+            std::memcpy(&word, p + i, sizeof(word));
+            if ((word & 0x8080808080808080ull) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+
+        unsigned char lead = p[i];
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
+        std::size_t need = sequenceLength(lead);
+        if (need == 1 || i + need > len) return i;
+
+        char32_t cp = lead & (0x7F >> need);
+        for (std::size_t k = 1; k < need; k++) {
+            if (!isContinuation(p[i + k])) return i;
+            cp = (cp << 6) | (p[i + k] & 0x3F);
+        }
+        static const char32_t smallest[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (cp < smallest[need] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return i;
+        i += need;
+    }
+    return len;
+}
+
+std::size_t countCodePoints(const char* data, std::size_t len) {
+    std::size_t count = 0;
+    std::size_t i = 0;
+
+#if defined(UTF8_USE_SSE2)
+    // A byte starts a code point when, read as signed, it is greater than
+    // -65 (0xBF). Per-lane counters are flushed before they can overflow.
+    const __m128i threshold = _mm_set1_epi8(-65);
+    while (i + 16 <= len) {
+        __m128i acc = _mm_setzero_si128();
+        std::size_t blocks = std::min<std::size_t>((len - i) / 16, 255);
+        for (std::size_t b = 0; b < blocks; b++, i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(v, threshold));
+        }
+        __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+        count += static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) +
+                 static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+    }
+#elif defined(UTF8_USE_NEON)
+    const int8x16_t threshold = vdupq_n_s8(-65);
+    while (i + 16 <= len) {
+        uint8x16_t acc = vdupq_n_u8(0);
+        std::size_t blocks = std::min<std::size_t>((len - i) / 16, 255);
+        for (std::size_t b = 0; b < blocks; b++, i += 16) {
+            int8x16_t v = vld1q_s8(reinterpret_cast<const int8_t*>(data + i));
+            acc = vsubq_u8(acc, vcgtq_s8(v, threshold));
+        }
+        count += vaddlvq_u8(acc);
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (!isContinuation(static_cast<unsigned char>(data[i]))) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool isGraphemeExtend(char32_t cp) {
+    return (cp >= 0x0300 && cp <= 0x036F) ||   // Combining Diacritical Marks
+           (cp >= 0x0483 && cp <= 0x0489) ||   // Cyrillic combining marks
+           (cp >= 0x0591 && cp <= 0x05BD) ||   // Hebrew points
+           (cp >= 0x064B && cp <= 0x065F) ||   // Arabic harakat
+           (cp >= 0x0900 && cp <= 0x0903) ||   // Devanagari signs
+           (cp >= 0x093A && cp <= 0x094F) ||
+           (cp >= 0x1AB0 && cp <= 0x1AFF) ||   // Combining Diacritical Marks Extended
+           (cp >= 0x1DC0 && cp <= 0x1DFF) ||   // Combining Diacritical Marks Supplement
+           (cp >= 0x20D0 && cp <= 0x20FF) ||   // Combining Marks for Symbols
+           (cp >= 0x3099 && cp <= 0x309A) ||   // Kana voicing marks
+           (cp >= 0xFE00 && cp <= 0xFE0F) ||   // Variation Selectors
+           (cp >= 0xFE20 && cp <= 0xFE2F) ||   // Combining Half Marks
+           (cp >= 0x1F3FB && cp <= 0x1F3FF) || // Emoji skin tone modifiers
+           (cp >= 0xE0020 && cp <= 0xE007F) || // Tag characters (flag sequences)
+           (cp >= 0xE0100 && cp <= 0xE01EF) || // Variation Selectors Supplement
+           cp == ZERO_WIDTH_JOINER;
+}
+
+} // namespace utf8
@@ -0,0 +1,51 @@
+//
+// Utf8.h - UTF-8 decoding/encoding helpers and vectorised code point counting
+//
+
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <string>
+
+namespace utf8 {
+
+constexpr char32_t REPLACEMENT = 0xFFFD;
+
+// Continuation bytes look like 10xxxxxx; every other byte starts a code point
+inline bool isContinuation(unsigned char byte) {
+    return (byte & 0xC0) == 0x80;
+}
+
+// Number of bytes in the sequence introduced by `lead` (1 for invalid leads)
+std::size_t sequenceLength(unsigned char lead);
+
+// Decode the code point starting at data[0]. `consumed` receives the number of
+// bytes read; malformed input decodes to REPLACEMENT and consumes one byte.
+char32_t decode(const char* data, std::size_t len, std::size_t& consumed);
+
+// Append the UTF-8 encoding of `cp` to `out`
+void append(std::string& out, char32_t cp);
+std::string encode(char32_t cp);
+
+// Number of code points in [data, data + len). Uses SSE2/NEON when available.
+std::size_t countCodePoints(const char* data, std::size_t len);
+inline std::size_t countCodePoints(const std::string& str) {
+    return countCodePoints(str.data(), str.size());
+}
+
+// Offset of the first byte of [data, data + len) that does not start a
+// well-formed sequence (truncated, overlong, surrogate or past U+10FFFF), or
+// len if the text is valid. ASCII runs are checked eight bytes at a time.
+std::size_t findInvalid(const char* data, std::size_t len);
+
+// True for code points that attach to the preceding grapheme cluster:
+// combining marks, variation selectors, emoji modifiers and ZWJ.
+// This is a pragmatic subset of UAX #29, enough for cursor movement.
+bool isGraphemeExtend(char32_t cp);
+
+constexpr char32_t ZERO_WIDTH_JOINER = 0x200D;
+
+} // namespace utf8
+
+#endif //UTF8_H
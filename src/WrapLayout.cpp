@@ -0,0 +1,131 @@
+//
+// WrapLayout.cpp - Word wrapping independent of any rendering backend
+//
+
+#include "WrapLayout.h"
+#include "Utf8.h"
+#include <algorithm>
+
+float MonospaceWidthProvider::measure(std::string_view utf8) const {
+    float cells = 0.f;
+    for (std::size_t i = 0; i < utf8.size();) {
+        std::size_t consumed;
+        char32_t cp = utf8::decode(utf8.data() + i, utf8.size() - i, consumed);
+        i += consumed;
+        cells += cp == U'\t' ? 4.f : 1.f;
+    }
+    return cells * cellWidth;
+}
+
+void wrapLayout(const GapBuffer::Spans& text, size_t rawCursor, const GlyphWidthProvider& widths,
+                float maxWidth, DisplayState& out, FrameArena& arena) {
+    std::string& displayString = out.content;
+    displayString.clear();
+    out.softBreaks.clear();
+    out.lineStarts.assign(1, 0);
+
+    // Finished lines go straight into displayString; only the word being
+    // scanned is held back until it is known whether it fits
+    ArenaString wordBuffer{ArenaAllocator<char>(arena)};
+    wordBuffer.reserve(64);
+
+    const size_t total = text.before.size() + text.after.size();
+    size_t displayCursorIndex = 0;
+    bool cursorFound = false;
+    float currentWidth = 0.f; // width of the current visual line
+
+    displayString.reserve(total + total / 32);
+
+    // Puts the word ending before raw offset `end` on the current visual line,
+    // or on a new one if it doesn't fit
+    auto placeWord = [&](size_t end) {
+        if (wordBuffer.empty()) return;
+        // Only the new word is measured; the line width is carried along
+        float wordWidth = widths.measure(std::string_view(wordBuffer.data(), wordBuffer.size()));
+
+        if (currentWidth + wordWidth > maxWidth) {
+            // A cursor inside the word moves down with it
+            if (cursorFound && displayCursorIndex > displayString.size()) {
+                displayCursorIndex++;
+            }
+            displayString += '\n';
+            currentWidth = 0.f;
+            out.softBreaks.push_back(end - wordBuffer.size());
+            out.lineStarts.push_back(out.softBreaks.back());
+        }
+
+        displayString.append(wordBuffer.data(), wordBuffer.size());
+        currentWidth += wordWidth;
+        wordBuffer.clear();
+    };
+
+    const std::string_view runs[2] = {text.before, text.after};
+    for (size_t r = 0, base = 0; r < 2; base += runs[r].size(), r++) {
+        std::string_view run = runs[r];
+        for (size_t j = 0; j < run.size(); j++) {
+            const size_t i = base + j;
+            const char c = run[j];
+
+            if (i == rawCursor) {
+                displayCursorIndex = displayString.size() + wordBuffer.size();
+                cursorFound = true;
+            }
+
+            if (c == '\n') {
+                placeWord(i);
+                displayString += '\n';
+                currentWidth = 0.f;
+                out.lineStarts.push_back(i + 1);
+                continue;
+            }
+
+            wordBuffer += c;
+
+            if (c == ' ' || i == total - 1) {
+                placeWord(i + 1);
+            }
+        }
+    }
+
+    if (!cursorFound) {
+        displayCursorIndex = displayString.size() + wordBuffer.size();
+    }
+
+    displayString.append(wordBuffer.data(), wordBuffer.size());
+    // Text positions are indexed by code point, not byte
+    out.cursorIndex = utf8::countCodePoints(displayString.data(), displayCursorIndex);
+}
+
+DisplayState wrapLayout(std::string_view raw, size_t rawCursor, const GlyphWidthProvider& widths, float maxWidth) {
+    FrameArena arena(4096);
+    DisplayState state;
+    wrapLayout(GapBuffer::Spans{raw, std::string_view()}, rawCursor, widths, maxWidth, state, arena);
+    return state;
+}
+
+size_t displayGlyphIndex(const DisplayState& state, const GapBuffer& buffer, size_t rawOffset) {
+    // Each soft break before the offset adds one '\n' glyph; a break exactly at
+    // the offset is placed after it, matching wrapLayout
+    size_t breaks = std::lower_bound(state.softBreaks.begin(), state.softBreaks.end(), rawOffset) -
+                    state.softBreaks.begin();
+    return buffer.codePointIndex(rawOffset) + breaks;
+}
+
+size_t rawOffsetOfDisplayGlyph(const DisplayState& state, const GapBuffer& buffer, size_t glyph) {
+    // The j-th soft break's '\n' glyph sits at codePointIndex(break) + j, which
+    // grows with j, so the breaks before the glyph are found by bisection
+    size_t low = 0;
+    size_t high = state.softBreaks.size();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (buffer.codePointIndex(state.softBreaks[mid]) + mid < glyph) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < state.softBreaks.size() && buffer.codePointIndex(state.softBreaks[low]) + low == glyph) {
+        return state.softBreaks[low];
+    }
+    return buffer.byteOffsetOfCodePoint(std::min(glyph - low, buffer.codePointCount()));
+}
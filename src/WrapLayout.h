@@ -0,0 +1,57 @@
+//
+// WrapLayout.h - Word wrapping independent of any rendering backend
+//
+
+#ifndef WRAPLAYOUT_H
+#define WRAPLAYOUT_H
+
+#include "FrameArena.h"
+#include "GapBuffer.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Supplies text widths to the wrapper; the GUI measures with its font, headless
+// callers can use MonospaceWidthProvider
+class GlyphWidthProvider {
+public:
+    virtual ~GlyphWidthProvider() = default;
+    // Advance width of a run of UTF-8 text that contains no newlines
+    virtual float measure(std::string_view utf8) const = 0;
+};
+
+// Every code point is one cell wide, tabs are four
+class MonospaceWidthProvider : public GlyphWidthProvider {
+public:
+    explicit MonospaceWidthProvider(float cellWidth = 1.f) : cellWidth(cellWidth) {}
+    float measure(std::string_view utf8) const override;
+
+private:
+    float cellWidth;
+};
+
+struct DisplayState {
+    std::string content;    // UTF-8
+    size_t cursorIndex;     // glyph (code point) index into content
+    std::vector<size_t> softBreaks; // raw byte offsets of words moved to a new line by wrapping
+    std::vector<size_t> lineStarts; // raw byte offset where each visual line begins
+};
+
+// Wraps the text at spaces so no visual line is wider than maxWidth (a single
+// word longer than that keeps its own line). rawCursor is a byte offset.
+// The text is read in place from the two runs of a gap buffer, and `out` keeps
+// its capacity from the previous layout; the per-word scratch comes from the
+// arena, so re-wrapping makes no heap allocations once sizes settle.
+void wrapLayout(const GapBuffer::Spans& text, size_t rawCursor, const GlyphWidthProvider& widths,
+                float maxWidth, DisplayState& out, FrameArena& arena);
+// Same for one contiguous string
+DisplayState wrapLayout(std::string_view raw, size_t rawCursor, const GlyphWidthProvider& widths, float maxWidth);
+
+// Glyph index in an existing layout for a raw byte offset, without re-wrapping
+size_t displayGlyphIndex(const DisplayState& state, const GapBuffer& buffer, size_t rawOffset);
+// The inverse: raw byte offset of a glyph index in the layout. The '\n' glyph
+// of a soft break maps to the break's offset.
+size_t rawOffsetOfDisplayGlyph(const DisplayState& state, const GapBuffer& buffer, size_t glyph);
+
+#endif //WRAPLAYOUT_H
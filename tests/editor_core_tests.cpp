@@ -0,0 +1,803 @@
+//
+// editor_core_tests.cpp - Round-trip checks for the editor core
+//
+// Each check compares the core against a plain std::string model of the same
+// text, over randomized inputs with a fixed seed. Exits non-zero if any check
+// fails.
+//
+//   editor_core_tests [--filter=name]
+//
+
+#include "AsyncFileSaver.h"
+#include "ColumnSelection.h"
+#include "EditJournal.h"
+#include "GapBuffer.h"
+#include "MultiCursor.h"
+#include "SyntaxHighlighter.h"
+#include "TextMetrics.h"
+#include "Utf8.h"
+#include "WrapLayout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace {
+
+int failures = 0;
+
+// Reports the failed condition and leaves the test function
+#define CHECK(condition)                                                               \
+    do {                                                                               \
+        if (!(condition)) {                                                            \
+            std::fprintf(stderr, "%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                \
+            return;                                                                    \
+        }                                                                              \
+    } while (0)
+
+// Mostly ASCII words and newlines, with some multi-byte code points so chunk
+// boundaries land inside sequences
+std::string randomText(std::mt19937& rng, std::size_t bytes) {
+    static const char* const pieces[] = {"lorem", "ipsum", " ", " ", "\n", "\t", "é", "日本", "😀", "x"};
+    std::string text;
+    while (text.size() < bytes) {
+        text += pieces[rng() % (sizeof(pieces) / sizeof(pieces[0]))];
+    }
+    return text;
+}
+
+// --- UTF-8 -------------------------------------------------------------------
+
+// Every scalar value (sampled above U+3000) encodes, decodes and is counted
+// back, alone and concatenated; malformed bytes decode one at a time
+void testUtf8() {
+    std::string all;
+    std::size_t count = 0;
+    for (char32_t cp = 0; cp <= 0x10FFFF; cp += (cp < 0x3000 ? 1 : 97)) {
+        if (cp >= 0xD800 && cp <= 0xDFFF) continue;
+        std::string encoded = utf8::encode(cp);
+        CHECK(encoded.size() == utf8::sequenceLength(static_cast<unsigned char>(encoded[0])));
+        std::size_t consumed = 0;
+        CHECK(utf8::decode(encoded.data(), encoded.size(), consumed) == cp);
+        CHECK(consumed == encoded.size());
+        all += encoded;
+        count++;
+    }
+    CHECK(utf8::countCodePoints(all) == count);
+    CHECK(utf8::findInvalid(all.data(), all.size()) == all.size());
+
+    std::size_t pos = 0;
+    std::size_t decoded = 0;
+    while (pos < all.size()) {
+        std::size_t consumed = 0;
+        utf8::decode(all.data() + pos, all.size() - pos, consumed);
+        pos += consumed;
+        decoded++;
+    }
+    CHECK(decoded == count);
+
+    // A lone continuation byte, an overlong '/', a surrogate and a truncated
+    // sequence at the end
+    const char* const invalid[] = {"ab\x80", "ab\xC0\xAF", "ab\xED\xA0\x80", "ab\xE6\x97"};
+    for (const char* text : invalid) {
+        std::size_t len = std::strlen(text);
+        CHECK(utf8::findInvalid(text, len) == 2);
+        std::size_t consumed = 0;
+        CHECK(utf8::decode(text + 2, len - 2, consumed) == utf8::REPLACEMENT);
+        CHECK(consumed == 1);
+    }
+}
+
+// Byte offsets and code point indices convert both ways wherever the gap is
+void testCodePointIndex() {
+    std::mt19937 rng(5);
+    GapBuffer buffer;
+    std::string model = randomText(rng, 3 * ChunkIndex::CHUNK_SIZE + 77);
+    buffer.insertString(model);
+
+    std::vector<std::size_t> starts;   // byte offset of each code point
+    for (std::size_t i = 0; i < model.size(); i++) {
+        if (!utf8::isContinuation(static_cast<unsigned char>(model[i]))) starts.push_back(i);
+    }
+    CHECK(buffer.codePointCount() == starts.size());
+
+    for (int round = 0; round < 500; round++) {
+        buffer.moveTo(starts[rng() % starts.size()]);
+        std::size_t index = rng() % starts.size();
+        CHECK(buffer.byteOffsetOfCodePoint(index) == starts[index]);
+        CHECK(buffer.codePointIndex(starts[index]) == index);
+    }
+    CHECK(buffer.getString() == model);
+}
+
+// --- GapBuffer::append -------------------------------------------------------
+
+// Appending never moves the gap, wherever the cursor is; a cursor at the end
+// moves past the new text
+void testAppend() {
+    std::mt19937 rng(3);
+    GapBuffer buffer;
+    std::string model;
+    for (int round = 0; round < 200; round++) {
+        std::string chunk = randomText(rng, rng() % 3000);
+        std::size_t cursor = rng() % (model.size() + 1);
+        buffer.moveTo(cursor);
+        buffer.append(chunk);
+        model += chunk;
+        CHECK(buffer.getString() == model);
+        CHECK(buffer.getGapStart() == (cursor == model.size() - chunk.size() ? model.size() : cursor));
+        CHECK(buffer.codePointCount() == utf8::countCodePoints(model));
+    }
+}
+
+// --- ChunkIndex --------------------------------------------------------------
+
+// Range statistics from the index match a direct count of the same bytes,
+// wherever the gap is and after edits leave chunks dirty
+void testChunkIndexRanges() {
+    std::mt19937 rng(1);
+    GapBuffer buffer;
+    std::string model = randomText(rng, 5 * ChunkIndex::CHUNK_SIZE + 123);
+    buffer.insertString(model);
+
+    for (int round = 0; round < 200; round++) {
+        if (round % 4 == 0) {
+            std::size_t at = rng() % (model.size() + 1);
+            std::string text = randomText(rng, rng() % 300);
+            buffer.moveTo(at);
+            buffer.insertString(text);
+            model.insert(at, text);
+        } else if (round % 4 == 1) {
+            std::size_t start = rng() % (model.size() + 1);
+            std::size_t end = std::min(model.size(), start + rng() % 5000);
+            buffer.deleteRange(start, end);
+            model.erase(start, end - start);
+        } else {
+            buffer.moveTo(rng() % (model.size() + 1));
+        }
+        CHECK(buffer.getString() == model);
+
+        std::size_t start = rng() % (model.size() + 1);
+        std::size_t end = start + rng() % (model.size() - start + 1);
+        std::string_view bytes(model.data() + start, end - start);
+        ChunkSummary stats = buffer.statistics(start, end);
+        TextCounts expected = countTextScalar(bytes);
+        CHECK(stats.bytes == expected.bytes);
+        CHECK(stats.newlines == expected.newlines);
+        CHECK(stats.wordStarts == expected.wordStarts);
+        CHECK(stats.codePoints == utf8::countCodePoints(bytes.data(), bytes.size()));
+
+        std::size_t line = buffer.lineIndex(start);
+        std::size_t lineBegin = start == 0 ? std::string::npos : model.rfind('\n', start - 1);
+        lineBegin = lineBegin == std::string::npos ? 0 : lineBegin + 1;
+        CHECK(line == countTextScalar(std::string_view(model.data(), start)).newlines);
+        CHECK(buffer.lineStart(line) == lineBegin);
+    }
+}
+
+// --- GapBuffer::applyEdits ---------------------------------------------------
+
+// A batch of sorted, non-overlapping edits leaves the same text as applying
+// them one by one, and the observer's edits replay to that text too
+void testApplyEdits() {
+    std::mt19937 rng(2);
+    for (int round = 0; round < 300; round++) {
+        std::string original = randomText(rng, rng() % 2000);
+        GapBuffer buffer;
+        buffer.insertString(original);
+        buffer.moveTo(rng() % (original.size() + 1));
+
+        std::vector<std::string> texts;
+        std::vector<std::size_t> offsets;
+        std::vector<std::size_t> removed;
+        std::size_t pos = 0;
+        while (pos < original.size() && texts.size() < 20) {
+            pos += rng() % 200;
+            if (pos > original.size()) break;
+            offsets.push_back(pos);
+            removed.push_back(std::min<std::size_t>(rng() % 4, original.size() - pos));
+            texts.push_back(std::string(rng() % 3, 'a' + static_cast<char>(rng() % 26)));
+            pos += removed.back();
+        }
+        std::vector<GapBuffer::Edit> edits;
+        for (std::size_t i = 0; i < texts.size(); i++) {
+            edits.push_back({offsets[i], removed[i], texts[i]});
+        }
+
+        std::string expected = original;
+        for (std::size_t i = edits.size(); i-- > 0;) {
+            expected.replace(offsets[i], removed[i], texts[i]);
+        }
+
+        std::string observed = original;
+        buffer.setEditObserver([&](const GapBuffer::Edit& edit) {
+            observed.replace(edit.offset, edit.removed, std::string(edit.inserted));
+        });
+        buffer.applyEdits(edits);
+        CHECK(buffer.getString() == expected);
+        CHECK(observed == expected);
+        CHECK(buffer.statistics(0, buffer.size()).newlines == countTextScalar(expected).newlines);
+    }
+}
+
+// --- TextMetrics -------------------------------------------------------------
+
+bool sameCounts(const TextCounts& a, const TextCounts& b) {
+    return a.bytes == b.bytes && a.newlines == b.newlines && a.wordStarts == b.wordStarts &&
+           a.startsInWord == b.startsInWord && a.endsInWord == b.endsInWord;
+}
+
+// The vectorized counts match the scalar reference on runs with unaligned
+// starts and ends, and the counts of two halves combine to the whole's
+void testCountTextParity() {
+    std::mt19937 rng(7);
+    std::string text = randomText(rng, 1 << 16);
+    for (int round = 0; round < 2000; round++) {
+        std::size_t start = rng() % 64;
+        std::size_t len = round % 50 == 0 ? text.size() - start : rng() % 300;
+        std::string_view run(text.data() + start, len);
+        CHECK(sameCounts(countText(run), countTextScalar(run)));
+
+        std::size_t split = rng() % (len + 1);
+        TextCounts halves = TextCounts::combine(countText(run.substr(0, split)), countText(run.substr(split)));
+        CHECK(sameCounts(halves, countTextScalar(run)));
+    }
+}
+
+// --- WrapLayout --------------------------------------------------------------
+
+// One cell per code point: the display text is the raw text with a '\n' at
+// each soft break, a visual line only overflows when it holds a single word,
+// and the cursor glyph agrees with displayGlyphIndex
+void testWrapLayout() {
+    std::mt19937 rng(6);
+    MonospaceWidthProvider widths;
+    for (int round = 0; round < 500; round++) {
+        std::string raw = randomText(rng, rng() % 600);
+        std::size_t cursor = rng() % (raw.size() + 1);
+        float maxWidth = static_cast<float>(4 + rng() % 60);
+        DisplayState state = wrapLayout(raw, cursor, widths, maxWidth);
+
+        std::string expected = raw;
+        for (std::size_t i = state.softBreaks.size(); i-- > 0;) {
+            expected.insert(state.softBreaks[i], 1, '\n');
+        }
+        CHECK(state.content == expected);
+
+        for (std::size_t line = 0; line < state.lineStarts.size(); line++) {
+            std::size_t begin = state.lineStarts[line];
+            std::size_t end = line + 1 < state.lineStarts.size() ? state.lineStarts[line + 1] : raw.size();
+            std::string_view text(raw.data() + begin, end - begin);
+            if (!text.empty() && text.back() == '\n') text.remove_suffix(1);
+            if (widths.measure(text) > maxWidth) {
+                std::string_view word = text.substr(0, text.find_last_not_of(' ') + 1);
+                CHECK(word.find(' ') == std::string_view::npos);
+            }
+        }
+
+        GapBuffer buffer;
+        buffer.insertString(raw);
+        CHECK(state.cursorIndex == displayGlyphIndex(state, buffer, cursor));
+    }
+}
+
+// Raw offsets map to glyph indices in a wrapped layout and back; every glyph
+// maps to the code point it shows, and a soft break's '\n' to the break
+void testDisplayGlyphOffsets() {
+    std::mt19937 rng(10);
+    MonospaceWidthProvider widths;
+    for (int round = 0; round < 300; round++) {
+        std::string raw = randomText(rng, rng() % 400);
+        DisplayState state = wrapLayout(raw, 0, widths, static_cast<float>(4 + rng() % 30));
+        GapBuffer buffer;
+        buffer.insertString(raw);
+        buffer.moveTo(rng() % (raw.size() + 1));
+
+        std::size_t glyph = 0;
+        std::size_t breaks = 0;
+        for (std::size_t pos = 0; pos < state.content.size(); glyph++) {
+            std::size_t consumed = 0;
+            utf8::decode(state.content.data() + pos, state.content.size() - pos, consumed);
+            std::size_t offset = rawOffsetOfDisplayGlyph(state, buffer, glyph);
+            if (breaks < state.softBreaks.size() && pos == state.softBreaks[breaks] + breaks) {
+                CHECK(offset == state.softBreaks[breaks]);
+                breaks++;
+            } else {
+                CHECK(raw.compare(offset, consumed, state.content, pos, consumed) == 0);
+            }
+            pos += consumed;
+        }
+        CHECK(rawOffsetOfDisplayGlyph(state, buffer, glyph) == raw.size());
+        for (std::size_t offset = 0; offset <= raw.size(); offset++) {
+            if (offset < raw.size() && utf8::isContinuation(static_cast<unsigned char>(raw[offset]))) continue;
+            CHECK(rawOffsetOfDisplayGlyph(state, buffer, displayGlyphIndex(state, buffer, offset)) == offset);
+        }
+    }
+}
+
+// --- EditJournal -------------------------------------------------------------
+
+std::string readFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string& path, const std::string& contents) {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << contents;
+}
+
+// Journals live in a scratch HOME so untitled ones don't touch the user's
+struct ScratchDir {
+    std::filesystem::path path;
+
+    ScratchDir() {
+        path = std::filesystem::temp_directory_path() / "editor_core_tests";
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+        setenv("HOME", path.c_str(), 1);
+    }
+    ~ScratchDir() {
+        std::error_code ignored;
+        std::filesystem::remove_all(path, ignored);
+    }
+};
+
+// Sets a file's mtime to a fixed second plus `nanoseconds`
+void setModifiedTime(const std::string& path, long nanoseconds) {
+    timespec times[2] = {{0, UTIME_OMIT}, {1700000000, nanoseconds}};
+    utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+// Random inserts and deletes, applied to both `buffer` and `model`
+void editRandomly(std::mt19937& rng, GapBuffer& buffer, std::string& model, int count) {
+    for (int i = 0; i < count; i++) {
+        std::size_t at = rng() % (model.size() + 1);
+        if (rng() % 3 == 0 && at < model.size()) {
+            std::size_t end = std::min(model.size(), at + 1 + rng() % 50);
+            buffer.deleteRange(at, end);
+            model.erase(at, end - at);
+        } else {
+            std::string text = randomText(rng, 1 + rng() % 20);
+            buffer.moveTo(at);
+            buffer.insertString(text);
+            model.insert(at, text);
+        }
+    }
+}
+
+void testJournalRecovery() {
+    ScratchDir scratch;
+    std::mt19937 rng(4);
+
+    // A file's journal replays on top of the file as it is on disk
+    std::string path = (scratch.path / "document.txt").string();
+    std::string onDisk = randomText(rng, 10000);
+    writeFile(path, onDisk);
+    std::string model = onDisk;
+    {
+        GapBuffer buffer;
+        buffer.insertString(onDisk);
+        EditJournal journal;
+        journal.begin(path, buffer, true);
+        buffer.setEditObserver([&](const GapBuffer::Edit& edit) { journal.record(edit); });
+        editRandomly(rng, buffer, model, 100);
+        journal.flush();
+
+        // Not while the journal is in use
+        GapBuffer recovered;
+        recovered.insertString(onDisk);
+        CHECK(!EditJournal::recover(path, recovered));
+        CHECK(recovered.getString() == onDisk);
+    }
+    GapBuffer recovered;
+    recovered.insertString(onDisk);
+    CHECK(EditJournal::recover(path, recovered));
+    CHECK(recovered.getString() == model);
+
+    // A torn record at the end is dropped, the rest still replays
+    std::string journalPath = EditJournal::journalPathFor(path);
+    writeFile(journalPath, readFile(journalPath) + "I\x01\x02\x03");
+    GapBuffer torn;
+    torn.insertString(onDisk);
+    CHECK(EditJournal::recover(path, torn));
+    CHECK(torn.getString() == model);
+
+    // A file changed since the journal began is not replayed onto
+    writeFile(path, onDisk + "changed");
+    GapBuffer stale;
+    stale.insertString(onDisk + "changed");
+    CHECK(!EditJournal::recover(path, stale));
+    CHECK(stale.getString() == onDisk + "changed");
+
+    // So is one rewritten to the same size within the same second
+    writeFile(path, onDisk);
+    setModifiedTime(path, 100);
+    {
+        GapBuffer buffer;
+        buffer.insertString(onDisk);
+        EditJournal journal;
+        journal.begin(path, buffer, true);
+        buffer.setEditObserver([&](const GapBuffer::Edit& edit) { journal.record(edit); });
+        buffer.insertString("x");
+        journal.flush();
+    }
+    writeFile(path, std::string(onDisk.size(), 'z'));
+    setModifiedTime(path, 200);
+    GapBuffer rewritten;
+    rewritten.insertString(std::string(onDisk.size(), 'z'));
+    CHECK(!EditJournal::recover(path, rewritten));
+
+    // Untitled documents keep separate journals
+    std::string firstModel;
+    std::string secondModel;
+    {
+        GapBuffer first;
+        GapBuffer second;
+        EditJournal firstJournal;
+        EditJournal secondJournal;
+        CHECK(firstJournal.beginUntitled(1, first));
+        CHECK(secondJournal.beginUntitled(2, second));
+        first.setEditObserver([&](const GapBuffer::Edit& edit) { firstJournal.record(edit); });
+        second.setEditObserver([&](const GapBuffer::Edit& edit) { secondJournal.record(edit); });
+        editRandomly(rng, first, firstModel, 50);
+        editRandomly(rng, second, secondModel, 50);
+        firstJournal.suspend();
+        secondJournal.flush();
+
+        // A new untitled document claims its own id
+        GapBuffer third;
+        EditJournal thirdJournal;
+        CHECK(thirdJournal.beginUntitled(3, third));
+
+        // While they are in use another instance neither lists, recovers
+        // nor claims them, suspended or not
+        CHECK(EditJournal::findUntitledJournals().empty());
+        GapBuffer recovered;
+        CHECK(!EditJournal::recoverUntitled(1, recovered));
+        CHECK(!EditJournal::recoverUntitled(2, recovered));
+        EditJournal otherInstance;
+        CHECK(!otherInstance.beginUntitled(1, recovered));
+        CHECK(!otherInstance.beginUntitled(3, recovered));
+        CHECK(otherInstance.beginUntitled(4, recovered));
+        otherInstance.discard();
+        thirdJournal.discard();
+    }
+
+    // Once their instance is gone they are recovered independently
+    CHECK(EditJournal::findUntitledJournals() == std::vector<unsigned>({1, 2}));
+    GapBuffer untitled;
+    CHECK(EditJournal::recoverUntitled(1, untitled));
+    CHECK(untitled.getString() == firstModel);
+    CHECK(EditJournal::recoverUntitled(2, untitled));
+    CHECK(untitled.getString() == secondModel);
+    CHECK(!EditJournal::recoverUntitled(3, untitled));
+}
+
+// Past the threshold the journal is rewritten as a checkpoint in the
+// background; edits made meanwhile follow it, and the result still recovers
+void testJournalCheckpoint() {
+    ScratchDir scratch;
+    std::mt19937 rng(12);
+    GapBuffer buffer;
+    std::string model;
+    {
+        EditJournal journal;
+        journal.beginUntitled(1, buffer);
+        buffer.setEditObserver([&](const GapBuffer::Edit& edit) { journal.record(edit); });
+
+        // About 5 MB of records that leave the document as it was
+        std::string block(64 * 1024, 'x');
+        for (int i = 0; i < 80; i++) {
+            buffer.moveTo(0);
+            buffer.insertString(block);
+            buffer.deleteRange(0, block.size());
+        }
+        editRandomly(rng, buffer, model, 50);
+        journal.flush();
+        journal.maybeCheckpoint(buffer);
+        editRandomly(rng, buffer, model, 50);
+
+        std::string journalPath = EditJournal::untitledJournalPath(1);
+        const std::uintmax_t small = 1024 * 1024;
+        for (int i = 0; i < 5000 && std::filesystem::file_size(journalPath) > small; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            journal.flush();
+            journal.maybeCheckpoint(buffer);
+        }
+        CHECK(std::filesystem::file_size(journalPath) < small);
+        // The checkpoint took the journal's place locked
+        CHECK(EditJournal::findUntitledJournals().empty());
+
+        editRandomly(rng, buffer, model, 50);
+        journal.flush();
+    }
+
+    GapBuffer recovered;
+    CHECK(EditJournal::recoverUntitled(1, recovered));
+    CHECK(recovered.getString() == model);
+}
+
+// --- AsyncFileSaver ----------------------------------------------------------
+
+// Saving through a symlink replaces its target and keeps the target's mode,
+// and whatever already sits at the old fixed temp name is left alone
+void testWriteSnapshot() {
+    ScratchDir scratch;
+    namespace fs = std::filesystem;
+    fs::path target = scratch.path / "target.txt";
+    fs::path link = scratch.path / "link.txt";
+    fs::path victim = scratch.path / "victim.txt";
+    writeFile(target.string(), "old");
+    fs::permissions(target, fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read);
+    fs::create_symlink("target.txt", link);
+    writeFile(victim.string(), "keep");
+    fs::create_symlink("victim.txt", scratch.path / "target.txt.tmp");
+
+    std::mt19937 rng(11);
+    std::string model = randomText(rng, 5000);
+    GapBuffer buffer;
+    buffer.insertString(model);
+    buffer.moveTo(model.size() / 2);
+    CHECK(AsyncFileSaver::writeSnapshot(link.string(), buffer.snapshot()));
+
+    CHECK(fs::is_symlink(link));
+    CHECK(readFile(target.string()) == model);
+    CHECK((fs::status(target).permissions() & fs::perms::all) ==
+          (fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read));
+    CHECK(readFile(victim.string()) == "keep");
+    CHECK(std::distance(fs::directory_iterator(scratch.path), fs::directory_iterator()) == 4);
+}
+
+// --- Multi-cursor ------------------------------------------------------------
+
+// Every cursor's position, the gap included, in document order
+std::vector<std::size_t> caretPositions(const GapBuffer& buffer, const std::vector<Caret>& carets) {
+    std::vector<std::size_t> positions{buffer.getGapStart()};
+    for (const Caret& caret : carets) positions.push_back(caret.position);
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+// A selection over 2..10 with carets inside it at 3 and 5 is one edit
+void testCaretsInsideSelection() {
+    GapBuffer buffer;
+    buffer.insertString("0123456789abcdef");
+    buffer.moveTo(10);
+    int selectionAnchor = 2;
+    std::vector<Caret> carets;
+    addCaret(buffer, selectionAnchor, carets, 3);
+    addCaret(buffer, selectionAnchor, carets, 5);
+    insertAtCarets(buffer, selectionAnchor, carets, "X");
+    CHECK(buffer.getString() == "01Xabcdef");
+    CHECK(buffer.getGapStart() == 3);
+    CHECK(carets.empty());
+    CHECK(selectionAnchor == -1);
+}
+
+// Typing at random cursors and selections matches replacing the union of
+// their ranges in a string, with a cursor left after each replacement
+void testCaretsRandom() {
+    std::mt19937 rng(8);
+    for (int round = 0; round < 500; round++) {
+        std::string model;
+        for (std::size_t i = 0, len = 1 + rng() % 60; i < len; i++) {
+            model += static_cast<char>('a' + rng() % 26);
+        }
+        GapBuffer buffer;
+        buffer.insertString(model);
+        std::vector<Caret> all;
+        for (std::size_t i = 0, count = 1 + rng() % 6; i < count; i++) {
+            Caret caret;
+            caret.position = rng() % (model.size() + 1);
+            if (rng() % 2) caret.anchor = static_cast<int>(rng() % (model.size() + 1));
+            all.push_back(caret);
+        }
+        int selectionAnchor = -1;
+        std::vector<Caret> carets;
+        setCarets(buffer, selectionAnchor, carets, all);
+
+        // The model: the cursors' ranges, merged where they meet
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+        std::vector<Caret> cursors = carets;
+        cursors.push_back({buffer.getGapStart(), selectionAnchor});
+        for (const Caret& caret : cursors) {
+            std::size_t anchor = caret.anchor == -1 ? caret.position : static_cast<std::size_t>(caret.anchor);
+            ranges.push_back({std::min(anchor, caret.position), std::max(anchor, caret.position)});
+        }
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<std::pair<std::size_t, std::size_t>> merged;
+        for (const auto& range : ranges) {
+            if (!merged.empty() && range.first <= merged.back().second) {
+                merged.back().second = std::max(merged.back().second, range.second);
+            } else {
+                merged.push_back(range);
+            }
+        }
+        std::string text = rng() % 4 == 0 ? "" : std::string(1 + rng() % 3, 'X');
+        std::string expected;
+        std::vector<std::size_t> positions;
+        std::size_t copied = 0;
+        for (const auto& range : merged) {
+            expected += model.substr(copied, range.first - copied) + text;
+            positions.push_back(expected.size());
+            copied = range.second;
+        }
+        expected += model.substr(copied);
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+        insertAtCarets(buffer, selectionAnchor, carets, text);
+        CHECK(buffer.getString() == expected);
+        CHECK(caretPositions(buffer, carets) == positions);
+        CHECK(selectionAnchor == -1);
+    }
+}
+
+// --- ColumnSelection ---------------------------------------------------------
+
+// A block over lines of every length: short and empty lines select nothing
+// at their ends, and a corner past the end of the text stops at it
+void testSelectBlock() {
+    GapBuffer buffer;
+    buffer.insertString("abcdef\nab\n\nabcdefgh");
+    int selectionAnchor = -1;
+    std::vector<Caret> carets;
+    selectBlock(buffer, selectionAnchor, carets, 2, 16);   // columns 2..5, lines 0..3
+    CHECK(carets.size() == 3);
+    CHECK(selectedTextAtCarets(buffer, selectionAnchor, carets) == "cde\n\n\ncde");
+
+    selectBlock(buffer, selectionAnchor, carets, 1, buffer.size() + 10);
+    CHECK(selectedTextAtCarets(buffer, selectionAnchor, carets) == "bcdef\nb\n\nbcdefgh");
+
+    insertAtCarets(buffer, selectionAnchor, carets, "-");
+    CHECK(buffer.getString() == "a-\na-\n-\na-");
+}
+
+// On wrapped text the block's corners come from display glyphs, which count
+// the soft breaks' '\n's; the block is still taken in raw columns
+void testSelectBlockWrapped() {
+    std::string raw = "aaaa bbbb\ncc dd eeee";
+    MonospaceWidthProvider widths;
+    DisplayState state = wrapLayout(raw, 0, widths, 5.f);
+    CHECK(state.content == "aaaa \nbbbb\ncc \ndd \neeee");
+
+    GapBuffer buffer;
+    buffer.insertString(raw);
+    CHECK(rawOffsetOfDisplayGlyph(state, buffer, 5) == 5);    // the soft break's '\n'
+    CHECK(rawOffsetOfDisplayGlyph(state, buffer, 6) == 5);    // first 'b'
+    int selectionAnchor = -1;
+    std::vector<Caret> carets;
+    selectBlock(buffer, selectionAnchor, carets, rawOffsetOfDisplayGlyph(state, buffer, 1),
+                rawOffsetOfDisplayGlyph(state, buffer, 17));   // after "dd"
+    CHECK(selectedTextAtCarets(buffer, selectionAnchor, carets) == "aaa \nc dd");
+}
+
+// Column paste pads short lines with spaces and adds lines past the end
+void testPasteColumn() {
+    GapBuffer buffer;
+    buffer.insertString("abcdef\nab\n\nabcd");
+    buffer.moveTo(4);
+    int selectionAnchor = -1;
+    std::vector<Caret> carets;
+    pasteColumn(buffer, selectionAnchor, carets, "11\n22\n33\n44\n55");
+    CHECK(buffer.getString() == "abcd11ef\nab  22\n    33\nabcd44\n    55");
+    CHECK(caretPositions(buffer, carets).size() == 5);
+    CHECK(caretPositions(buffer, carets).front() == 6);
+    CHECK(caretPositions(buffer, carets).back() == buffer.size());
+}
+
+// --- SyntaxHighlighter -------------------------------------------------------
+
+// Runs kept up to date through noteEdit and update() match tokenizing every
+// line from scratch, over random edits that open and close block comments
+void testHighlighterIncremental() {
+    static const char* const pieces[] = {"/*", "*/", "\"", "//", "\n", "int ", "x", " ", "#define ", "42", "'"};
+    std::mt19937 rng(9);
+    for (int round = 0; round < 100; round++) {
+        GapBuffer buffer;
+        SyntaxHighlighter highlighter;
+        highlighter.setLanguage(Language::Cpp);
+        buffer.setEditObserver([&](const GapBuffer::Edit& edit) { highlighter.noteEdit(buffer, edit); });
+
+        for (int edit = 0; edit < 40; edit++) {
+            std::size_t at = rng() % (buffer.size() + 1);
+            if (rng() % 3 == 0 && at < buffer.size()) {
+                buffer.deleteRange(at, std::min(buffer.size(), at + 1 + rng() % 6));
+            } else {
+                std::string text;
+                for (std::size_t i = 0, count = 1 + rng() % 4; i < count; i++) {
+                    text += pieces[rng() % (sizeof(pieces) / sizeof(pieces[0]))];
+                }
+                buffer.moveTo(at);
+                buffer.insertString(text);
+            }
+
+            std::string model = buffer.getString();
+            std::size_t lines = countTextScalar(model).newlines + 1;
+            std::size_t lastLine = rng() % 2 ? lines - 1 : rng() % lines;
+            highlighter.update(buffer, lastLine);
+
+            LineState state = 0;
+            std::vector<TokenRun> expected;
+            std::size_t lineBegin = 0;
+            for (std::size_t line = 0; line <= lastLine; line++) {
+                std::size_t lineEnd = std::min(model.find('\n', lineBegin), model.size());
+                expected.clear();
+                state = tokenizeLine(Language::Cpp, std::string_view(model).substr(lineBegin, lineEnd - lineBegin),
+                                     state, expected);
+                const std::vector<TokenRun>& runs = highlighter.runsOf(line);
+                CHECK(runs.size() == expected.size());
+                for (std::size_t i = 0; i < runs.size(); i++) {
+                    CHECK(runs[i].start == expected[i].start && runs[i].length == expected[i].length &&
+                          runs[i].kind == expected[i].kind);
+                }
+                lineBegin = lineEnd + 1;
+            }
+        }
+    }
+}
+
+struct Test {
+    const char* name;
+    void (*run)();
+};
+
+const Test TESTS[] = {
+    {"utf8.round_trip", testUtf8},
+    {"gap_buffer.code_points", testCodePointIndex},
+    {"gap_buffer.append", testAppend},
+    {"chunk_index.ranges", testChunkIndexRanges},
+    {"gap_buffer.apply_edits", testApplyEdits},
+    {"text_metrics.simd_parity", testCountTextParity},
+    {"wrap_layout.monospace", testWrapLayout},
+    {"wrap_layout.glyph_offsets", testDisplayGlyphOffsets},
+    {"journal.recovery", testJournalRecovery},
+    {"journal.checkpoint", testJournalCheckpoint},
+    {"saver.write_snapshot", testWriteSnapshot},
+    {"multi_cursor.inside_selection", testCaretsInsideSelection},
+    {"multi_cursor.random", testCaretsRandom},
+    {"column.select_block", testSelectBlock},
+    {"column.select_wrapped", testSelectBlockWrapped},
+    {"column.paste", testPasteColumn},
+    {"highlighter.incremental", testHighlighterIncremental},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else {
+            std::fprintf(stderr, "usage: editor_core_tests [--filter=name]\n");
+            return 2;
+        }
+    }
+
+    int failed = 0;
+    for (const Test& test : TESTS) {
+        if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos) continue;
+        int before = failures;
+        test.run();
+        bool ok = failures == before;
+        std::printf("%-28s %s\n", test.name, ok ? "ok" : "FAILED");
+        failed += ok ? 0 : 1;
+    }
+    return failed == 0 ? 0 : 1;
+}
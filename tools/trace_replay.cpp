@@ -0,0 +1,231 @@
+//
+// trace_replay.cpp - Replays a recorded input trace against the editor core
+//
+// Each event is applied to a GapBuffer the way the window applies it, followed
+// by the re-wrap a frame would do, and the time for both is recorded. Events
+// run back to back, so results do not depend on the recording's pacing.
+//
+//   trace_replay <trace> [--file=document] [--cell-width=12] [--budget-ms=N] [--csv]
+//
+// With --budget-ms the exit status is 1 when the p99 latency is over budget.
+//
+// Glyphs are measured as fixed-width cells. Mouse events need real glyph
+// geometry and are skipped.
+//
+
+#include "EditCommands.h"
+#include "FileOperations.h"
+#include "InputTrace.h"
+#include "LatencyTracker.h"
+#include "TextSearch.h"
+#include "Utf8.h"
+#include "WrapLayout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Session {
+    GapBuffer buffer;
+    int selectionAnchor = -1;
+    std::string clipboard;
+    bool searching = false;
+    std::string query;
+    std::vector<std::size_t> matches;
+
+    float windowWidth = 800.f; // the editor's initial window
+    DisplayState layout;
+    std::size_t layoutVersion = static_cast<std::size_t>(-1);
+    float layoutWidth = -1.f;
+};
+
+// Same column on the previous or next visual line, in code points
+void moveVertical(Session& session, bool down) {
+    const std::vector<std::size_t>& starts = session.layout.lineStarts;
+    GapBuffer& buffer = session.buffer;
+    std::size_t cursor = buffer.getGapStart();
+
+    auto line = static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), cursor) - starts.begin()) - 1;
+    if ((!down && line == 0) || (down && line + 1 >= starts.size())) return;
+    std::size_t column = buffer.codePointIndex(cursor) - buffer.codePointIndex(starts[line]);
+
+    std::size_t target = down ? line + 1 : line - 1;
+    std::size_t end = target + 1 < starts.size() ? starts[target + 1] : buffer.size();
+    // A hard line break belongs to the line it ends
+    if (target + 1 < starts.size() && end > starts[target] && buffer.getChar(end - 1) == '\n') {
+        end--;
+    }
+    std::size_t first = buffer.codePointIndex(starts[target]);
+    std::size_t last = buffer.codePointIndex(end);
+    buffer.moveTo(buffer.byteOffsetOfCodePoint(std::min(first + column, last)));
+    session.selectionAnchor = -1;
+}
+
+// False for events headless replay cannot reproduce
+bool apply(Session& session, const TraceEvent& event) {
+    GapBuffer& buffer = session.buffer;
+    bool ctrlOrCmd = event.modifiers & (TraceEvent::Control | TraceEvent::System);
+    bool shift = event.modifiers & TraceEvent::Shift;
+
+    switch (event.type) {
+        case TraceEvent::Resized:
+            session.windowWidth = static_cast<float>(event.x);
+            return true;
+
+        case TraceEvent::TextEntered: {
+            char32_t cp = static_cast<char32_t>(event.code);
+            if (cp == '\b' || cp == 127) return true;
+            if (session.searching) {
+                if (cp < 128 && cp != 27) {
+                    session.query += static_cast<char>(cp);
+                    session.matches = findAllMatches(buffer.getString(), session.query);
+                }
+                return true;
+            }
+            insertAtCursor(buffer, session.selectionAnchor, utf8::encode(cp));
+            return true;
+        }
+
+        case TraceEvent::KeyPressed:
+            if (session.searching) {
+                if (event.code == tracekey::Escape) {
+                    session.searching = false;
+                } else if (event.code == tracekey::Backspace && !session.query.empty()) {
+                    session.query.pop_back();
+                    session.matches = findAllMatches(buffer.getString(), session.query);
+                }
+                return true;
+            }
+            if (ctrlOrCmd) {
+                switch (event.code) {
+                    case tracekey::A: selectAll(buffer, session.selectionAnchor); break;
+                    case tracekey::C: session.clipboard = selectedText(buffer, session.selectionAnchor); break;
+                    case tracekey::X:
+                        session.clipboard = selectedText(buffer, session.selectionAnchor);
+                        deleteSelection(buffer, session.selectionAnchor);
+                        break;
+                    case tracekey::V:
+                        if (!session.clipboard.empty()) {
+                            insertAtCursor(buffer, session.selectionAnchor, session.clipboard);
+                        }
+                        break;
+                    case tracekey::F:
+                        session.searching = true;
+                        session.matches = findAllMatches(buffer.getString(), session.query);
+                        break;
+                    default: break;
+                }
+                return true;
+            }
+            switch (event.code) {
+                case tracekey::Left: moveHorizontal(buffer, session.selectionAnchor, false, shift); break;
+                case tracekey::Right: moveHorizontal(buffer, session.selectionAnchor, true, shift); break;
+                case tracekey::Up: moveVertical(session, false); break;
+                case tracekey::Down: moveVertical(session, true); break;
+                case tracekey::Backspace: deleteBackward(buffer, session.selectionAnchor); break;
+                case tracekey::Delete: deleteForward(buffer, session.selectionAnchor); break;
+                default: break;
+            }
+            return true;
+
+        case TraceEvent::KeyReleased:
+        case TraceEvent::FocusLost:
+        case TraceEvent::Closed:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// The re-wrap the window does before drawing, when its inputs changed
+void relayout(Session& session, const MonospaceWidthProvider& widths) {
+    float width = session.windowWidth - 25.f;
+    if (session.buffer.getVersion() == session.layoutVersion && width == session.layoutWidth) return;
+    session.layout = wrapLayout(session.buffer.getString(), session.buffer.getGapStart(), widths, width);
+    session.layoutVersion = session.buffer.getVersion();
+    session.layoutWidth = width;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string tracePath;
+    std::string documentPath;
+    float cellWidth = 12.f;
+    double budgetMs = 0.0;
+    bool csv = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--file=", 0) == 0) {
+            documentPath = arg.substr(7);
+        } else if (arg.rfind("--cell-width=", 0) == 0) {
+            cellWidth = std::strtof(arg.c_str() + 13, nullptr);
+        } else if (arg.rfind("--budget-ms=", 0) == 0) {
+            budgetMs = std::strtod(arg.c_str() + 12, nullptr);
+        } else if (arg == "--csv") {
+            csv = true;
+        } else if (tracePath.empty() && arg.rfind("--", 0) != 0) {
+            tracePath = arg;
+        } else {
+            tracePath.clear();
+            break;
+        }
+    }
+    if (tracePath.empty() || cellWidth <= 0.f) {
+        std::fprintf(stderr, "usage: %s <trace> [--file=document] [--cell-width=12] [--budget-ms=N] [--csv]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<TraceEvent> events;
+    if (!readInputTrace(tracePath, events)) {
+        std::fprintf(stderr, "Could not read trace %s\n", tracePath.c_str());
+        return 1;
+    }
+
+    Session session;
+    if (!documentPath.empty() && !loadFileIntoBuffer(documentPath, session.buffer)) {
+        std::fprintf(stderr, "Could not read %s\n", documentPath.c_str());
+        return 1;
+    }
+    session.buffer.moveTo(0);
+
+    MonospaceWidthProvider widths(cellWidth);
+    relayout(session, widths);
+
+    std::vector<double> latenciesUs;
+    latenciesUs.reserve(events.size());
+    std::size_t skipped = 0;
+    for (const TraceEvent& event : events) {
+        auto start = std::chrono::steady_clock::now();
+        if (!apply(session, event)) {
+            skipped++;
+            continue;
+        }
+        relayout(session, widths);
+        auto stop = std::chrono::steady_clock::now();
+        latenciesUs.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+
+    LatencySummary summary = summarizeLatencies(latenciesUs);
+    if (csv) {
+        std::printf("events,skipped,p50_us,p99_us,max_us,document_bytes\n");
+        std::printf("%zu,%zu,%.1f,%.1f,%.1f,%zu\n", summary.count, skipped, summary.p50Us, summary.p99Us,
+                    summary.maxUs, session.buffer.size());
+    } else {
+        std::printf("%zu events replayed (%zu mouse events skipped), document now %zu bytes\n",
+                    summary.count, skipped, session.buffer.size());
+        std::printf("p50 %.1f us   p99 %.1f us   max %.1f us\n", summary.p50Us, summary.p99Us, summary.maxUs);
+    }
+
+    if (budgetMs > 0.0 && summary.p99Us > budgetMs * 1000.0) {
+        std::fprintf(stderr, "p99 %.1f us is over the %.1f ms budget\n", summary.p99Us, budgetMs);
+        return 1;
+    }
+    return 0;
+}